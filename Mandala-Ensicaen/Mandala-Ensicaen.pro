@@ -6,7 +6,7 @@
 
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent network
 
 TARGET = Mandala-Ensicaen
 TEMPLATE = app
@@ -16,12 +16,66 @@ TEMPLATE = app
 SOURCES += src/main.cpp\
     src/myQGraphicsView.cpp \
     src/widgetDrawLineWidth.cpp \
-    src/mainWindow.cpp
+    src/mainWindow.cpp \
+    src/tiledRaster.cpp \
+    src/mandalaRasterizer.cpp \
+    src/layerStack.cpp \
+    src/mandalaGenerator.cpp \
+    src/generatorPanel.cpp \
+    src/thumbnailModel.cpp \
+    src/galleryPanel.cpp \
+    src/strokeJournal.cpp \
+    src/resourceCache.cpp \
+    src/startupTimer.cpp \
+    src/colorEngine.cpp \
+    src/symmetryEngine.cpp \
+    src/symmetryPanel.cpp \
+    src/tileExporter.cpp \
+    src/memoryBudget.cpp \
+    src/historySnapshot.cpp \
+    src/strokeStabilizer.cpp \
+    src/latencyMeter.cpp \
+    src/stabilizerPanel.cpp \
+    src/mandalaScript.cpp \
+    src/strokeDocument.cpp \
+    src/renderServer.cpp \
+    src/strokeInstanceItem.cpp \
+    src/collabSession.cpp \
+    src/imageExporter.cpp \
+    src/idleMonitor.cpp \
+    src/renderVerifier.cpp
 
 HEADERS  += \
     include/myQGraphicsView.h \
     include/mainWindow.h \
-    include/widgetDrawLineWidth.h
+    include/widgetDrawLineWidth.h \
+    include/tiledRaster.h \
+    include/mandalaRasterizer.h \
+    include/layerStack.h \
+    include/mandalaGenerator.h \
+    include/generatorPanel.h \
+    include/thumbnailModel.h \
+    include/galleryPanel.h \
+    include/strokeJournal.h \
+    include/resourceCache.h \
+    include/startupTimer.h \
+    include/colorEngine.h \
+    include/symmetryEngine.h \
+    include/symmetryPanel.h \
+    include/tileExporter.h \
+    include/memoryBudget.h \
+    include/historySnapshot.h \
+    include/strokeStabilizer.h \
+    include/latencyMeter.h \
+    include/stabilizerPanel.h \
+    include/mandalaScript.h \
+    include/strokeDocument.h \
+    include/renderServer.h \
+    include/strokeInstanceItem.h \
+    include/collabSession.h \
+    include/imageExporter.h \
+    include/idleMonitor.h \
+    include/renderVerifier.h
 
 FORMS    += ui/mainwindow.ui
 
@@ -0,0 +1,267 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   collabSession.h
+ * @date   October 2026
+ *
+ * @brief  collabSession lets several instances of the application draw on one mandala: a relay server orders the messages of the clients and
+ * forwards them, and each client sends the points of its strokes as compact deltas batched per frame. The symmetry copies are never sent:
+ * every client projects the strokes it receives with its own symmetry
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef COLLABSESSION_H
+#define COLLABSESSION_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QObject>
+#include <QPoint>
+#include <QPointF>
+#include <QRgb>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+class QTcpServer;
+class QTcpSocket;
+
+// CollabStroke is what a client needs to draw the stroke of another one: its layer, pen width and color, its number for the StrokeCycle palette,
+// and if it follows the symmetry (drawn in mandala mode)
+struct CollabStroke {
+    int layer;
+    int penWidth;
+    QRgb color;
+    int colorStroke;
+    bool symmetric;
+};
+
+class CollabServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // A frame is its size (16 bits), its type and its content. The server adds the sequence number and the client number to the frames it relays:
+    // every client gets the messages in the same order, and a stroke only ever has one writer, so the clients never have to merge anything
+    enum MessageType { Hello = 1, Welcome, StrokeBegin, StrokePoints, StrokeEnd };
+
+    // DefaultPort is the port of the sessions, MaxFrameBytes the largest frame
+    static const quint16 DefaultPort;
+    static const int MaxFrameBytes;
+
+    explicit CollabServer(QObject *parent = nullptr);
+
+    /**
+     * @brief Start listening
+     * @param The address (QHostAddress::LocalHost for a session on this host only, QHostAddress::Any for the LAN)
+     * @param The port (0: any free port)
+     * @return True if the server listens, else the error is given by errorString()
+     *
+     */
+    bool listen(const QHostAddress &, quint16);
+
+    /**
+     * @brief Let us get the error of the last listen()
+     * @return The error message
+     *
+     */
+    QString errorString() const;
+
+    /**
+     * @brief Let us get the port the server listens on
+     * @return The port
+     *
+     */
+    quint16 port() const;
+
+    /**
+     * @brief Let us get the counters of the session: clients, frames and bytes relayed, size of the log replayed to the clients joining
+     * @return The counters
+     *
+     */
+    QJsonObject stats() const;
+
+private:
+    QTcpServer * _server;
+    QString _error;
+
+    // _clients are the numbers of the clients that said hello, _pending the bytes of each client not framed yet
+    QHash<QTcpSocket *, quint32> _clients;
+    QHash<QTcpSocket *, QByteArray> _pending;
+    quint32 _nextClient = 1;
+    quint32 _sequence = 0;
+
+    // _openStrokes are the strokes the clients are drawing
+    QHash<QTcpSocket *, quint32> _openStrokes;
+
+    // _log holds the relayed frames: a client joining the session gets the drawing done before it came
+    QByteArray _log;
+
+    qint64 _framesRelayed = 0;
+    qint64 _bytesReceived = 0;
+    qint64 _bytesSent = 0;
+
+    /**
+     * @brief Handle a frame of a client: the hello is answered, the stroke messages are numbered and relayed to the other clients
+     * @param The client
+     * @param The frame type
+     * @param The frame content
+     * @return False if the frame isn't one of ours (the client is dropped)
+     *
+     */
+    bool handleFrame(QTcpSocket *, int, const QByteArray &);
+
+    /**
+     * @brief Number a message of a client and send it to the other clients (and to the log)
+     * @param The client
+     * @param The message type
+     * @param The message content
+     *
+     */
+    void relay(QTcpSocket *, int, const QByteArray &);
+
+private slots:
+    void newConnection();
+    void readClient();
+    void clientDisconnected();
+};
+
+class CollabSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    // FrameInterval is the time (in milliseconds) during which the points are batched, PointQuantum the number of steps per pixel of the sent points
+    static const int FrameInterval;
+    static const int PointQuantum;
+    // MinPenWidth and MaxPenWidth are the pen widths of the line width slider: a stroke of another width didn't come from one of ours
+    static const int MinPenWidth;
+    static const int MaxPenWidth;
+
+    explicit CollabSession(QObject *parent = nullptr);
+
+    /**
+     * @brief Join a session
+     * @param The host of the server
+     * @param The port of the server
+     *
+     */
+    void connectToHost(const QString &, quint16);
+
+    /**
+     * @brief Leave the session (the frame being batched is sent first)
+     *
+     */
+    void disconnectFromHost();
+
+    /**
+     * @brief Let us know if we joined a session (the server welcomed us)
+     * @return True if we are in a session
+     *
+     */
+    bool isConnected() const;
+
+    /**
+     * @brief Let us get our number in the session
+     * @return The client number (0 before the server welcomed us)
+     *
+     */
+    quint32 clientId() const;
+
+    /**
+     * @brief Let us get the bytes we sent and received since we joined (frames and TCP payload, without the TCP/IP headers)
+     * @return The bytes
+     *
+     */
+    qint64 bytesSent() const;
+    qint64 bytesReceived() const;
+
+    /**
+     * @brief Send the points of a stroke drawn on screens at a given rate for a given time to the other clients of a new loopback session,
+     * each one projecting them with a symmetry of a given slice count: the report gives the bandwidth of each client and checks that they all got the stroke
+     * @param The number of clients (the first one draws)
+     * @param The number of slices of the symmetry of the clients
+     * @param The time (in milliseconds) the first client draws
+     * @return A report line per client
+     *
+     */
+    static QStringList runLoopback(int, int, int);
+
+public slots:
+    /**
+     * @brief Start a stroke: it is sent with the next frame
+     * @param The stroke
+     * @param Its first point (in scene coordinates)
+     *
+     */
+    void beginStroke(CollabStroke, QPointF);
+
+    /**
+     * @brief Add points to the stroke: they are sent as deltas with the next frame
+     * @param The points
+     *
+     */
+    void addPoints(const QVector<QPointF> &);
+
+    /**
+     * @brief Finish the stroke
+     *
+     */
+    void endStroke();
+
+signals:
+    void joined(quint32);
+    void left(QString);
+
+    // The strokes of the other clients: a stroke is known by the client number (high 32 bits) and the stroke number of the client (low 32 bits)
+    void remoteStrokeBegan(quint64, CollabStroke, QPointF);
+    void remoteStrokePoints(quint64, QVector<QPointF>);
+    void remoteStrokeEnded(quint64);
+
+private:
+    QTcpSocket * _socket;
+    quint32 _clientId = 0;
+    QByteArray _pending;
+
+    // _outgoing is the frame being batched, _frameTimer sends it. _pendingDeltas are the deltas of the stroke not framed yet, from _lastPoint
+    QByteArray _outgoing;
+    QTimer _frameTimer;
+    quint32 _stroke = 0;
+    bool _drawing = false;
+    QPoint _lastPoint;
+    QVector<QPoint> _pendingDeltas;
+
+    // _remotePoints are the last points of the strokes of the other clients (the deltas are added to them)
+    QHash<quint64, QPoint> _remotePoints;
+    quint32 _lastSequence = 0;
+
+    qint64 _bytesSent = 0;
+    qint64 _bytesReceived = 0;
+
+    /**
+     * @brief Append the pending deltas of the stroke to the batched frame
+     *
+     */
+    void framePoints();
+
+    /**
+     * @brief Handle a frame relayed by the server
+     * @param The frame type
+     * @param The frame content
+     * @return False if the frame isn't one of ours (we leave the session)
+     *
+     */
+    bool handleFrame(int, const QByteArray &);
+
+private slots:
+    void sendFrame();
+    void socketConnected();
+    void readServer();
+    void socketDisconnected();
+    void socketError();
+};
+
+#endif // COLLABSESSION_H
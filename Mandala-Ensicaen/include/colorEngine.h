@@ -0,0 +1,140 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   colorEngine.h
+ * @date   October 2026
+ *
+ * @brief  colorEngine gives the colors of the rainbow mode: a palette (HSV wheel, gradient, per stroke cycle or radial) is precomputed in a lookup table
+ * each time its settings change, so that the color of a drawn segment is an index in a flat array
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef COLORENGINE_H
+#define COLORENGINE_H
+
+#include <QColor>
+#include <QGradient>
+#include <QVector>
+
+class ColorEngine
+{
+public:
+    // Palette defines how the colors are chosen:
+    // HsvWheel turns the hue of the pen color evenly around the copies, Gradient samples the gradient stops around the copies,
+    // StrokeCycle gives each stroke the next hue of the wheel, and Radial samples the gradient stops by the distance to the symmetry center
+    enum Palette { HsvWheel, Gradient, StrokeCycle, Radial };
+
+    // StrokeCycleLength is the number of hues StrokeCycle goes through, RadialSteps the number of colors between the center and the radius
+    static const int StrokeCycleLength;
+    static const int RadialSteps;
+
+    ColorEngine();
+
+    /**
+     * @brief Set the palette
+     * @param The palette
+     *
+     */
+    void setPalette(Palette);
+
+    /**
+     * @brief Let us know which palette is used
+     * @return The palette
+     *
+     */
+    Palette palette() const;
+
+    /**
+     * @brief Set the pen color: the HSV wheel and the stroke cycle start from its hue
+     * @param The pen color
+     *
+     */
+    void setBaseColor(QColor);
+
+    /**
+     * @brief Set the number of colors of the symmetrical copies of a line (the slices, or the operations of a wallpaper group)
+     * @param The number of colors
+     *
+     */
+    void setCopyCount(int);
+
+    /**
+     * @brief Set the stops of the Gradient and Radial palettes
+     * @param The gradient stops (positions between 0 and 1)
+     *
+     */
+    void setGradientStops(const QGradientStops &);
+
+    /**
+     * @brief Let us get the stops of the Gradient and Radial palettes
+     * @return The gradient stops
+     *
+     */
+    QGradientStops gradientStops() const;
+
+    /**
+     * @brief Set the distance to the symmetry center at which the Radial palette reaches its last color
+     * @param The radius
+     *
+     */
+    void setRadius(double);
+
+    /**
+     * @brief Start a new stroke: StrokeCycle goes to its next color
+     *
+     */
+    void nextStroke();
+
+    /**
+     * @brief Set the number of the current stroke (a stroke colored again gets back its StrokeCycle color)
+     * @param The stroke number
+     *
+     */
+    void setStroke(int);
+
+    /**
+     * @brief Let us get the number of the current stroke
+     * @return The stroke number
+     *
+     */
+    int stroke() const;
+
+    /**
+     * @brief Let us get the color of a segment: it only reads the lookup table
+     * @param The index of the symmetrical copy (0 is the drawn line)
+     * @param The distance between the segment and the symmetry center
+     * @return The color
+     *
+     */
+    QRgb color(int, double) const;
+
+    /**
+     * @brief Interpolate gradient stops
+     * @param The gradient stops
+     * @param The position between 0 and 1
+     * @return The color at the position
+     *
+     */
+    static QRgb gradientColor(const QGradientStops &, double);
+
+private:
+    Palette _palette = HsvWheel;
+    QColor _baseColor = Qt::white;
+    int _copyCount = 0;
+    QGradientStops _gradientStops;
+    double _radius = 1;
+    int _stroke = 0;
+
+    // _lookupTable holds the colors of the palette, _radialScale turns a distance into an index of the Radial lookup table
+    QVector<QRgb> _lookupTable;
+    double _radialScale = 0;
+
+    /**
+     * @brief Precompute the lookup table of the palette
+     *
+     */
+    void rebuild();
+};
+
+#endif // COLORENGINE_H
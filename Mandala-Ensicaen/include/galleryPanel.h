@@ -0,0 +1,51 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   galleryPanel.h
+ * @date   October 2026
+ *
+ * @brief  galleryPanel is the dock panel that shows the thumbnails of the mandalas of a folder: a double click opens a mandala in the painting widget
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef GALLERYPANEL_H
+#define GALLERYPANEL_H
+
+#include <QDockWidget>
+
+class QLabel;
+class QListView;
+class QModelIndex;
+class ThumbnailModel;
+
+class GalleryPanel : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit GalleryPanel(QWidget *parent = nullptr);
+
+    /**
+     * @brief Show the mandalas of a folder (the folder is remembered for the next run)
+     * @param The folder path
+     *
+     */
+    void setFolder(const QString &);
+
+private:
+    QLabel * _folderLabel;
+    QListView * _listView;
+    ThumbnailModel * _model;
+    bool _lastFolderLoaded = false;
+
+signals:
+    void imageActivated(QString);
+
+private slots:
+    void chooseFolder();
+    void loadLastFolder(bool);
+    void emitImageActivated(const QModelIndex &);
+};
+
+#endif // GALLERYPANEL_H
@@ -0,0 +1,55 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   generatorPanel.h
+ * @date   October 2026
+ *
+ * @brief  generatorPanel is the dock panel that let the user choose the mandala generator settings (pattern, seed, number of lines and radius)
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef GENERATORPANEL_H
+#define GENERATORPANEL_H
+
+#include <QDockWidget>
+#include "mandalaGenerator.h"
+
+class QComboBox;
+class QSpinBox;
+class QPushButton;
+class QLabel;
+
+class GeneratorPanel : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit GeneratorPanel(QWidget *parent = nullptr);
+
+    /**
+     * @brief Show the result of the last generation
+     * @param The fingerprint of the generated lines
+     * @param The number of generated lines
+     * @param The generation and drawing time in milliseconds
+     *
+     */
+    void showResult(const QByteArray &, int, qint64);
+
+private:
+    QComboBox * _patternComboBox;
+    QSpinBox * _seedSpinBox;
+    QSpinBox * _segmentsSpinBox;
+    QSpinBox * _radiusSpinBox;
+    QPushButton * _generateButton;
+    QLabel * _resultLabel;
+
+signals:
+    void generateRequested(GeneratorSettings);
+
+private slots:
+    void emitGenerateRequested();
+    void randomizeSeed();
+};
+
+#endif // GENERATORPANEL_H
@@ -0,0 +1,85 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   historySnapshot.h
+ * @date   October 2026
+ *
+ * @brief  historySnapshot is an undo/redo keyframe: the composite image is run-length encoded on a worker thread (a mandala is mostly flat colors
+ * and transparent areas), and it is only decoded when we undo or redo to it
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef HISTORYSNAPSHOT_H
+#define HISTORYSNAPSHOT_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QSharedPointer>
+#include <QSize>
+#include "strokeDocument.h"
+
+class HistorySnapshot
+{
+public:
+    HistorySnapshot();
+
+    /**
+     * @brief Keep an image in the history: it is compressed in the background, we keep the image itself until then
+     * @param The image (the composite of the content layers, or an opened image)
+     * @param The strokes of the image, to project them again after an undo or a redo (its containers are shared with the current document)
+     *
+     */
+    explicit HistorySnapshot(const QImage &, const StrokeDocument & = StrokeDocument());
+
+    /**
+     * @brief Let us get the image of the snapshot: it is decoded here if it was already compressed
+     * @return The image
+     *
+     */
+    QImage image() const;
+
+    /**
+     * @brief Let us get the strokes of the snapshot
+     * @return The stroke document
+     *
+     */
+    StrokeDocument document() const;
+
+    /**
+     * @brief Let us get the memory used by the snapshot (compressed or not yet)
+     * @return The bytes of the snapshot
+     *
+     */
+    qint64 byteCount() const;
+
+    /**
+     * @brief Let us know if the snapshot holds no image
+     * @return True if the snapshot is null
+     *
+     */
+    bool isNull() const;
+
+    /**
+     * @brief Run-length encode a premultiplied ARGB32 image: a run of the same pixel is one token and one pixel, the other pixels are kept as literals
+     * @param The image
+     * @return The encoded pixels
+     *
+     */
+    static QByteArray compress(const QImage &);
+
+    /**
+     * @brief Decode the pixels encoded by compress()
+     * @param The encoded pixels
+     * @param The image size
+     * @return The image (a null image if the data is corrupted)
+     *
+     */
+    static QImage decompress(const QByteArray &, QSize);
+
+private:
+    struct Data;
+    QSharedPointer<Data> _data;
+};
+
+#endif // HISTORYSNAPSHOT_H
@@ -0,0 +1,49 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   idleMonitor.h
+ * @date   October 2026
+ *
+ * @brief  idleMonitor counts the work of the application while it runs (--wakeup-report): the wakeups of the event loop, the paint, timer and
+ * mouse move events per second. An idle window must show no wakeups and no paints
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef IDLEMONITOR_H
+#define IDLEMONITOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+class IdleMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Start counting: the counters of each period are printed at its end
+     * @param The period in milliseconds
+     *
+     */
+    explicit IdleMonitor(int, QObject *parent = nullptr);
+
+protected:
+    bool eventFilter(QObject *, QEvent *) override;
+
+private:
+    // _reportTimer ends the periods: its own wakeup and timer event are not counted
+    QTimer _reportTimer;
+    QElapsedTimer _clock;
+    qint64 _wakeups = 0;
+    qint64 _paints = 0;
+    qint64 _timers = 0;
+    qint64 _mouseMoves = 0;
+
+private slots:
+    void awake();
+    void report();
+};
+
+#endif // IDLEMONITOR_H
@@ -0,0 +1,143 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   imageExporter.h
+ * @date   October 2026
+ *
+ * @brief  imageExporter saves the drawing in small files: a mandala has few colors, so it is quantized to a palette (exact when it has 256 colors
+ * or less, else median cut or octree) and saved as an indexed PNG with a chosen compression level and filter strategy, or as a JPEG of a chosen quality.
+ * The quantization and the encoding run on worker threads, and every export reports its size and times
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef IMAGEEXPORTER_H
+#define IMAGEEXPORTER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// ImageExportSettings defines how we save an image
+struct ImageExportSettings {
+    enum Palette { FullColor, MedianCut, Octree };
+    enum PngFilter { NoFilter, Sub, Up, Average, Paeth, Adaptive };
+
+    // palette is how the colors are reduced to at most colors (an image with colors or less keeps its exact colors), FullColor keeps them all.
+    // The BMP files are indexed too, the JPEG files are always full color
+    Palette palette = MedianCut;
+    int colors = 256;
+    // pngCompression is the zlib level (0 to 9), pngFilter the filter of the PNG rows (Adaptive picks the best filter of each row)
+    int pngCompression = 9;
+    PngFilter pngFilter = Adaptive;
+    // jpegQuality goes from 0 (smallest) to 100 (best)
+    int jpegQuality = 90;
+};
+
+// ImageExportReport is the result of an export: its format and options, the file size, the colors of the palette (0 for full color)
+// and if they are the exact colors of the image, the times (in milliseconds) of the quantization and the encoding, and the error if it failed
+struct ImageExportReport {
+    QString format;
+    QString options;
+    qint64 bytes = 0;
+    int colors = 0;
+    bool exact = false;
+    double quantizeTime = 0;
+    double encodeTime = 0;
+    QString error;
+
+    /**
+     * @brief Let us get the report as one line
+     * @return The line
+     *
+     */
+    QString toString() const;
+};
+
+class ImageExporter
+{
+public:
+    /**
+     * @brief Find the palette of the colors of an image
+     * @param The image
+     * @param The maximum number of colors
+     * @return The colors of the image, empty if it has more than the maximum
+     *
+     */
+    static QVector<QRgb> exactPalette(const QImage &, int);
+
+    /**
+     * @brief Compute a palette by median cut: the box of colors holding the most pixels times its widest range is cut at its median, until there are enough boxes
+     * @param The image
+     * @param The number of colors
+     * @return The palette (the mean color of each box)
+     *
+     */
+    static QVector<QRgb> medianCutPalette(const QImage &, int);
+
+    /**
+     * @brief Compute a palette with an octree: the colors are inserted in a tree of 5 levels, then the deepest nodes holding the fewest pixels are merged
+     * until there are few enough leaves
+     * @param The image
+     * @param The number of colors
+     * @return The palette (the mean color of each leaf)
+     *
+     */
+    static QVector<QRgb> octreePalette(const QImage &, int);
+
+    /**
+     * @brief Quantize an image: the exact palette if the image has few enough colors, else the palette of the method
+     * @param The image
+     * @param The method (FullColor gives the image back in RGB32)
+     * @param The number of colors
+     * @param True if the palette holds the exact colors of the image (output)
+     * @return The Indexed8 image, each pixel mapped to its nearest palette color
+     *
+     */
+    static QImage quantize(const QImage &, ImageExportSettings::Palette, int, bool &);
+
+    /**
+     * @brief Encode an image as PNG: an Indexed8 image is saved with its palette and the smallest bit depth that holds it, any other image as 8 bits RGB
+     * @param The image
+     * @param The zlib level (0 to 9)
+     * @param The filter of the rows
+     * @return The PNG file content
+     *
+     */
+    static QByteArray encodePng(const QImage &, int, ImageExportSettings::PngFilter);
+
+    /**
+     * @brief Quantize and save an image, with the format given by the file extension (png, bmp, jpg or jpeg)
+     * @param The image
+     * @param The export settings
+     * @param The file name
+     * @return The report of the export
+     *
+     */
+    static ImageExportReport exportImage(const QImage &, const ImageExportSettings &, const QString &);
+
+    /**
+     * @brief Encode an image in memory with each option (palettes, PNG filters and levels, JPEG qualities) to compare their sizes and times
+     * @param The image
+     * @param The number of colors of the palettes
+     * @return A report line per option
+     *
+     */
+    static QStringList compareOptions(const QImage &, int);
+
+private:
+    /**
+     * @brief Quantize and encode an image in memory
+     * @param The image
+     * @param The export settings
+     * @param The format (png, bmp or jpg)
+     * @param The encoded image (output)
+     * @return The report of the export (without its size)
+     *
+     */
+    static ImageExportReport encode(const QImage &, const ImageExportSettings &, const QString &, QByteArray &);
+};
+
+#endif // IMAGEEXPORTER_H
@@ -0,0 +1,73 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   latencyMeter.h
+ * @date   October 2026
+ *
+ * @brief  latencyMeter keeps the last latency samples of the draw path (in milliseconds) and summarizes them: mean and percentiles
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef LATENCYMETER_H
+#define LATENCYMETER_H
+
+#include <QString>
+#include <QVector>
+
+class LatencyMeter
+{
+public:
+    // SampleCount is the number of samples we keep: the oldest samples are overwritten
+    static const int SampleCount = 256;
+
+    LatencyMeter();
+
+    /**
+     * @brief Add a latency sample
+     * @param The latency (in milliseconds)
+     *
+     */
+    void addSample(double);
+
+    /**
+     * @brief Forget all the samples
+     *
+     */
+    void reset();
+
+    /**
+     * @brief Let us know how many samples we have
+     * @return The number of samples
+     *
+     */
+    int count() const;
+
+    /**
+     * @brief Let us get the mean of the samples
+     * @return The mean latency (in milliseconds)
+     *
+     */
+    double mean() const;
+
+    /**
+     * @brief Let us get a percentile of the samples
+     * @param The percentile (between 0 and 100)
+     * @return The latency (in milliseconds)
+     *
+     */
+    double percentile(double) const;
+
+    /**
+     * @brief Let us get a summary of the samples to show to the user
+     * @return The mean, median and 95th percentile
+     *
+     */
+    QString summary() const;
+
+private:
+    QVector<double> _samples;
+    int _next = 0;
+};
+
+#endif // LATENCYMETER_H
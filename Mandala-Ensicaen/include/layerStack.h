@@ -0,0 +1,274 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   layerStack.h
+ * @date   October 2026
+ *
+ * @brief  layerStack defines the layers of a mandala: the background image, any number of stroke layers and the guides overlay (grid slices and mirror lines),
+ * and keeps a cached composite of the content layers that is only redone where a layer changed
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef LAYERSTACK_H
+#define LAYERSTACK_H
+
+#include <QImage>
+#include <QRect>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "tiledRaster.h"
+
+class QPainter;
+
+class MandalaLayer
+{
+public:
+    explicit MandalaLayer(const QString & name = QString());
+
+    /**
+     * @brief Let us get the name of the layer (shown to the user)
+     * @return The name of the layer
+     *
+     */
+    QString name() const;
+
+    /**
+     * @brief Let us know if the layer is shown and composited or not
+     * @return True if the layer is visible, and false if not
+     *
+     */
+    bool isVisible() const;
+
+    /**
+     * @brief Show or hide the layer
+     * @param The boolean letting us know if the layer must be visible
+     *
+     */
+    void setVisible(bool);
+
+    /**
+     * @brief Let us get the cached raster of the layer
+     * @return The raster of the layer
+     *
+     */
+    TiledRaster & raster();
+    const TiledRaster & raster() const;
+
+    /**
+     * @brief Mark a scene rectangle of the layer as changed: the composite will be redone there
+     * @param The changed scene rectangle
+     *
+     */
+    void markDirty(const QRectF &);
+
+    /**
+     * @brief Let us know if the layer changed since the last composite
+     * @return True if the layer is dirty, and false if not
+     *
+     */
+    bool isDirty() const;
+
+    /**
+     * @brief Let us get the scene rectangle that changed since the last composite
+     * @return The dirty scene rectangle
+     *
+     */
+    QRectF dirtyRect() const;
+
+    /**
+     * @brief Mark the layer as composited
+     *
+     */
+    void clearDirty();
+
+    /**
+     * @brief Let us get the revision of the layer: it changes whenever the layer is marked dirty or shown/hidden
+     * @return The revision
+     *
+     */
+    quint64 revision() const;
+
+private:
+    QString _name;
+    bool _visible = true;
+    TiledRaster _raster;
+    QRectF _dirtyRect;
+    quint64 _revision = 0;
+};
+
+class LayerStack
+{
+public:
+    LayerStack();
+
+    /**
+     * @brief Set the scene rectangle of the canvas: the composite covers this rectangle
+     * @param The scene rectangle of the canvas
+     *
+     */
+    void setCanvasRect(const QRect &);
+
+    /**
+     * @brief Let us get the scene rectangle of the canvas
+     * @return The scene rectangle of the canvas
+     *
+     */
+    QRect canvasRect() const;
+
+    /**
+     * @brief Set the device pixel ratio of the layers and of the composite: the rasters are kept at the resolution of the screen
+     * @param The device pixel ratio
+     *
+     */
+    void setScale(qreal);
+
+    /**
+     * @brief Let us get the device pixel ratio of the layers
+     * @return The device pixel ratio
+     *
+     */
+    qreal scale() const;
+
+    /**
+     * @brief Let us get the background layer (opened images and restored undo/redo screenshots)
+     * @return The background layer
+     *
+     */
+    MandalaLayer & background();
+
+    /**
+     * @brief Let us get the guides overlay (grid slices and mirror lines): it is never part of the composite
+     * @return The guides overlay
+     *
+     */
+    MandalaLayer & guides();
+
+    /**
+     * @brief Add a new stroke layer on top of the others
+     * @param The name of the layer
+     * @return The index of the new layer
+     *
+     */
+    int addStrokeLayer(const QString &);
+
+    /**
+     * @brief Remove all the stroke layers
+     *
+     */
+    void removeStrokeLayers();
+
+    /**
+     * @brief Let us know how many stroke layers we have
+     * @return The number of stroke layers
+     *
+     */
+    int strokeLayerCount() const;
+
+    /**
+     * @brief Let us get a stroke layer
+     * @param The index of the stroke layer
+     * @return The stroke layer
+     *
+     */
+    MandalaLayer & strokeLayer(int);
+
+    /**
+     * @brief Set the stroke layer in which we draw
+     * @param The index of the stroke layer
+     *
+     */
+    void setCurrentStrokeLayer(int);
+
+    /**
+     * @brief Let us get the index of the stroke layer in which we draw
+     * @return The index of the current stroke layer
+     *
+     */
+    int currentStrokeLayerIndex() const;
+
+    /**
+     * @brief Let us get the stroke layer in which we draw
+     * @return The current stroke layer
+     *
+     */
+    MandalaLayer & currentStrokeLayer();
+
+    /**
+     * @brief Set the function painting the content that isn't kept in a layer raster (the QGraphicsScene items of the ItemBackend) in the composite
+     * @param The function painting a scene rectangle with a painter in scene coordinates
+     *
+     */
+    void setItemsRenderer(const std::function<void(QPainter *, const QRectF &)> &);
+
+    /**
+     * @brief Mark a scene rectangle of the items content as changed
+     * @param The changed scene rectangle
+     *
+     */
+    void markItemsDirty(const QRectF &);
+
+    /**
+     * @brief Let us get the revision of the content: it changes whenever a content layer or the items content changes, a layer is added or removed,
+     * or the canvas or the resolution change (a cache of the content is still valid while the revision is the same)
+     * @return The revision
+     *
+     */
+    quint64 revision() const;
+
+    /**
+     * @brief Paint the visible content layers (background and stroke layers) in an exposed scene rectangle
+     * @param The painter (in scene coordinates)
+     * @param The exposed scene rectangle
+     *
+     */
+    void paintContent(QPainter *, const QRectF &) const;
+
+    /**
+     * @brief Let us get the composite of the content layers over the canvas: it is only redone where a layer changed since the last call
+     * @return The composite image (canvas size at the device pixel ratio of the layers, transparent where nothing is drawn)
+     *
+     */
+    const QImage & composite();
+
+    /**
+     * @brief Clear the rasters of all the content layers
+     *
+     */
+    void clearContent();
+
+    /**
+     * @brief Let us know if nothing is drawn in the content layers
+     * @return True if all the content layers are empty, and false if not
+     *
+     */
+    bool contentIsEmpty() const;
+
+    /**
+     * @brief Let us get the memory used by the layer rasters and the cached composite
+     * @return The bytes of the rasters
+     *
+     */
+    qint64 byteCount() const;
+
+private:
+    QRect _canvasRect;
+    qreal _scale = 1;
+    MandalaLayer _background;
+    MandalaLayer _guides;
+    QVector<MandalaLayer> _strokeLayers;
+    int _currentStrokeLayer = 0;
+
+    std::function<void(QPainter *, const QRectF &)> _itemsRenderer;
+    QRectF _itemsDirtyRect;
+
+    // _revision counts the changes that aren't counted by the revisions of the content layers (the revisions of the removed layers are added to it,
+    // so that revision() never goes back to a previous value)
+    quint64 _revision = 0;
+
+    // _composite is the cached composite of the content layers
+    QImage _composite;
+};
+
+#endif // LAYERSTACK_H
@@ -14,11 +14,28 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QFutureWatcher>
+#include "mandalaGenerator.h"
+#include "strokeJournal.h"
+#include "symmetryEngine.h"
+#include "strokeStabilizer.h"
+#include "collabSession.h"
+#include "imageExporter.h"
+#include "mandalaScript.h"
 
 namespace Ui {
 class MainWindow;
 }
 
+class GeneratorPanel;
+class GalleryPanel;
+class SymmetryPanel;
+class StabilizerPanel;
+class QActionGroup;
+class QLabel;
+class QTabBar;
+class QTimer;
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -50,6 +67,56 @@ protected:
 private:
     Ui::MainWindow *ui;
 
+    // _generatorPanel is the dock panel of the mandala generator
+    GeneratorPanel * _generatorPanel;
+
+    // _symmetryPanel is the dock panel of the symmetry group
+    SymmetryPanel * _symmetryPanel;
+
+    // _stabilizerPanel is the dock panel of the stroke stabilizer, _latencyTimer refreshes the latency it shows while it is visible and we draw
+    StabilizerPanel * _stabilizerPanel;
+    QTimer * _latencyTimer;
+
+    // _galleryPanel is the dock panel of the mandalas thumbnails
+    GalleryPanel * _galleryPanel;
+
+    // _paletteGroup holds the exclusive actions of the rainbow mode palettes
+    QActionGroup * _paletteGroup;
+
+    // _documentTabs holds a tab per open document. The document of the current tab is in the view, _documents holds the others hibernated
+    // (the entry of the current tab is empty). _untitledCount numbers the new documents, _documentsConsumer counts the hibernated ones in the memory budget
+    QTabBar * _documentTabs;
+    QVector<HibernatedDocument> _documents;
+    int _activeDocument = 0;
+    int _untitledCount = 1;
+    int _documentsConsumer;
+
+    // _memoryLabel shows the memory used by the drawing, its history and the caches in the status bar
+    QLabel * _memoryLabel;
+
+    // _tileExportWatcher follows the export of a seamless tile (its pyramid is filtered and encoded on worker threads)
+    QFutureWatcher<QString> * _tileExportWatcher;
+
+    // _imageExportWatcher follows the save of the drawing (quantized and encoded on worker threads)
+    QFutureWatcher<ImageExportReport> * _imageExportWatcher;
+
+    // _scriptWatcher follows the variations of a script, rendered and exported on all the CPU cores
+    QFutureWatcher<ScriptReport> * _scriptWatcher;
+
+    // _collabServer relays the session we host (nullptr if we don't host one), _collabSession is our client of a session.
+    // _sessionLabel shows the bandwidth of the session in the status bar, _sessionTimer refreshes it from the bytes counted at its last refresh
+    CollabServer * _collabServer = nullptr;
+    CollabSession * _collabSession;
+    QLabel * _sessionLabel;
+    QTimer * _sessionTimer;
+    qint64 _sessionBytesSent = 0;
+    qint64 _sessionBytesReceived = 0;
+
+    // _journalWatcher reads back the journals of the documents of a crashed session at startup. Until the user has answered, _journalRecovered is false and
+    // nothing is journaled: a new journal would replace the files being read
+    QFutureWatcher<QVector<JournalRecovery>> * _journalWatcher;
+    bool _journalRecovered = false;
+
     // _color defines the color we use to draw
     QColor _color;
 
@@ -61,33 +128,94 @@ private:
     // If it is set to false then we only use one color to draw in grid mandala mode and if it is set to true we use HSV Color
     bool _hsvActivator = false;
 
-    // _brush defines the icon of the cursor we will use to draw or to erase
-    QPixmap _brush;
-
     // _singlePaintMode defines if we will draw using classic painting or with mandala effects:
     // If it is set to true, we only draw one form while mouseMoveEvent, and if it is set to false we draw using mandala effects
     bool _singlePaintMode = true;
 
+    // _exportScale is the scale of the saved images relative to the canvas size (2 saves a 1000x1000 canvas as a 2000x2000 image)
+    double _exportScale = 1.0;
+
+    // _imageExportSettings are the palette, PNG and JPEG options of the saved images (the last ones chosen)
+    ImageExportSettings _imageExportSettings;
+
+    /**
+     * @brief Ask the user the options of a saved image
+     * @param The format of the image (png, bmp or jpg)
+     * @return False if the user cancelled
+     *
+     */
+    bool askImageExportSettings(const QString &);
+
     /**
      * @brief Personnalize a QMessageBOX and show it
      * @param The QMessageBOX window icon
      * @param The QMessageBOX title
      * @param The QMessageBOX text
-     * @param The QMessageBOX icon
+     * @param The resource path of the QMessageBOX icon
      * @param The buttons number of the  QMessageBOX, if 1 then display only QMessageBox:OK if 2 it'll display QMessageBox::Yes and QMessageBox::No
      * @return The text of the chosen button
      *
      */
-    QString showMessageBox(QIcon icon, QString title, QString text, QPixmap pixmap, int buttonsNumber);
+    QString showMessageBox(QIcon icon, QString title, QString text, QString pixmapPath, int buttonsNumber);
+
+    /**
+     * @brief Open a new document in its own tab, with the canvas size of the current one, and show it
+     * @param The title of the tab
+     *
+     */
+    void newDocument(const QString &);
+
+    /**
+     * @brief Open an image: in the current tab if it is empty, else in a new tab
+     * @param The image path
+     *
+     */
+    void openDocument(const QString &);
+
+    /**
+     * @brief Fill the layer combo box with the layers of the view
+     *
+     */
+    void updateLayerComboBox();
+
+    /**
+     * @brief Show the settings of the document in the view on the mandala tools, the palette menu and the symmetry panel (the view already has them)
+     * @param The settings of the document
+     *
+     */
+    void showDocumentSettings(const DocumentSettings &);
+
+    /**
+     * @brief Let the memory budget release the histories of the hibernated documents: their redo entries first, then their oldest undo entries
+     * @param The bytes to release
+     * @return The bytes released
+     *
+     */
+    qint64 releaseDocumentHistories(qint64);
 
 private slots:
     void actionExit_triggered();
     void actionAbout_triggered();
     void actionSaveAs_triggered();
+    void actionExportTile_triggered();
+    void actionExportScale_triggered();
+    void actionSelectStrokes_toggled(bool);
+    void actionHostSession_triggered();
+    void actionJoinSession_triggered();
+    void actionLeaveSession_triggered();
+    void sessionJoined(quint32);
+    void sessionLeft(QString);
+    void updateSessionRate();
     void actionRedo_triggered();
     void actionUndo_triggered();
     void actionOpenFile_triggered();
     void actionNewFile_triggered();
+    void actionNewLayer_triggered();
+    void actionResetZoom_triggered();
+    void actionMemoryLimit_triggered();
+    void actionRunScript_triggered();
+    void scriptProgress(int);
+    void scriptFinished();
 
     void updateSlicesSpinBox(int);
     void updateSlicesSlider(int);
@@ -102,6 +230,26 @@ private slots:
     void setBrightness(int);
     void rainbowActivator();
     void singleModeActivator();
+    void selectLayer(int);
+    void generateMandala(GeneratorSettings);
+    void openGalleryImage(QString);
+    void switchDocument(int);
+    void closeDocument(int);
+    void journalRecovered();
+    void showJournalError(QString);
+    void selectPalette(QAction *);
+    void setSymmetry(SymmetrySettings);
+    void actionGradientColors_triggered();
+    void tileExported();
+    void imageExported();
+    void updateMemoryUsage(qint64, qint64);
+    void setStabilizer(StabilizerSettings);
+    void showLatency();
+    void startLatencyRefresh();
+    void stopLatencyRefresh();
+    void resetLatency();
+    void stabilizerPanelVisibilityChanged(bool);
+    void deviceScaleChanged();
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,106 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   mandalaGenerator.h
+ * @date   October 2026
+ *
+ * @brief  mandalaGenerator generates the lines of a mandala slice from parameters (seeded random strokes, rosettes, spirographs and L-system motifs):
+ * the generated lines go through the same symmetry pipeline as the lines drawn by the user
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef MANDALAGENERATOR_H
+#define MANDALAGENERATOR_H
+
+#include <QByteArray>
+#include <QLineF>
+#include <QPointF>
+#include <QVector>
+
+// GeneratorSettings defines what we generate: the same settings (seed included) always give the same lines
+struct GeneratorSettings {
+    enum Pattern { RandomStrokes, Rosette, Spirograph, LSystem };
+
+    Pattern pattern = Rosette;
+    quint64 seed = 1;
+    // segments is the number of lines we generate in the slice (before the symmetry)
+    int segments = 2000;
+    // radius is the maximum distance between the generated lines and the symmetry center
+    double radius = 200;
+};
+
+// SeededRandom is a splitmix64 generator: unlike the std distributions, its output is the same with every compiler and standard library
+class SeededRandom
+{
+public:
+    explicit SeededRandom(quint64 seed);
+
+    /**
+     * @brief Let us get the next 64 random bits
+     * @return The random bits
+     *
+     */
+    quint64 next();
+
+    /**
+     * @brief Let us get a random number in [0, 1)
+     * @return The random number
+     *
+     */
+    double uniform();
+
+    /**
+     * @brief Let us get a random number in [minimum, maximum)
+     * @param The minimum
+     * @param The maximum
+     * @return The random number
+     *
+     */
+    double uniform(double, double);
+
+private:
+    quint64 _state;
+};
+
+class MandalaGenerator
+{
+public:
+    // Quantum is the grid (in pixels) on which the generated points are snapped, so that the output doesn't depend on the last bits of the math library
+    static const double Quantum;
+
+    /**
+     * @brief Generate the lines of the fundamental slice (the wedge between the angles 0 and 360/slices around the symmetry center)
+     * @param The generator settings
+     * @param The symmetry center
+     * @param The number of slices (0 in single mode: the whole disc is generated)
+     * @return The generated lines
+     *
+     */
+    static QVector<QLineF> generate(const GeneratorSettings &, QPointF, int);
+
+    /**
+     * @brief Compute a fingerprint of generated lines: the same settings must always give the same fingerprint (regression tests and caches)
+     * @param The generated lines
+     * @return The SHA-1 of the lines coordinates
+     *
+     */
+    static QByteArray fingerprint(const QVector<QLineF> &);
+
+private:
+    // Each pattern generator appends its lines around the origin (0, 0), in the wedge between 0 and the given angle (in radians)
+    static void generateRandomStrokes(const GeneratorSettings &, SeededRandom &, double, QVector<QLineF> &);
+    static void generateRosette(const GeneratorSettings &, SeededRandom &, double, QVector<QLineF> &);
+    static void generateSpirograph(const GeneratorSettings &, SeededRandom &, double, QVector<QLineF> &);
+    static void generateLSystem(const GeneratorSettings &, SeededRandom &, double, QVector<QLineF> &);
+
+    /**
+     * @brief Snap a point on the Quantum grid
+     * @param The point
+     * @return The snapped point
+     *
+     */
+    static QPointF quantize(QPointF);
+};
+
+#endif // MANDALAGENERATOR_H
@@ -0,0 +1,81 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   mandalaRasterizer.h
+ * @date   October 2026
+ *
+ * @brief  mandalaRasterizer paints batches of mandala segments (the user line and all its symmetrical copies) into a TiledRaster using all the CPU cores
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef MANDALARASTERIZER_H
+#define MANDALARASTERIZER_H
+
+#include <QLineF>
+#include <QColor>
+#include <QVector>
+#include "tiledRaster.h"
+
+// MandalaSegment is one line to rasterize with its own color (the colors differ from a slice to another in rainbow mode)
+struct MandalaSegment {
+    QLineF line;
+    QRgb color;
+};
+
+class MandalaRasterizer
+{
+public:
+    MandalaRasterizer();
+
+    /**
+     * @brief Set the antialiasing of the rasterized lines on or off
+     * @param The boolean letting us know if we must antialias the lines
+     *
+     */
+    void setAntialiasing(bool);
+
+    /**
+     * @brief Set the number of tiles under which we paint on the calling thread: for small batches, the thread pool costs more than it saves
+     * @param The minimum number of touched tiles
+     *
+     */
+    void setParallelThreshold(int);
+
+    /**
+     * @brief Rasterize a batch of segments: the batch is fanned out to the tiles it touches, and every tile is painted by a worker
+     * of the global QThreadPool with its own QPainter. The tiles are disjoint images so the workers never need to lock anything, and
+     * inside a tile the segments are painted in the batch order, so the result is the same as painting the batch on a single image.
+     *
+     * @param The raster we paint on
+     * @param The segments to paint
+     * @param The width of the pen
+     * @return The scene rectangle that changed
+     *
+     */
+    QRectF rasterize(TiledRaster &, const QVector<MandalaSegment> &, qreal) const;
+
+    /**
+     * @brief Compute the scene rectangle covered by a batch of segments, round caps and antialiasing included
+     * @param The segments
+     * @param The width of the pen
+     * @return The covered scene rectangle
+     *
+     */
+    static QRectF segmentsBounds(const QVector<MandalaSegment> &, qreal);
+
+    /**
+     * @brief Compute the scene rectangle covered by one segment, round caps and antialiasing included
+     * @param The line of the segment
+     * @param The width of the pen
+     * @return The covered scene rectangle
+     *
+     */
+    static QRectF segmentBounds(const QLineF &, qreal);
+
+private:
+    bool _antialiasing = false;
+    int _parallelThreshold = 2;
+};
+
+#endif // MANDALARASTERIZER_H
@@ -0,0 +1,177 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   mandalaScript.h
+ * @date   October 2026
+ *
+ * @brief  mandalaScript reads a command file describing a drawing (strokes, generated patterns) and the view parameters (slices, mirror, pen, colors,
+ * symmetry group), with parameter sweeps: every variation is rendered offscreen with its own symmetry and color engines and exported, in parallel
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef MANDALASCRIPT_H
+#define MANDALASCRIPT_H
+
+#include <QColor>
+#include <QImage>
+#include <QPolygonF>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "colorEngine.h"
+#include "mandalaGenerator.h"
+#include "symmetryEngine.h"
+#include "tiledRaster.h"
+
+// ScriptVariation is one rendering of a script: the view parameters, the drawing and the exported file
+struct ScriptVariation {
+    int index = 0;
+    QSize canvasSize = QSize(600, 600);
+    int slices = 0;
+    bool mirror = false;
+    bool rainbow = false;
+    ColorEngine::Palette palette = ColorEngine::HsvWheel;
+    QColor color = Qt::black;
+    int penSize = 2;
+    bool antialiasing = true;
+    SymmetrySettings symmetry;
+
+    // strokes are the lines drawn by hand (polylines in canvas coordinates), generators the generated patterns: both are copied by the symmetry
+    QVector<QPolygonF> strokes;
+    QVector<GeneratorSettings> generators;
+
+    QString output;
+};
+
+// ScriptBuffers are the buffers of a rendering: a thread rendering one variation after another reuses them instead of allocating them again
+// (the image must be released by the caller before the next rendering, or it is copied)
+struct ScriptBuffers {
+    TiledRaster raster;
+    QVector<MandalaSegment> segments;
+    QImage image;
+};
+
+// ScriptReport is the result of a variation: the file written, or the error if it could not be written
+struct ScriptReport {
+    int index = 0;
+    QString output;
+    QString error;
+
+    /**
+     * @brief Let us get the report as one line
+     * @return The line
+     *
+     */
+    QString toString() const;
+};
+
+class MandalaScript
+{
+public:
+    // MaxCanvasSide is the largest width or height (in pixels) of a rendered image
+    static const int MaxCanvasSide;
+
+    MandalaScript();
+
+    /**
+     * @brief Read a command file
+     * @param The command file name
+     * @return True if the file was read, else the error is given by errorString()
+     *
+     */
+    bool load(const QString &);
+
+    /**
+     * @brief Read commands
+     * @param The commands (one per line, # starts a comment)
+     * @param The directory the relative paths (load, export) start from
+     * @return True if the commands were read, else the error is given by errorString()
+     *
+     */
+    bool parse(const QString &, const QString &);
+
+    /**
+     * @brief Let us get the error of the last load() or parse()
+     * @return The error message
+     *
+     */
+    QString errorString() const;
+
+    /**
+     * @brief Let us get all the variations of the script: the cartesian product of its sweeps
+     * @return The variations
+     *
+     */
+    QVector<ScriptVariation> variations() const;
+
+    /**
+     * @brief Render a variation offscreen, on the calling thread: the symmetry, color engine and raster belong to this rendering only
+     * @param The variation
+     * @return The rendered image (the drawing on the white paper)
+     *
+     */
+    static QImage render(const ScriptVariation &);
+
+    /**
+     * @brief Render a variation offscreen, on the calling thread, in reused buffers: the copies are rasterized at the size of the image
+     * @param The variation
+     * @param The buffers of the calling thread
+     * @param The size of the image (the canvas is stretched to it)
+     * @return The rendered image (it shares the image buffer)
+     *
+     */
+    static QImage render(const ScriptVariation &, ScriptBuffers &, QSize);
+
+    /**
+     * @brief Render a variation and save it to its output file
+     * @param The variation
+     * @return The report of the variation
+     *
+     */
+    static ScriptReport renderAndExport(const ScriptVariation &);
+
+    /**
+     * @brief Render and export all the variations of the script, on all the CPU cores
+     * @return The report lines, in the variations order
+     *
+     */
+    QStringList run() const;
+
+private:
+    struct Sweep {
+        QString parameter;
+        QStringList values;
+    };
+
+    ScriptVariation _base;
+    QVector<Sweep> _sweeps;
+    QString _output;
+    QString _error;
+
+    // _loading are the files being loaded, so that a file loading itself is an error instead of an endless loop
+    QStringList _loading;
+
+    /**
+     * @brief Set a view parameter of a variation
+     * @param The variation
+     * @param The parameter name
+     * @param The parameter arguments
+     * @return An error message, empty if the parameter was set
+     *
+     */
+    static QString setParameter(ScriptVariation &, const QString &, const QStringList &);
+
+    /**
+     * @brief Let us get the output file name of a variation: the {parameter} placeholders are replaced by the variation values
+     * @param The output pattern
+     * @param The variation
+     * @param The number of variations
+     * @return The file name
+     *
+     */
+    static QString outputName(const QString &, const ScriptVariation &, int);
+};
+
+#endif // MANDALASCRIPT_H
@@ -0,0 +1,137 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   memoryBudget.h
+ * @date   October 2026
+ *
+ * @brief  memoryBudget is the central memory manager of the application: the scene items, the undo/redo history, the layer rasters and the caches
+ * report the bytes they use, and when the user ceiling is reached the manager asks them to release memory in priority order
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+
+// MemoryUsage is what a consumer uses: its name, its category and its bytes
+struct MemoryUsage {
+    QString name;
+    int category;
+    qint64 bytes;
+};
+
+class MemoryBudget : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Category defines what a consumer is, and the order in which the consumers release memory when the ceiling is reached:
+    // the caches are rebuilt for free, the scene items are flattened into their layer raster without any visible change,
+    // then the old history entries are given up, and the layer rasters are only tracked (they are the drawing itself)
+    enum Category { Caches, SceneItems, History, Rasters };
+
+    // DefaultCeiling is the ceiling (in bytes) we use until the user sets one
+    static const qint64 DefaultCeiling;
+
+    /**
+     * @brief Let us get the memory manager of the application
+     * @return The memory manager
+     *
+     */
+    static MemoryBudget * instance();
+
+    /**
+     * @brief Register a memory consumer
+     * @param The consumer name (shown to the user)
+     * @param The consumer category
+     * @param The function giving the bytes the consumer uses
+     * @param The function asking the consumer to release at least some bytes: it returns the bytes it released (nullptr: the consumer is only tracked)
+     * @return The consumer identifier (for removeConsumer())
+     *
+     */
+    int addConsumer(const QString &, Category, const std::function<qint64()> &, const std::function<qint64(qint64)> &);
+
+    /**
+     * @brief Unregister a memory consumer (it must be done before the consumer is deleted)
+     * @param The consumer identifier
+     *
+     */
+    void removeConsumer(int);
+
+    /**
+     * @brief Set the memory ceiling
+     * @param The ceiling in bytes (0: no ceiling)
+     *
+     */
+    void setCeiling(qint64);
+
+    /**
+     * @brief Let us get the memory ceiling
+     * @return The ceiling in bytes (0: no ceiling)
+     *
+     */
+    qint64 ceiling() const;
+
+    /**
+     * @brief Let us get the bytes used by each consumer
+     * @return The usage of the consumers
+     *
+     */
+    QVector<MemoryUsage> usages() const;
+
+    /**
+     * @brief Let us get the bytes used by all the consumers
+     * @return The used bytes
+     *
+     */
+    qint64 usedBytes() const;
+
+    /**
+     * @brief Let us get the bytes used by the consumers of a category
+     * @param The category
+     * @return The used bytes
+     *
+     */
+    qint64 usedBytes(Category) const;
+
+public slots:
+    /**
+     * @brief Ask for the ceiling to be enforced once the current event is handled: the consumers call it each time they grow, the requests are coalesced
+     *
+     */
+    void requestEnforce();
+
+    /**
+     * @brief Release memory in priority order until the used bytes are under the ceiling
+     * @return The released bytes
+     *
+     */
+    qint64 enforce();
+
+signals:
+    void usageChanged(qint64 usedBytes, qint64 ceiling);
+
+private:
+    struct Consumer {
+        int id;
+        QString name;
+        Category category;
+        std::function<qint64()> usage;
+        std::function<qint64(qint64)> release;
+    };
+
+    explicit MemoryBudget(QObject *parent = nullptr);
+
+    QVector<Consumer> _consumers;
+    int _nextId = 1;
+    qint64 _ceiling;
+    QTimer _enforceTimer;
+};
+
+#endif // MEMORYBUDGET_H
@@ -19,12 +19,76 @@
 #include <QGraphicsEllipseItem>
 #include <QMouseEvent>
 #include <QStack>
+#include "mandalaRasterizer.h"
+#include "layerStack.h"
+#include "mandalaGenerator.h"
+#include "strokeJournal.h"
+#include "colorEngine.h"
+#include "symmetryEngine.h"
+#include "historySnapshot.h"
+#include "strokeStabilizer.h"
+#include "latencyMeter.h"
+#include "strokeDocument.h"
+#include "strokeInstanceItem.h"
+#include "collabSession.h"
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTimer>
+
+// DocumentSettings are the symmetry and colors a document is drawn with: its strokes are projected again with them, so every document keeps its own
+// (slices is 0 in single mode)
+struct DocumentSettings {
+    int slices = 0;
+    bool mirror = false;
+    SymmetrySettings symmetry;
+    ColorEngine::Palette palette = ColorEngine::HsvWheel;
+    bool rainbow = false;
+};
+
+// HibernatedDocument is a document of the workspace while another one is in the view: its content flattened to a compressed snapshot
+// (with its strokes, to project them again), its undo and redo histories, its canvas size, its settings, the names of its layers and the directory of its journal
+// (kept on the disk while it is hibernated, a new one is made if it is empty)
+struct HibernatedDocument {
+    QSize canvasSize;
+    DocumentSettings settings;
+    HistorySnapshot content;
+    QStack<HistorySnapshot> undoHistory;
+    QStack<HistorySnapshot> redoHistory;
+    bool historyTruncated = false;
+    QStringList layerNames;
+    QString journalDirectory;
+
+    /**
+     * @brief Let us get the memory used by the document (its snapshots, compressed or not yet)
+     * @return The bytes of the document
+     *
+     */
+    qint64 byteCount() const;
+};
 
 class MyQGraphicsView : public QGraphicsView
 {
     Q_OBJECT
 
 public:
+    // RenderBackend defines how the drawn lines are kept: ItemBackend adds a QGraphicsLineItem per line to the QGraphicsScene,
+    // and RasterBackend paints the lines in a tiled raster layer (drawn as the view background) using all the CPU cores
+    enum RenderBackend { ItemBackend, RasterBackend };
+
+    // MinimumZoom and MaximumZoom bound the scale of the view, SceneExtent is the half size of the (unbounded) scene in which we can pan
+    static const double MinimumZoom;
+    static const double MaximumZoom;
+    static const int SceneExtent;
+
+    // ItemBytes is the estimated memory of a QGraphicsLineItem (the item, its private data, its pen and its entry in the scene index)
+    static const qint64 ItemBytes;
+
+    // ReprojectionSettle is the time (in milliseconds) without symmetry change after which the drawing is projected again at full quality
+    static const int ReprojectionSettle;
+
+    // DetailSettle is the time (in milliseconds) without zoom, pan or drawing after which a zoomed in view is rasterized again at its own resolution
+    static const int DetailSettle;
+
     explicit MyQGraphicsView(QWidget *parent = nullptr);
     ~MyQGraphicsView() override;
 
@@ -43,7 +107,7 @@ public:
     void setPenColor(QColor);
 
     /**
-     * @brief Set the number of slices we must use to divide the QGraphicsView (the app drawing view) and draw them if the grid mode was activated
+     * @brief Set the number of slices we must use to divide the QGraphicsView (the app drawing view) and draw them in the guides overlay if the grid mode was activated
      * @param The number of slices
      */
     void setAndDrawSlices(int);
@@ -76,6 +140,61 @@ public:
      */
     void setRainbowMode(bool);
 
+    /**
+     * @brief Set the symmetry group used in mandala mode (the number of slices and the mirror are set apart)
+     * @param The symmetry settings
+     *
+     */
+    void setSymmetrySettings(const SymmetrySettings &);
+
+    /**
+     * @brief Let us get the symmetry and colors we draw with: the slices, the mirror, the symmetry group, the palette and the rainbow mode
+     * @return The settings of the document in the view
+     *
+     */
+    DocumentSettings documentSettings() const;
+
+    /**
+     * @brief Set the palette of the rainbow mode
+     * @param The palette
+     *
+     */
+    void setColorPalette(ColorEngine::Palette);
+
+    /**
+     * @brief Set the gradient stops of the Gradient and Radial palettes
+     * @param The gradient stops
+     *
+     */
+    void setGradientStops(const QGradientStops &);
+
+    /**
+     * @brief Let us get the gradient stops of the Gradient and Radial palettes
+     * @return The gradient stops
+     *
+     */
+    QGradientStops gradientStops() const;
+
+    /**
+     * @brief Set the size of the canvas (what is composited and saved): the symmetry center is the center of the canvas, and the view is reset to show it
+     * @param The size of the canvas
+     *
+     */
+    void setCanvasSize(QSize);
+
+    /**
+     * @brief Let us get the size of the canvas
+     * @return The size of the canvas
+     *
+     */
+    QSize canvasSize();
+
+    /**
+     * @brief Reset the zoom and the pan of the view: the canvas is shown at its real size
+     *
+     */
+    void resetZoom();
+
     /**
      * @brief If the user haven't selected a size to the QGraphicsView, he can't draw anything. This method let us know if he chosed a size or not
      * @param The boolean letting us know if the user have set a size to the QGraphicsView or not
@@ -103,7 +222,8 @@ public:
     void redoLastAction();
 
     /**
-     * @brief When the user change the size of the QGraphicsView, this method scales all drawn items to the new QGraphicsView size
+     * @brief When the user change the size of the QGraphicsView, this method scales all drawn items to the new QGraphicsView size.
+     * The drawing becomes the base of the document (its strokes can't be edited anymore), unless the size didn't change
      *
      */
     void resizePaintedItems();
@@ -123,7 +243,7 @@ public:
     void openImage(QString);
 
     /**
-     * @brief Push on the undo stack a screenshot of the actual QGraphicsView (without slices dashlines and mirror lines)
+     * @brief Push on the undo stack the composite of the content layers (it never holds the slices dashlines and mirror lines)
      *
      */
     void pushScreenShot();
@@ -134,6 +254,22 @@ public:
      */
     void clearAllHistories();
 
+    /**
+     * @brief Take the document out of the view to make room for another one: its content is flattened to a snapshot compressed in the background,
+     * it keeps its histories and its journal files, and the view is left empty with one layer
+     * @return The hibernated document
+     *
+     */
+    HibernatedDocument hibernateDocument();
+
+    /**
+     * @brief Put a hibernated document back in the view: its snapshot is decoded here, once, and its strokes are projected again only when the symmetry changes.
+     * Its settings come back before its strokes. The journal of the view is deleted and the document is journaled in its own directory again
+     * @param The hibernated document (a default one gives an empty document)
+     *
+     */
+    void restoreDocument(const HibernatedDocument &);
+
     /**
      * @brief Let us know if the QGraphicsScene items list is empty or not
      * @return True if the the QGraphicsScene items list is empty, and false if not
@@ -141,6 +277,180 @@ public:
      */
     bool sceneIsEmpty();
 
+    /**
+     * @brief Set the backend used to keep the drawn lines (QGraphicsLineItem objects or raster layer)
+     * @param The render backend
+     *
+     */
+    void setRenderBackend(RenderBackend);
+
+    /**
+     * @brief Let us know which backend is used to keep the drawn lines
+     * @return The render backend
+     *
+     */
+    RenderBackend renderBackend() const;
+
+    /**
+     * @brief Turn on/off the symmetry kernels specialised for the common slice counts (they are on by default)
+     * @param The boolean letting us know if the specialised kernels may be used
+     *
+     */
+    void setSymmetryKernelsEnabled(bool);
+
+    /**
+     * @brief Turn on/off the first symmetry method, drawLinesSymmetricallyToSlices(): the drawn lines of the mandala mode are rotated by the complex number
+     * formula instead of going through the symmetry engine (it is off by default, the render verification uses it as the reference)
+     * @param The boolean letting us know if the first symmetry method is used
+     *
+     */
+    void setLegacySymmetryEnabled(bool);
+
+    /**
+     * @brief Add a new stroke layer on top of the others, it becomes the layer in which we draw
+     * @param The name of the layer
+     * @return The index of the new layer
+     *
+     */
+    int addStrokeLayer(QString);
+
+    /**
+     * @brief Set the stroke layer in which we draw
+     * @param The index of the stroke layer
+     *
+     */
+    void setCurrentStrokeLayer(int);
+
+    /**
+     * @brief Let us know how many stroke layers we have
+     * @return The number of stroke layers
+     *
+     */
+    int strokeLayerCount();
+
+    /**
+     * @brief Let us get the name of a stroke layer
+     * @param The index of the stroke layer
+     * @return The name of the stroke layer
+     *
+     */
+    QString strokeLayerName(int);
+
+    /**
+     * @brief Show or hide a stroke layer (a hidden layer isn't saved)
+     * @param The index of the stroke layer
+     * @param The boolean letting us know if the layer must be visible
+     *
+     */
+    void setStrokeLayerVisible(int, bool);
+
+    /**
+     * @brief Let us get the cached composite of the content layers (background and stroke layers, without the guides): it is only redone where a layer changed
+     * @return The composite image
+     *
+     */
+    const QImage & contentImage();
+
+    /**
+     * @brief Let us get the image to save: the composite of the content layers flattened on the white background of the QGraphicsView.
+     * At the resolution of the layers, it is a single copy of the cached composite into a reused buffer; at another scale the document is
+     * rasterized again at that scale (see renderArea()). The widget, the grid slices and the mirror lines are never rendered
+     * @param The scale of the image (1: one pixel per canvas pixel)
+     * @return The image to save
+     *
+     */
+    const QImage & exportImage(qreal = 1);
+
+    /**
+     * @brief Let us get the seamless tile of the wallpaper drawing (the tile must lie in the drawn area: the visible area and the canvas)
+     * @param The tile in scene coordinates (output)
+     * @return True if the drawing is a wallpaper
+     *
+     */
+    bool seamlessTileRect(QRectF &);
+
+    /**
+     * @brief Render a scene rectangle offscreen on the white background, without the grid slices and the mirror lines: the document is projected
+     * and rasterized again at the resolution of the image, only its base image is resampled
+     * @param The scene rectangle
+     * @param The size of the rendered image
+     * @return The rendered image
+     *
+     */
+    QImage renderArea(const QRectF &, QSize);
+
+    /**
+     * @brief Draw lines as if the user drew them (symmetry, mirror and rainbow colors included), all in one batch, and push the result on the undo stack
+     * @param The lines to draw
+     *
+     */
+    void drawLines(const QVector<QLineF> &);
+
+    /**
+     * @brief Generate the lines of the fundamental slice from the generator settings and draw them with drawLines()
+     * @param The generator settings
+     * @return The generated lines (before the symmetry)
+     *
+     */
+    QVector<QLineF> generate(const GeneratorSettings &);
+
+    /**
+     * @brief Turn on/off the journal: when it is turned on, a new journal starts from the current content, and when it is turned off the journal files are deleted
+     * @param The boolean letting us know if the finished strokes must be journaled
+     *
+     */
+    void setJournalEnabled(bool);
+
+    /**
+     * @brief Draw the content read back from a journal after a crash (the canvas size must be set before), and start a new journal from it
+     * in the directory of the recovered journal: the journal of the document in the view is deleted
+     * @param The recovered content
+     *
+     */
+    void replayJournal(const JournalRecovery &);
+
+    /**
+     * @brief Set how the mouse positions are filtered before the symmetry copies them, and how far ahead the stroke tip is predicted
+     * @param The stabilizer settings
+     *
+     */
+    void setStabilizerSettings(const StabilizerSettings &);
+
+    /**
+     * @brief Let us get the latency of the draw path: from a mouse move to the frame showing it
+     * @return The latency samples
+     *
+     */
+    const LatencyMeter & inputLatency() const;
+
+    /**
+     * @brief Let us get how late the drawn stroke tip (the predicted tip if the prediction is turned on) is behind the mouse, at the mouse speed
+     * @return The latency samples
+     *
+     */
+    const LatencyMeter & tipLatency() const;
+
+    /**
+     * @brief Forget the latency samples
+     *
+     */
+    void resetLatency();
+
+    /**
+     * @brief Turn on/off the selection tool: a click picks a stroke drawn in mandala mode (or any of its copies), a drag moves it,
+     * with Shift scales it and with Ctrl rotates it. Turning it off commits the edited stroke
+     * @param The boolean letting us know if the mouse selects strokes instead of drawing
+     *
+     */
+    void setSelectionEnabled(bool);
+
+    /**
+     * @brief Set the pen color of the selected stroke (all its copies follow)
+     * @param The pen color
+     *
+     */
+    void setSelectedStrokeColor(QColor);
+
 private:
     QGraphicsScene * _scene;
     bool _paintEnabled = false;
@@ -151,102 +461,419 @@ private:
     bool _hsvColorToggled = false;
     bool _gridButtonEnabled = false;
     bool _mirrorButtonEnabled = false;
+    RenderBackend _renderBackend = RasterBackend;
+    bool _legacySymmetry = false;
+
+    // _colorEngine gives the colors of the rainbow mode (_hsvColorToggled) from a precomputed palette
+    ColorEngine _colorEngine;
+
+    // _symmetry gives the symmetrical copies of the drawn lines (dihedral group, wallpaper group or kaleidoscope)
+    SymmetryEngine _symmetry;
+
+    // _layers holds the background layer, the stroke layers (in which the RasterBackend paints the drawn lines) and the guides overlay
+    LayerStack _layers;
+    MandalaRasterizer _rasterizer;
+
+    // _exportBuffer is the reused buffer in which exportImage() flattens the composite
+    QImage _exportBuffer;
 
-    // _screenshotActivator let us know if we must push a grabed image in our _undoStackCommand or not:
+    // _screenshotActivator counts the lines drawn since the mouse was pressed, it let us know if we must push a grabed image in our _undoStackCommand or not:
     // we can click on the view without drawing so that won't be counted as an action
     int _screenshotActivator = 0;
 
-    QStack<QPixmap> _undoHistoryStack;
-    QStack<QPixmap> _redoHistoryStack;
+    // _journal is the autosave of the finished strokes of the document in the view (_journalEnabled is false until the canvas has a size),
+    // _strokeSegments are the segments of the stroke being drawn
+    StrokeJournal _journal;
+    bool _journalEnabled = false;
+    QVector<MandalaSegment> _strokeSegments;
 
-    QVector<QGraphicsItem *> _slicesAddedHistory;
-    QVector<QGraphicsItem *> _mirrorLinesHistory;
+    // The history keyframes are compressed in the background, they are only decoded when we undo or redo
+    QStack<HistorySnapshot> _undoHistoryStack;
+    QStack<HistorySnapshot> _redoHistoryStack;
+
+    // _historyTruncated let us know if the oldest undo entries were released by the memory manager: we can't undo past the oldest one left
+    bool _historyTruncated = false;
+
+    // _memoryConsumers are the identifiers of the scene items, history, rasters and export buffer in the memory manager
+    QVector<int> _memoryConsumers;
+
+    // _symmetryCenter is the center of the rotations and mirrors, in scene coordinates
+    QPointF _symmetryCenter;
+
+    // _panOrigin is the last position of the mouse while the view is dragged with the middle button
+    QPoint _panOrigin;
 
     QPointF _previousPoint;
+
+    // _stabilizer filters the mouse positions of a stroke, _predictionSegments are the predicted stroke tip (and its symmetrical copies):
+    // it is only shown in the foreground, it is replaced as soon as the next mouse position arrives
+    StrokeStabilizer _stabilizer;
+    QVector<MandalaSegment> _predictionSegments;
+
+    // _inputClock times the draw path: _pendingInputTime is the time (in nanoseconds) of the oldest mouse move not painted yet
+    QElapsedTimer _inputClock;
+    qint64 _pendingInputTime = -1;
+    LatencyMeter _inputLatency;
+    LatencyMeter _tipLatency;
+
+    // _document holds the strokes before the symmetry, _strokeLines the drawn lines of the stroke being drawn: when the slices, the mirror,
+    // the rainbow mode or the symmetry group change, the whole drawing is projected again (a draft at once, the final pass once the changes settle)
+    StrokeDocument _document;
+    QVector<QLineF> _strokeLines;
+    QTimer _draftTimer;
+    QTimer _reprojectionTimer;
+
+    // The layers are kept at the resolution of the screen: zoomed in, they would only be magnified. Once the view settles, _detailRaster holds the
+    // document rasterized again at the resolution of the viewport (in viewport pixels), for _detailTransform and the _detailRevision of the layers
+    TiledRaster _detailRaster;
+    QTransform _detailTransform;
+    quint64 _detailRevision = 0;
+    QTimer _detailTimer;
+
+    // _selectedStroke is the document stroke being edited (-1: none): it is left out of the layers and shown by _selectionItem, whose copies are
+    // instances of its lines. _selectionColor is its pen color, _selectionColors its rainbow colors. A drag starts at _editOrigin on the copy
+    // _editCopy, with the stroke transform _editStart around _editCenter (in the drawn geometry) and the modifiers _editModifiers
+    bool _selectionEnabled = false;
+    int _selectedStroke = -1;
+    StrokeInstanceItem * _selectionItem = nullptr;
+    QRgb _selectionColor;
+    ColorEngine _selectionColors;
+    QTransform _editCopy;
+    QPointF _editOrigin;
+    QTransform _editStart;
+    QPointF _editCenter;
+    Qt::KeyboardModifiers _editModifiers;
+
+    // RemoteStroke is a stroke another client of the session is drawing: its style, the layer it goes to here, its last point, its drawn lines
+    // and its segments (projected here with our symmetry), and its rainbow colors
+    struct RemoteStroke {
+        CollabStroke style;
+        int layer;
+        bool symmetric;
+        QPointF previous;
+        QVector<QLineF> lines;
+        QVector<MandalaSegment> segments;
+        ColorEngine colors;
+    };
+    QHash<quint64, RemoteStroke> _remoteStrokes;
+
     // _drawLineIndicator will help us to draw lines but whithout remembering the last position of our mouse click if we release the mouse!
     int _drawLineIndicator = 0;
 
     /**
-     * @brief Draw lines that defines the mandala mirror
+     * @brief Let us get the area in which the wallpaper tiles are drawn: the visible part of the scene and the canvas
+     * @return The area in scene coordinates
      *
      */
-    void setMirrorLines();
+    QRectF visibleArea();
 
     /**
-     * @brief Removes all drawn QGraphicsLineItem objects that defines the QGraphicsView slices (grid lines)
+     * @brief Let us get how far a drawn line reaches around its center line: half the widest pen of the document, of the strokes of the other clients
+     * and of our pen
+     * @return The reach in scene coordinates
      *
      */
-    void removeAllDrawnSlices();
+    qreal strokeReach() const;
 
     /**
-     * @brief Removes all drawn QGraphicsLineItem objects that defines the QGraphicsView slices (mirror lines)
+     * @brief Follow the device pixel ratio of the screen the view is on: the layers are kept at its resolution
      *
      */
-    void removeAllDrawnMirrorLines();
+    void updateDeviceScale();
 
     /**
-     * @brief Let us know if a QGraphicsItem exists already in our QGraphicsScene
-     * @param The searched QGraphicsItem
-     * @return True if the QGraphicsItem is already drawn in our QGraphicsView (already memorized in our QGraphicsScene), and false if not.
+     * @brief Mark the guides overlay (grid slices and mirror lines) as changed, it will be redrawn the next time it is painted
      *
      */
-    bool exists(QGraphicsItem *);
+    void updateGuides();
+
+    /**
+     * @brief Draw the grid slices dashlines (if the grid mode is activated) and the lines that defines the mandala mirror (if the mirror mode is activated)
+     * @param The painter of the guides overlay
+     *
+     */
+    void paintGuides(QPainter *);
 
     /**
      * @brief If the user activated the "mandala mode", we need to draw in all our view slices the same object but symmetrically to the center of our QGraphicsView.
-     * This method use the complex number rotation formula: we change the center of the default reference (0,0) to the middle of our QGraphicsView (width()/2, height()/2),
+     * This method use the complex number rotation formula: we change the center of the default reference (0,0) to the symmetry center (the middle of the canvas),
      * and we draw the QGraphicsItem objects the user drew after defining an angle in which we rotate this objects (the new rotation center will be the point
-     * C(width()/2, height()/2), and the rotation ax is Qt::Zaxes
+     * C(_symmetryCenter), and the rotation ax is Qt::Zaxes
      *
      * @param Two points, because we draw lines not points:
-     * We draw a QGraphicsLineItem from two points (the remembered previous mouse clicked points coordinate values, and the new mouse clicked points coordinate values)
+     * We draw a line from two points (the remembered previous mouse clicked points coordinate values, and the new mouse clicked points coordinate values)
+     * @param The batch of segments in which we append the symmetrical lines
+     *
+     */
+    void drawLinesSymmetricallyToSlices(QPointF, QPointF, QVector<MandalaSegment> &);
+
+    /**
+     * @brief Append a line and all its symmetrical lines (given by the symmetry group) with their colors to a batch of segments
+     * @param The line drawn by the user
+     * @param The batch of segments
+     *
+     */
+    void appendSymmetricalSegments(const QLineF &, QVector<MandalaSegment> &);
+
+    /**
+     * @brief Draw a batch of segments with the current render backend: QGraphicsLineItem objects, or one parallel pass of the rasterizer
+     * @param The segments to draw
+     * @param The pen width
+     * @param The stroke layer index (-1: the current stroke layer)
+     *
+     */
+    void drawSegments(const QVector<MandalaSegment> &, int, int = -1);
+
+    /**
+     * @brief Append a finished stroke to the journal (in the current stroke layer), and compact the journal if it has grown too much
+     * @param The segments of the stroke
+     *
+     */
+    void journalStroke(const QVector<MandalaSegment> &);
+
+    /**
+     * @brief Draw the stroke from the previous point through filtered points, with their symmetrical copies, in one batch
+     * @param The filtered points
+     *
+     */
+    void drawStrokePoints(const QVector<QPointF> &);
+
+    /**
+     * @brief Show the predicted stroke tip: from the last drawn point to the last mouse position and on to the predicted position
+     *
+     */
+    void updatePrediction();
+
+    /**
+     * @brief Hide the predicted stroke tip
+     *
+     */
+    void clearPrediction();
+
+    /**
+     * @brief Append a finished stroke to the document: it follows the symmetry if it was drawn in mandala mode, it is kept as drawn otherwise
+     * @param The drawn lines (before the symmetry)
+     * @param The drawn segments
+     *
+     */
+    void documentStroke(const QVector<QLineF> &, const QVector<MandalaSegment> &);
+
+    /**
+     * @brief Replace the document after the content was replaced (undo, redo, clear, opened image): a pending projection of the previous one is dropped
+     * @param The new document
+     *
+     */
+    void setDocument(const StrokeDocument &);
+
+    /**
+     * @brief Ask for the drawing to be projected again with the current symmetry and colors: the changes are coalesced
+     *
+     */
+    void requestReprojection();
+
+    /**
+     * @brief Project the whole document again: the content is cleared, the base image restored, and each batch projected and rasterized.
+     * The drawing is always rasterized, even with the ItemBackend: a QGraphicsLineItem per copy would never keep up
+     * @param The boolean letting us know if the lines are antialiased
+     *
+     */
+    void reproject(bool);
+
+    /**
+     * @brief Let us get the color engine of each stroke of the document for the rainbow mode (empty if it is off)
+     * @return The color engines, in the strokes order
+     *
+     */
+    QVector<ColorEngine> strokeColorEngines() const;
+
+    /**
+     * @brief Rasterize the document again through a transform, as reproject() does: its base image is resampled, and its strokes (and the ones other
+     * clients are drawing) are projected over a scene area and rasterized at the resolution of the raster, their pen widths scaled by the transform.
+     * The hidden layers and the stroke being edited are left out
+     * @param The raster (in the coordinates given by the transform)
+     * @param The scene area the copies must cover
+     * @param The transform from the scene to the raster coordinates (a scale and a translation)
+     *
+     */
+    void rasterizeDocument(TiledRaster &, const QRectF &, const QTransform &);
+
+    /**
+     * @brief Paint the stroke being edited (with its copies) over a raster filled by rasterizeDocument()
+     * @param The raster
+     * @param The scene area
+     * @param The transform from the scene to the raster coordinates
+     *
+     */
+    void paintSelection(TiledRaster &, const QRectF &, const QTransform &);
+
+    /**
+     * @brief Let us know if the detail raster shows the current content with the current view transform
+     * @return True if the detail raster can be painted instead of the layers
+     *
+     */
+    bool detailIsCurrent() const;
+
+    /**
+     * @brief Find the stroke drawn in mandala mode under a point: the point is brought back through each copy of the symmetry group to the drawn geometry
+     * @param The point in scene coordinates
+     * @param The transform of the copy under the point (output)
+     * @return The stroke index, -1 if there is none
      *
      */
-    void drawLinesSymmetricallyToSlices(QPointF, QPointF);
+    int pickStroke(QPointF, QTransform &);
 
     /**
-     * @brief This is the overloaded method of drawLinesSymmetricallyToSlices(QPointF, QPointF): this last only use mathemics formula, but this new overloaded method only
-     * use QTransform: we create a QTransform().translate(width()/2, height()/2).rotate("the angle of rotation").translate(-width()/2, -height()/2).
-     * Both drawLinesSymmetricallyToSlices(QPointF, QPointF) and drawLinesSymmetricallyToSlices(QGraphicsLineItem *) do the same thing, but this one is more optimal.
+     * @brief Start editing a stroke: the drawing is projected again without it, and its copies are shown as instances of its lines
+     * @param The stroke index
      *
-     * @param The QGraphicsLineItem drawn by the user
+     */
+    void selectStroke(int);
+
+    /**
+     * @brief Place the copies of the selected stroke with the current symmetry group and colors
      *
      */
-    void drawLinesSymmetricallyToSlices(QGraphicsLineItem *);
+    void updateSelectionInstances();
 
     /**
-     * @brief Do the same job of QTransform().translate(width()/2, height()/2).rotate("the angle of rotation").translate(-width()/2, -height()/2)
-     * @param QPointF: The new relative center
-     * @param QPointF: The point we want to transform (we can easilly use QTransform, but I used the rotation formula)
-     * @param The angle in which we want the point rotate
-     * @return The new QPointF after being transformed
+     * @brief Move, scale or rotate the selected stroke while it is dragged: only its lines are moved, its copies are placed by their transforms
+     * @param The mouse position in scene coordinates
      *
      */
-    QPointF changeReference(QPointF, QPointF, double);
+    void editSelection(QPointF);
 
     /**
-     * @brief Let us use HSV color using rotation (thanks to hue())
-     * @param QColor: hsvColor
-     * @return Tuple<the new hue, the saturation, the value>
+     * @brief Put the selected stroke back in the document with its transform and color (nothing is redrawn)
+     * @return True if a stroke was selected
      *
      */
-    std::tuple<int, int, int> updateHSVColor(QColor);
+    bool releaseSelection();
 
     /**
-     * @brief This method helps us to draw the symmetrical objects of the drawn QGraphicsLineItem, using mirror lines (Mirror effects)
+     * @brief Put the selected stroke back in the document, project the drawing again with it and push the result on the undo stack
      *
-     * @param The QGraphicsLineItem drawn by the user
+     */
+    void commitSelection();
+
+    /**
+     * @brief Append the copies of lines of a stroke of another client to a batch, with our symmetry and the colors of the stroke
+     * @param The stroke
+     * @param The lines
+     * @param The batch of segments
      *
      */
-    void mirrorSymetricDrawing(QGraphicsLineItem *, QColor);
+    void projectRemoteLines(const RemoteStroke &, const QVector<QLineF> &, QVector<MandalaSegment> &);
+
+    /**
+     * @brief Restart the journal from the current content, after the content was replaced (undo, redo, clear, opened image)
+     *
+     */
+    void journalContent();
+
+    /**
+     * @brief Start the journal of the document from the current content, if journaling is enabled
+     *
+     */
+    void startJournal();
+
+    /**
+     * @brief Show an undo/redo screenshot in the QGraphicsView: it is painted in the background layer
+     * @param The screenshot
+     *
+     */
+    void restoreScreenShot(const QImage &);
+
+    /**
+     * @brief Delete all the QGraphicsScene items and the content of the background and stroke layers
+     *
+     */
+    void clearContent();
+
+    /**
+     * @brief Let us get the memory used by the undo/redo history (the compressed keyframes, and the ones still being compressed)
+     * @return The bytes of the history
+     *
+     */
+    qint64 historyBytes() const;
+
+    /**
+     * @brief Release history entries: the farthest redo entries first, then the oldest undo entries (the current content is always kept)
+     * @param The bytes we want to release
+     * @return The released bytes
+     *
+     */
+    qint64 releaseHistory(qint64);
+
+    /**
+     * @brief Paint the QGraphicsScene items in the raster of their stroke layer and delete them: nothing changes on screen
+     * @return The released bytes (the items minus the layer tiles we had to allocate)
+     *
+     */
+    qint64 flattenItems();
 
 protected:
+    void drawBackground(QPainter *, const QRectF &) override;
+    void drawForeground(QPainter *, const QRectF &) override;
+    void wheelEvent(QWheelEvent *) override;
+    void mousePressEvent(QMouseEvent *) override;
     void mouseMoveEvent(QMouseEvent *) override;
     void mouseReleaseEvent(QMouseEvent *) override;
+    void paintEvent(QPaintEvent *) override;
 
 signals:
+    void deviceScaleChanged();
+
+    // The strokes drawn with the mouse, for the other clients of a session: the filtered points are sent, never their copies
+    void strokeStarted(CollabStroke, QPointF);
+    void strokeExtended(QVector<QPointF>);
+    void strokeFinished();
+
+    // The journal couldn't be written: the error is shown to the user
+    void journalFailed(QString);
 
 public slots:
+    /**
+     * @brief Start drawing a stroke of another client of the session
+     * @param The stroke (the client number and its stroke number)
+     * @param The stroke style
+     * @param The first point
+     *
+     */
+    void beginRemoteStroke(quint64, CollabStroke, QPointF);
+
+    /**
+     * @brief Draw the new points of a stroke of another client, with their copies given by our symmetry
+     * @param The stroke
+     * @param The points
+     *
+     */
+    void extendRemoteStroke(quint64, QVector<QPointF>);
+
+    /**
+     * @brief Finish a stroke of another client: it goes to the document, the journal and the undo stack like ours
+     * @param The stroke
+     *
+     */
+    void endRemoteStroke(quint64);
+
+private slots:
+    /**
+     * @brief Project the drawing again without antialiasing, while the symmetry is being changed
+     *
+     */
+    void reprojectDraft();
+
+    /**
+     * @brief Project the drawing again at full quality once the symmetry settled, and push it on the undo stack
+     *
+     */
+    void reprojectFinal();
+
+    /**
+     * @brief Rasterize the visible document again at the resolution of the zoomed in viewport (it waits for the strokes being drawn)
+     *
+     */
+    void renderDetail();
 };
 
 #endif // MYQGRAPHICSVIEW_H
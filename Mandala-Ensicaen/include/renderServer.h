@@ -0,0 +1,177 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   renderServer.h
+ * @date   October 2026
+ *
+ * @brief  renderServer is the headless render service: it accepts command files (see mandalaScript) over a local socket, renders their variations
+ * on a warm thread pool with reused buffers, and streams the encoded images back as they are done. The jobs have a timeout, the server refuses
+ * jobs when it is full, and it keeps throughput counters
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef RENDERSERVER_H
+#define RENDERSERVER_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QSize>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include "mandalaScript.h"
+
+class QDataStream;
+class QLocalServer;
+class QLocalSocket;
+
+class RenderServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // A message is a frame (its size, then its content): the content starts with the magic, the version, the message type and the job number
+    enum MessageType { RenderRequest = 1, StatsRequest, ImageReply, DoneReply, ErrorReply, StatsReply };
+
+    // DefaultName is the socket name, DefaultTimeout the time (in milliseconds) a job may take,
+    // MaxRequestBytes the largest request frame, OutputHighWater the bytes a client may leave unread before its new jobs are refused
+    static const QString DefaultName;
+    static const int DefaultTimeout;
+    static const int MaxRequestBytes;
+    static const qint64 OutputHighWater;
+
+    explicit RenderServer(QObject *parent = nullptr);
+    ~RenderServer() override;
+
+    /**
+     * @brief Start listening: the socket left by a server that crashed is removed, a running server is an error
+     * @param The socket name
+     * @return True if the server listens, else the error is given by errorString()
+     *
+     */
+    bool listen(const QString &);
+
+    /**
+     * @brief Let us get the error of the last listen()
+     * @return The error message
+     *
+     */
+    QString errorString() const;
+
+    /**
+     * @brief Set the number of jobs queued or running above which the new jobs are refused (twice the threads by default): the jobs that timed out
+     * count until their worker stops
+     * @param The number of jobs
+     *
+     */
+    void setMaxPendingJobs(int);
+
+    /**
+     * @brief Let us get the throughput counters
+     * @return The counters: jobs accepted, completed, failed, timed out and refused, jobs pending, jobs still on a worker, images and bytes sent, mean render time, images per second
+     *
+     */
+    QJsonObject stats() const;
+
+    /**
+     * @brief Send a command file to a server and save the images it streams back to the outputs of the variations (a blocking client)
+     * @param The socket name
+     * @param The command file name
+     * @param The size of the images (an invalid size keeps the canvas size)
+     * @param The job timeout in milliseconds
+     * @return A report line per image, or the error
+     *
+     */
+    static QStringList submit(const QString &, const QString &, QSize, int);
+
+    /**
+     * @brief Ask a server for its throughput counters (a blocking client)
+     * @param The socket name
+     * @return The counters as JSON, or the error
+     *
+     */
+    static QString requestStats(const QString &);
+
+private:
+    // Job is a job being rendered: the client and its job number, the time it started, its timeout, the images sent, and the flag the worker reads between variations
+    struct Job {
+        QPointer<QLocalSocket> client;
+        quint32 id;
+        QElapsedTimer clock;
+        int timeout;
+        int images;
+        QSharedPointer<QAtomicInt> cancelled;
+    };
+
+    QLocalServer * _server;
+    QString _error;
+
+    // _pool keeps its threads between the jobs: each thread keeps its own rendering buffers
+    QThreadPool _pool;
+    QHash<quint64, Job> _jobs;
+    quint64 _nextJob = 1;
+    int _maxPendingJobs;
+    // _workers is the number of jobs queued or running on the pool: a job that timed out or whose client left keeps its thread until it stops
+    int _workers = 0;
+
+    // _deadlineTimer looks for the jobs past their timeout while jobs are running
+    QTimer _deadlineTimer;
+
+    QElapsedTimer _uptime;
+    qint64 _accepted = 0;
+    qint64 _completed = 0;
+    qint64 _failed = 0;
+    qint64 _timedOut = 0;
+    qint64 _refused = 0;
+    qint64 _images = 0;
+    qint64 _bytesSent = 0;
+    qint64 _renderTime = 0;
+
+    /**
+     * @brief Read a render request and start its job, or refuse it
+     * @param The client
+     * @param The job number of the client
+     * @param The request content after the header
+     *
+     */
+    void startJob(QLocalSocket *, quint32, QDataStream &);
+
+    /**
+     * @brief Finish a job: its reply is sent and the job forgotten (a late result of the worker is dropped)
+     * @param The job
+     * @param The reply type (DoneReply or ErrorReply)
+     * @param The error message
+     *
+     */
+    void finishJob(quint64, MessageType, const QString &);
+
+    /**
+     * @brief Render the variations of a job on the calling worker, in its thread buffers, and post each encoded image to the server,
+     * then the end of the job (even if it was cancelled)
+     * @param The server
+     * @param The job
+     * @param The variations
+     * @param The size of the images (an invalid size keeps the canvas size)
+     * @param The cancel flag
+     *
+     */
+    static void runJob(RenderServer *, quint64, const QVector<ScriptVariation> &, QSize, QSharedPointer<QAtomicInt>);
+
+private slots:
+    void newConnection();
+    void readClient();
+    void clientDisconnected();
+    void checkDeadlines();
+    void imageRendered(quint64, int, QString, QByteArray, qint64);
+    void jobFinished(quint64, QString);
+    void workerFinished();
+};
+
+#endif // RENDERSERVER_H
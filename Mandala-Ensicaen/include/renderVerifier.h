@@ -0,0 +1,110 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   renderVerifier.h
+ * @date   October 2026
+ *
+ * @brief  renderVerifier checks the optimised rendering paths against the first symmetry method drawn with QGraphicsLineItem objects (--verify-render): it replays a corpus of drawings
+ * offscreen through each backend of MyQGraphicsView, compares the images with a per-pixel tolerance and an SSIM score, writes the diff images,
+ * and reports the speedup of each backend next to its result
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef RENDERVERIFIER_H
+#define RENDERVERIFIER_H
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "mandalaScript.h"
+#include "myQGraphicsView.h"
+
+// RenderConfiguration is a way of rendering a drawing: the backend of the view, the symmetry kernels it may use, and if the lines are rotated by
+// the first symmetry method of the view instead of the symmetry engine. The first configuration of a verification is the reference the others are compared with
+struct RenderConfiguration {
+    QString name;
+    MyQGraphicsView::RenderBackend backend;
+    bool kernels;
+    bool legacy;
+};
+
+// RenderComparison is the difference between two images: the pixels with a channel further than the tolerance, and the mean SSIM of the luma
+struct RenderComparison {
+    qint64 mismatched = 0;
+    qint64 pixels = 0;
+    double ssim = 1;
+    QImage diff;
+};
+
+class RenderVerifier
+{
+public:
+    // DefaultTolerance is the largest channel difference of a matching pixel, DefaultMinimumSsim the lowest SSIM of a matching image,
+    // MaxMismatchedRatio the part of the pixels that may be further than the tolerance (the antialiased edges), Runs the replays of which we keep the fastest
+    static const int DefaultTolerance;
+    static const double DefaultMinimumSsim;
+    static const double MaxMismatchedRatio;
+    static const int Runs;
+
+    /**
+     * @brief Let us get the configurations we verify for a drawing: the reference first, the QGraphicsLineItem objects of the first symmetry method
+     * when it knows the symmetry of the drawing (the mandala mode with the horizontal mirror), else the QGraphicsLineItem objects of the symmetry engine
+     * @param The drawing
+     * @return The configurations
+     *
+     */
+    static QVector<RenderConfiguration> configurations(const ScriptVariation &);
+
+    /**
+     * @brief Let us get the drawings verified when no command file is given: hand strokes and generated patterns with few and many slices, mirror,
+     * rainbow colors, a wallpaper group and aliased lines
+     * @return The drawings (their output is their name)
+     *
+     */
+    static QVector<ScriptVariation> builtinCorpus();
+
+    /**
+     * @brief Replay a drawing in a new offscreen view, as the user would draw it: one drawLines() per stroke, then the generated patterns
+     * @param The drawing
+     * @param The configuration of the view
+     * @param The time (in milliseconds) of the replay and of the exported image (output)
+     * @return The exported image
+     *
+     */
+    static QImage replay(const ScriptVariation &, const RenderConfiguration &, double &);
+
+    /**
+     * @brief Compare an image with the reference one
+     * @param The reference image
+     * @param The image
+     * @param The tolerance of a channel
+     * @return The comparison, with its diff image: the pixels further than the tolerance in red, the smaller differences in orange, the reference faded
+     *
+     */
+    static RenderComparison compare(const QImage &, const QImage &, int);
+
+    /**
+     * @brief Compute the mean SSIM of the luma of two images of the same size, on 8x8 windows every 4 pixels
+     * @param The first image
+     * @param The second image
+     * @return The SSIM (1 for identical images)
+     *
+     */
+    static double ssim(const QImage &, const QImage &);
+
+    /**
+     * @brief Replay every drawing through every configuration and compare the images with the reference ones
+     * @param The drawings
+     * @param The directory of the images and diff images (empty: nothing is written)
+     * @param The tolerance of a channel
+     * @param The lowest SSIM of a matching image
+     * @param True if every image matched its reference (output)
+     * @return A report line per drawing and configuration, then the summary
+     *
+     */
+    static QStringList verify(const QVector<ScriptVariation> &, const QString &, int, double, bool &);
+};
+
+#endif // RENDERVERIFIER_H
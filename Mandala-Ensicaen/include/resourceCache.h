@@ -0,0 +1,55 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   resourceCache.h
+ * @date   October 2026
+ *
+ * @brief  resourceCache decodes the images of the resources the first time they are used, and keeps them (and their scaled copies and the drawing cursors)
+ * so that they are never decoded or scaled again
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef RESOURCECACHE_H
+#define RESOURCECACHE_H
+
+#include <QCursor>
+#include <QPixmap>
+#include <QSize>
+#include <QString>
+
+class ResourceCache
+{
+public:
+    // CursorShape defines the cursors we use on the painting widget
+    enum CursorShape { BrushCursor, EraserCursor };
+
+    /**
+     * @brief Let us get a resource image: it is decoded the first time we ask for it
+     * @param The resource path
+     * @return The image
+     *
+     */
+    static QPixmap pixmap(const QString &);
+
+    /**
+     * @brief Let us get a resource image scaled to a size (smooth transformation): it is decoded and scaled the first time we ask for it
+     * @param The resource path
+     * @param The size of the image (in device independent pixels)
+     * @param The device pixel ratio of the screen it is shown on (the image has size times ratio pixels)
+     * @return The scaled image
+     *
+     */
+    static QPixmap scaledPixmap(const QString &, QSize, qreal = 1);
+
+    /**
+     * @brief Let us get a cursor of the painting widget: its image is scaled once per device pixel ratio, the first time we ask for it
+     * @param The cursor shape
+     * @param The device pixel ratio of the screen of the painting widget
+     * @return The cursor
+     *
+     */
+    static QCursor cursor(CursorShape, qreal = 1);
+};
+
+#endif // RESOURCECACHE_H
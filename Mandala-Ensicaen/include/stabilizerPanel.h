@@ -0,0 +1,64 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   stabilizerPanel.h
+ * @date   October 2026
+ *
+ * @brief  stabilizerPanel is the dock panel that let the user choose how the strokes are smoothed (lazy brush, one-euro filter or Catmull-Rom curve)
+ * and how far ahead their tip is predicted, it shows the latency of the draw path
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef STABILIZERPANEL_H
+#define STABILIZERPANEL_H
+
+#include <QDockWidget>
+#include "strokeStabilizer.h"
+
+class QComboBox;
+class QDoubleSpinBox;
+class QLabel;
+class QSpinBox;
+
+class StabilizerPanel : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit StabilizerPanel(QWidget *parent = nullptr);
+
+    /**
+     * @brief Let us get the stabilizer settings chosen in the panel
+     * @return The stabilizer settings
+     *
+     */
+    StabilizerSettings settings() const;
+
+public slots:
+    /**
+     * @brief Show the latency of the draw path
+     * @param The summary of the latency from a mouse move to its frame
+     * @param The summary of the latency of the drawn stroke tip behind the mouse
+     *
+     */
+    void showLatency(const QString &, const QString &);
+
+private:
+    QComboBox * _modeComboBox;
+    QDoubleSpinBox * _lazyRadiusSpinBox;
+    QDoubleSpinBox * _minCutoffSpinBox;
+    QDoubleSpinBox * _betaSpinBox;
+    QSpinBox * _predictionSpinBox;
+    QLabel * _inputLatencyLabel;
+    QLabel * _tipLatencyLabel;
+
+signals:
+    void stabilizerChanged(StabilizerSettings);
+    void latencyResetRequested();
+
+private slots:
+    void emitStabilizerChanged();
+};
+
+#endif // STABILIZERPANEL_H
@@ -0,0 +1,60 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   startupTimer.h
+ * @date   October 2026
+ *
+ * @brief  startupTimer measures the startup of the application (--startup-timing): it prints the time of each startup phase until the first frame, then quits
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef STARTUPTIMER_H
+#define STARTUPTIMER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class QWidget;
+
+class StartupTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param The clock started when the process entered main()
+     *
+     */
+    explicit StartupTimer(const QElapsedTimer &, QObject *parent = nullptr);
+
+    /**
+     * @brief Record the end of a startup phase
+     * @param The name of the phase
+     *
+     */
+    void mark(const QString &);
+
+    /**
+     * @brief Wait for the first frame of a window: the phases are printed once it is painted, and the application quits
+     * @param The window
+     *
+     */
+    void watchFirstFrame(QWidget *);
+
+protected:
+    bool eventFilter(QObject *, QEvent *) override;
+
+private:
+    QElapsedTimer _clock;
+    QVector<QPair<QString, qint64>> _phases;
+    bool _firstFramePainted = false;
+
+private slots:
+    void firstFrameDone();
+};
+
+#endif // STARTUPTIMER_H
@@ -0,0 +1,191 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   strokeDocument.h
+ * @date   October 2026
+ *
+ * @brief  strokeDocument keeps the strokes of a mandala as the user drew them (before the symmetry): the whole drawing can be projected again
+ * with other slices, mirror or colors. It is a value (the containers are implicitly shared), so the history keeps a copy of it at each step
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef STROKEDOCUMENT_H
+#define STROKEDOCUMENT_H
+
+#include <QHash>
+#include <QImage>
+#include <QLineF>
+#include <QPair>
+#include <QTransform>
+#include <QVector>
+#include "colorEngine.h"
+#include "mandalaRasterizer.h"
+#include "symmetryEngine.h"
+
+// DocumentStroke is what a stroke needs to be colored again: its pen color, and its number for the StrokeCycle palette.
+// Its lines are lines [first, first + count) of a batch: they are moved by its transform (set when the stroke is edited) before the symmetry,
+// and bounds is the area they cover (pen width included) once moved
+struct DocumentStroke {
+    QRgb color;
+    int colorStroke;
+    int batch;
+    int first;
+    int count;
+    QTransform transform;
+    QRectF bounds;
+};
+
+class StrokeDocument
+{
+public:
+    // DocumentBatch holds the consecutive strokes of a layer drawn with the same pen width, in one contiguous array:
+    // a symmetric batch holds the drawn lines (and the stroke of each line), the other holds the segments as they were drawn in single mode
+    struct DocumentBatch {
+        int layer;
+        int penWidth;
+        bool symmetric;
+        QVector<QLineF> lines;
+        QVector<int> strokes;
+        QVector<MandalaSegment> segments;
+    };
+
+    // ProjectionChunk is the number of lines a worker projects at once, IndexCell the size (in pixels) of the cells of the strokes spatial index
+    static const int ProjectionChunk;
+    static const int IndexCell;
+
+    StrokeDocument();
+
+    /**
+     * @brief Start a document from an image that can't be projected again (an opened image, or the content recovered from a journal)
+     * @param The image (the canvas size)
+     *
+     */
+    explicit StrokeDocument(const QImage &);
+
+    /**
+     * @brief Append a stroke drawn in mandala mode: it will follow the symmetry
+     * @param The stroke layer index
+     * @param The pen width
+     * @param The pen color and the color number of the stroke
+     * @param The drawn lines (before the symmetry)
+     *
+     */
+    void addStroke(int, int, const DocumentStroke &, const QVector<QLineF> &);
+
+    /**
+     * @brief Append a stroke drawn in single mode: it is kept as it was drawn
+     * @param The stroke layer index
+     * @param The pen width
+     * @param The drawn segments
+     *
+     */
+    void addFixedStroke(int, int, const QVector<MandalaSegment> &);
+
+    /**
+     * @brief Let us get the image under the strokes
+     * @return The image (a null image if the canvas was empty)
+     *
+     */
+    const QImage & base() const;
+
+    /**
+     * @brief Let us get the strokes drawn in mandala mode
+     * @return The strokes
+     *
+     */
+    const QVector<DocumentStroke> & strokes() const;
+
+    /**
+     * @brief Let us get the batches of the document, in the order they were drawn
+     * @return The batches
+     *
+     */
+    const QVector<DocumentBatch> & batches() const;
+
+    /**
+     * @brief Let us know if a stroke of the document follows the symmetry
+     * @return True if the document must be projected again when the symmetry changes
+     *
+     */
+    bool hasSymmetricStrokes() const;
+
+    /**
+     * @brief Let us get the lines of a stroke drawn in mandala mode, as they were drawn (before its transform)
+     * @param The stroke index
+     * @return The lines
+     *
+     */
+    QVector<QLineF> strokeLines(int) const;
+
+    /**
+     * @brief Let us find the stroke drawn in mandala mode under a point, through the spatial index (only the strokes of the cells around the point are tested)
+     * @param The point, before the symmetry
+     * @param The distance from the lines (besides the half pen width) at which a stroke is still found
+     * @return The index of the last drawn stroke under the point, -1 if there is none
+     *
+     */
+    int strokeAt(QPointF, qreal) const;
+
+    /**
+     * @brief Move, scale or rotate a stroke drawn in mandala mode: all its copies follow, since the transform is applied before the symmetry
+     * @param The stroke index
+     * @param The transform of the drawn lines
+     *
+     */
+    void setStrokeTransform(int, const QTransform &);
+
+    /**
+     * @brief Set the pen color of a stroke drawn in mandala mode
+     * @param The stroke index
+     * @param The pen color
+     *
+     */
+    void setStrokeColor(int, QRgb);
+
+    /**
+     * @brief Let us get the memory used by the document (the base image is shared with the history)
+     * @return The bytes of the lines and segments
+     *
+     */
+    qint64 byteCount() const;
+
+    /**
+     * @brief Project a batch with a symmetry group: the lines are split into chunks projected by the workers of the global QThreadPool
+     * @param The batch index
+     * @param The symmetry engine (it is only read)
+     * @param The color engine of each stroke for the rainbow mode (empty: every copy takes the pen color of its stroke)
+     * @param The index of a stroke left out of the projection (the stroke being edited), -1 to project all the strokes
+     * @return The segments to rasterize, in the order of the lines
+     *
+     */
+    QVector<MandalaSegment> project(int, const SymmetryEngine &, const QVector<ColorEngine> &, int = -1) const;
+
+private:
+    QImage _base;
+    QVector<DocumentStroke> _strokes;
+    QVector<DocumentBatch> _batches;
+
+    // _index is the spatial index of the strokes drawn in mandala mode: the strokes whose bounds cover each cell
+    QHash<QPair<int, int>, QVector<int>> _index;
+
+    /**
+     * @brief Add a stroke to the cells of the spatial index its bounds cover, or remove it from them
+     * @param The stroke index
+     * @param The boolean letting us know if the stroke is added or removed
+     *
+     */
+    void indexStroke(int, bool);
+
+    /**
+     * @brief Let us get the batch in which a stroke is appended: the last one if it has the same layer, pen width and kind, or a new one
+     * @param The stroke layer index
+     * @param The pen width
+     * @param The boolean letting us know if the stroke follows the symmetry
+     * @return The batch
+     *
+     */
+    DocumentBatch & batchFor(int, int, bool);
+};
+
+#endif // STROKEDOCUMENT_H
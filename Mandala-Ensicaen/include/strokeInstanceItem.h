@@ -0,0 +1,96 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   strokeInstanceItem.h
+ * @date   October 2026
+ *
+ * @brief  strokeInstanceItem is the QGraphicsItem of a stroke being edited: its symmetrical copies are instances of one geometry (the drawn lines)
+ * drawn through the transforms of the symmetry group, so moving, scaling or recoloring the stroke never touches its copies one by one
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef STROKEINSTANCEITEM_H
+#define STROKEINSTANCEITEM_H
+
+#include <QGraphicsItem>
+#include <QLineF>
+#include <QRgb>
+#include <QTransform>
+#include <QVector>
+
+// StrokeInstance is a copy of the stroke: the transform of the symmetry group that places it, and its color
+struct StrokeInstance {
+    QTransform transform;
+    QRgb color;
+};
+
+class StrokeInstanceItem : public QGraphicsItem
+{
+public:
+    /**
+     * @brief Create the item of a stroke
+     * @param The drawn lines of the stroke (before its transform and the symmetry)
+     * @param The pen width
+     *
+     */
+    StrokeInstanceItem(const QVector<QLineF> &, int);
+
+    /**
+     * @brief Set the transform of the drawn lines (the edit): the lines are moved once, whatever the number of copies
+     * @param The transform
+     *
+     */
+    void setEditTransform(const QTransform &);
+
+    /**
+     * @brief Let us get the transform of the drawn lines
+     * @return The transform
+     *
+     */
+    const QTransform & editTransform() const;
+
+    /**
+     * @brief Set the copies of the stroke: only their transforms and colors are kept, the geometry is shared by all of them
+     * @param The copies
+     *
+     */
+    void setInstances(const QVector<StrokeInstance> &);
+
+    /**
+     * @brief Let us get the copies of the stroke
+     * @return The copies
+     *
+     */
+    const QVector<StrokeInstance> & instances() const;
+
+    /**
+     * @brief Let us get the area covered by the moved lines, before the symmetry (pen width included)
+     * @return The area in scene coordinates
+     *
+     */
+    QRectF sourceBounds() const;
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *) override;
+
+private:
+    QVector<QLineF> _lines;
+    int _penWidth;
+    QTransform _editTransform;
+
+    // _editedLines are the drawn lines moved by the edit transform, _editedBounds the area they cover
+    QVector<QLineF> _editedLines;
+    QRectF _editedBounds;
+
+    QVector<StrokeInstance> _instances;
+    QRectF _bounds;
+
+    /**
+     * @brief Compute the bounds of all the copies (a rectangle per copy, the lines are not copied)
+     *
+     */
+    void updateBounds();
+};
+
+#endif // STROKEINSTANCEITEM_H
@@ -0,0 +1,192 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   strokeJournal.h
+ * @date   October 2026
+ *
+ * @brief  strokeJournal is the crash-safe autosave of a mandala: each finished stroke is appended to a journal file (buffered writes, synced to the disk
+ * on a time or size budget), and the journal is compacted in the background into a snapshot image followed by a new journal.
+ * Every open document has its own journal directory, so all of them are recovered after a crash
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef STROKEJOURNAL_H
+#define STROKEJOURNAL_H
+
+#include <QFile>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QSize>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include "mandalaRasterizer.h"
+
+// JournalStroke is a finished stroke: the drawn segments (symmetrical copies included) of a stroke layer
+struct JournalStroke {
+    int layer;
+    int penWidth;
+    QVector<MandalaSegment> segments;
+};
+
+// JournalRecovery is what we read back from a journal: its directory, the canvas size, the snapshot we start from (null if the canvas was empty)
+// and the strokes drawn on it
+struct JournalRecovery {
+    QString directory;
+    QSize canvasSize;
+    QImage base;
+    QVector<JournalStroke> strokes;
+
+    bool isValid() const { return canvasSize.isValid(); }
+    bool isEmpty() const { return base.isNull() && strokes.isEmpty(); }
+};
+
+class StrokeJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    // The journal is synced to the disk when SyncBytes are waiting or SyncInterval milliseconds after the first unsynced stroke,
+    // and it is compacted when it holds more than CompactionBytes
+    static const qint64 SyncBytes;
+    static const int SyncInterval;
+    static const qint64 CompactionBytes;
+
+    explicit StrokeJournal(QObject *parent = nullptr);
+    ~StrokeJournal() override;
+
+    /**
+     * @brief Let us get the directory in which the journals of the documents of the application are kept
+     * @return The directory path
+     *
+     */
+    static QString defaultDirectory();
+
+    /**
+     * @brief Let us get a new journal directory for a document, in the default directory
+     * @return The directory path
+     *
+     */
+    static QString newDirectory();
+
+    /**
+     * @brief Set the directory of the journal files (it must be set before start(), a new journal starts in a new directory)
+     * @param The directory path
+     *
+     */
+    void setDirectory(const QString &);
+
+    /**
+     * @brief Let us get the directory of the journal files
+     * @return The directory path
+     *
+     */
+    QString directory() const;
+
+    /**
+     * @brief Let us know if a journal is being written
+     * @return True if strokes are journaled
+     *
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Start a new journal: the journal files already in the directory are deleted once the new snapshot is written
+     * @param The canvas size
+     * @param The content of the canvas we start from (a null image if the canvas is empty)
+     *
+     */
+    void start(QSize, const QImage &);
+
+    /**
+     * @brief Append a finished stroke to the journal
+     * @param The stroke layer index
+     * @param The pen width
+     * @param The drawn segments
+     *
+     */
+    void appendStroke(int, int, const QVector<MandalaSegment> &);
+
+    /**
+     * @brief Replace the journaled content by an image (after an undo, a redo, a clear or an opened image, or to compact the journal):
+     * a new journal is started at once, the image is encoded and the previous journal deleted in the background
+     * @param The content of the canvas (a null image if the canvas is empty)
+     *
+     */
+    void rebase(const QImage &);
+
+    /**
+     * @brief Let us know if the journal has grown enough to be compacted with rebase()
+     * @return True if the journal should be compacted
+     *
+     */
+    bool needsCompaction() const;
+
+    /**
+     * @brief Stop journaling and delete the journal files (the mandala was closed on purpose)
+     *
+     */
+    void discard();
+
+    /**
+     * @brief Stop journaling and keep the journal files on the disk (the document is still open in another tab)
+     *
+     */
+    void close();
+
+    /**
+     * @brief Read back a journal: it is called from a worker thread at startup, a stroke that was half written when the application crashed is dropped
+     * @param The directory of the journal files
+     * @return The recovered content (invalid if there is no journal)
+     *
+     */
+    static JournalRecovery recover(const QString &);
+
+    /**
+     * @brief Read back the journal of each document: it is called from a worker thread at startup
+     * @param The directory holding the journal directories of the documents
+     * @return The recovered content of each journal directory (invalid for a directory without a journal)
+     *
+     */
+    static QVector<JournalRecovery> recoverAll(const QString &);
+
+signals:
+    // A journal file or a snapshot couldn't be written: the strokes drawn since aren't safe anymore
+    void failed(QString);
+
+public slots:
+    /**
+     * @brief Write the buffered strokes and wait until the disk has them
+     *
+     */
+    void sync();
+
+private:
+    QString _directory;
+    QFile _file;
+    QSize _canvasSize;
+
+    // _generation numbers the journal files: the journal of a generation starts from the snapshot of the same generation
+    int _generation = 0;
+    qint64 _unsyncedBytes = 0;
+    qint64 _journalBytes = 0;
+    QTimer _syncTimer;
+
+    // _compactionPool has one thread: the snapshots are written and the old generations deleted in order
+    QThreadPool _compactionPool;
+
+    /**
+     * @brief Close the current journal file and open the one of the next generation
+     * @param The content the new generation starts from
+     *
+     */
+    void openGeneration(const QImage &);
+
+    static QString journalPath(const QString &, int);
+    static QString snapshotPath(const QString &, int);
+    static QList<int> generations(const QString &);
+};
+
+#endif // STROKEJOURNAL_H
@@ -0,0 +1,128 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   strokeStabilizer.h
+ * @date   October 2026
+ *
+ * @brief  strokeStabilizer filters the mouse positions of a stroke before the symmetry copies them (lazy brush, one-euro filter or Catmull-Rom curve),
+ * and predicts where the stroke tip will be a few milliseconds ahead, so that the smoothing doesn't feel late
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef STROKESTABILIZER_H
+#define STROKESTABILIZER_H
+
+#include <QPointF>
+#include <QVector>
+
+// StabilizerSettings defines how the mouse positions are filtered
+struct StabilizerSettings {
+    enum Mode { Off, LazyBrush, OneEuro, CatmullRom };
+
+    Mode mode = Off;
+    // lazyRadius is the length (in pixels) of the string pulling the lazy brush
+    double lazyRadius = 12;
+    // minCutoff (in Hz) is the smoothing of the one-euro filter at low speed, beta how fast the smoothing goes away when the mouse speeds up
+    double minCutoff = 1.5;
+    double beta = 0.02;
+    // predictionTime (in milliseconds) is how far ahead the stroke tip is predicted when the positions are filtered (0: no prediction)
+    int predictionTime = 16;
+};
+
+class StrokeStabilizer
+{
+public:
+    StrokeStabilizer();
+
+    /**
+     * @brief Set how the mouse positions are filtered (it is used from the next stroke)
+     * @param The stabilizer settings
+     *
+     */
+    void setSettings(const StabilizerSettings &);
+
+    /**
+     * @brief Let us get how the mouse positions are filtered
+     * @return The stabilizer settings
+     *
+     */
+    const StabilizerSettings & settings() const;
+
+    /**
+     * @brief Start a stroke
+     * @param The first mouse position (in scene coordinates)
+     * @param The time of the position (in milliseconds)
+     *
+     */
+    void begin(QPointF, double);
+
+    /**
+     * @brief Filter a mouse position of the stroke
+     * @param The mouse position (in scene coordinates)
+     * @param The time of the position (in milliseconds)
+     * @return The filtered points to draw (none if the brush didn't move, several for the Catmull-Rom curve)
+     *
+     */
+    QVector<QPointF> addPoint(QPointF, double);
+
+    /**
+     * @brief End the stroke: the stroke is finished up to the last mouse position
+     * @return The filtered points left to draw
+     *
+     */
+    QVector<QPointF> end();
+
+    /**
+     * @brief Let us get the last mouse position of the stroke (not filtered)
+     * @return The last mouse position
+     *
+     */
+    QPointF lastPosition() const;
+
+    /**
+     * @brief Let us get the mouse speed, smoothed over the last positions
+     * @return The speed (in pixels per millisecond)
+     *
+     */
+    QPointF velocity() const;
+
+    /**
+     * @brief Predict the stroke tip: the last mouse position moved forward by the mouse speed during the prediction time
+     * @return The predicted tip (the last mouse position if the prediction is turned off)
+     *
+     */
+    QPointF predictedTip() const;
+
+private:
+    StabilizerSettings _settings;
+
+    QPointF _lastPosition;
+    double _lastTime = 0;
+    QPointF _velocity;
+
+    // _brush is the filtered position (lazy brush and one-euro filter), _derivative the filtered speed of the one-euro filter
+    QPointF _brush;
+    QPointF _derivative;
+
+    // _controlPoints are the last mouse positions the Catmull-Rom curve goes through
+    QVector<QPointF> _controlPoints;
+
+    /**
+     * @brief Let us get the smoothing factor of a low-pass filter
+     * @param The cutoff frequency (in Hz)
+     * @param The time since the previous position (in milliseconds)
+     * @return The smoothing factor
+     *
+     */
+    static double smoothingFactor(double, double);
+
+    /**
+     * @brief Append the points of the Catmull-Rom segment going from the second to the third of the last four control points
+     * @param The points to draw
+     *
+     */
+    void appendCurve(QVector<QPointF> &) const;
+};
+
+#endif // STROKESTABILIZER_H
@@ -0,0 +1,213 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   symmetryEngine.h
+ * @date   October 2026
+ *
+ * @brief  symmetryEngine gives the symmetrical copies of a drawn line: the dihedral group D_N (N rotations and a mirror of any axis), the 17 wallpaper groups
+ * (seamless tiles) and multi-center kaleidoscopes. Each group is a precomputed list of affine transforms applied to the lines in one batch
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef SYMMETRYENGINE_H
+#define SYMMETRYENGINE_H
+
+#include <QLineF>
+#include <QRectF>
+#include <QString>
+#include <QStringList>
+#include <QTransform>
+#include <QVector>
+#include "mandalaRasterizer.h"
+
+class ColorEngine;
+
+// SymmetrySettings defines the symmetry group (the number of slices and the mirror come from the mandala tools)
+struct SymmetrySettings {
+    enum Mode { Dihedral, Wallpaper, Kaleidoscope };
+    enum WallpaperGroup { P1, P2, PM, PG, CM, PMM, PMG, PGG, CMM, P4, P4M, P4G, P3, P3M1, P31M, P6, P6M };
+
+    Mode mode = Dihedral;
+    // mirrorAngle is the angle (in degrees) of the mirror axis going through the symmetry center, 0 is the horizontal axis
+    double mirrorAngle = 0;
+    WallpaperGroup wallpaperGroup = P4M;
+    // cellSize is the size (in pixels) of the wallpaper lattice cell
+    double cellSize = 120;
+    // The kaleidoscope repeats the dihedral group around kaleidoscopeCenters centers on a circle of kaleidoscopeRadius pixels around the symmetry center
+    int kaleidoscopeCenters = 6;
+    double kaleidoscopeRadius = 150;
+};
+
+class SymmetryEngine
+{
+public:
+    // SymmetryCopy is a transform of the group and the color number its copies take
+    struct SymmetryCopy {
+        QTransform transform;
+        int colorIndex;
+    };
+
+    SymmetryEngine();
+
+    /**
+     * @brief Set the symmetry group
+     * @param The symmetry settings
+     *
+     */
+    void setSettings(const SymmetrySettings &);
+
+    /**
+     * @brief Let us get the symmetry group
+     * @return The symmetry settings
+     *
+     */
+    const SymmetrySettings & settings() const;
+
+    /**
+     * @brief Set the symmetry center (the origin of the wallpaper lattice)
+     * @param The symmetry center
+     *
+     */
+    void setCenter(QPointF);
+
+    /**
+     * @brief Set the number of rotations of the dihedral group (0 in single mode: the line is not copied, whatever the group)
+     * @param The number of slices
+     *
+     */
+    void setSlices(int);
+
+    /**
+     * @brief Turn on/off the mirror of the dihedral group
+     * @param The boolean letting us know if the lines are mirrored
+     *
+     */
+    void setMirror(bool);
+
+    /**
+     * @brief Set the area in which the wallpaper tiles are drawn: the copies in the tiles outside of it are skipped
+     * @param The visible area in scene coordinates
+     * @param The reach of the pen (half its width): a copy this close to the area still draws in it
+     *
+     */
+    void setVisibleArea(const QRectF &, qreal);
+
+    /**
+     * @brief Let us know how many colors the copies use (the copies of a same rotation or wallpaper operation share their color)
+     * @return The number of colors
+     *
+     */
+    int colorCount() const;
+
+    /**
+     * @brief Let us know how many copies of a line we get (for the wallpaper groups: in one tile)
+     * @return The number of copies
+     *
+     */
+    int copyCount() const;
+
+    /**
+     * @brief Append a line and all its symmetrical copies to a batch of segments
+     * @param The line
+     * @param The pen color
+     * @param The color engine giving the color of each copy (nullptr: all the copies take the pen color)
+     * @param The batch of segments
+     *
+     */
+    void apply(const QLineF &, QRgb, const ColorEngine *, QVector<MandalaSegment> &) const;
+
+    /**
+     * @brief Let us get the transforms that copy a shape, instead of its copied lines: a shape is drawn once per transform
+     * (for the wallpaper groups, each operation of the tile is repeated on the lattice translations that bring the shape into the visible area)
+     * @param The bounds of the shape
+     * @return The transforms and their color numbers, in the order apply() writes the copies
+     *
+     */
+    QVector<SymmetryCopy> instances(const QRectF &) const;
+
+    /**
+     * @brief Let us get the smallest axis-aligned rectangle that tiles the plane by translation (only for the wallpaper groups)
+     * @param The seamless tile in scene coordinates, its top left corner is the symmetry center (output)
+     * @return True if the drawing is a wallpaper and has a seamless tile
+     *
+     */
+    bool seamlessTile(QRectF &) const;
+
+    /**
+     * @brief Let us get the name of a wallpaper group (in the crystallographic notation)
+     * @param The wallpaper group
+     * @return The name
+     *
+     */
+    static QString wallpaperGroupName(SymmetrySettings::WallpaperGroup);
+
+    /**
+     * @brief Turn on/off the kernels specialised for the common slice counts (4, 6, 8, 12, 16, 24): when they are off, every group goes through the generic transforms
+     * @param The boolean letting us know if the specialised kernels may be used
+     *
+     */
+    void setKernelsEnabled(bool);
+
+    /**
+     * @brief Let us know if the current group is copied by a specialised kernel
+     * @return True if a specialised kernel is used
+     *
+     */
+    bool usesKernel() const;
+
+    /**
+     * @brief Time the specialised kernels against the generic transforms, for every specialised slice count (with and without the mirror)
+     * @param The number of lines copied by each run
+     * @return A report line per slice count: the time per line of both paths, the speedup and the largest difference between their copies
+     *
+     */
+    static QStringList benchmarkKernels(int);
+
+    // DihedralKernel copies a line with a dihedral group of a given slice count: it gets the line, the symmetry center, the linear part of the mirror
+    // (nullptr without mirror), the pen color, the color engine (nullptr: all the copies take the pen color), the distance to the center and the batch
+    typedef void (*DihedralKernel)(const QLineF &, QPointF, const qreal *, QRgb, const ColorEngine *, double, QVector<MandalaSegment> &);
+
+private:
+    SymmetrySettings _settings;
+    QPointF _center;
+    int _slices = 0;
+    bool _mirror = false;
+    QRectF _visibleArea;
+
+    // _copies are the transforms of the group (for the wallpaper groups, the operations of one tile), _colorCount the number of colors they use
+    QVector<SymmetryCopy> _copies;
+    int _colorCount = 1;
+
+    // _kernel is the specialised kernel of the dihedral group (nullptr: the generic transforms are used), _mirrorMatrix the linear part of the mirror
+    bool _kernelsEnabled = true;
+    DihedralKernel _kernel = nullptr;
+    qreal _mirrorMatrix[4];
+
+    // The wallpaper lattice: its basis vectors (in pixels), the transform from the scene to the lattice coordinates, and the visible area in lattice coordinates
+    QPointF _latticeA;
+    QPointF _latticeB;
+    QTransform _toLattice;
+    QRectF _visibleLattice;
+
+    /**
+     * @brief Precompute the transforms of the group
+     *
+     */
+    void rebuild();
+
+    /**
+     * @brief Append the transforms of the dihedral group around the symmetry center, followed by a placement transform
+     * @param The placement transform (it moves the copies to a kaleidoscope center)
+     *
+     */
+    void appendDihedral(const QTransform &);
+
+    /**
+     * @brief Append the transforms of a wallpaper group (around the lattice origin)
+     *
+     */
+    void appendWallpaper();
+};
+
+#endif // SYMMETRYENGINE_H
@@ -0,0 +1,57 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   symmetryPanel.h
+ * @date   October 2026
+ *
+ * @brief  symmetryPanel is the dock panel that let the user choose the symmetry group of the mandala mode (dihedral, wallpaper or kaleidoscope) and its settings
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef SYMMETRYPANEL_H
+#define SYMMETRYPANEL_H
+
+#include <QDockWidget>
+#include "symmetryEngine.h"
+
+class QComboBox;
+class QSpinBox;
+
+class SymmetryPanel : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SymmetryPanel(QWidget *parent = nullptr);
+
+    /**
+     * @brief Let us get the symmetry settings chosen in the panel
+     * @return The symmetry settings
+     *
+     */
+    SymmetrySettings settings() const;
+
+    /**
+     * @brief Show the symmetry settings of another document, without telling it to the view
+     * @param The symmetry settings
+     *
+     */
+    void setSettings(const SymmetrySettings &);
+
+private:
+    QComboBox * _modeComboBox;
+    QSpinBox * _mirrorAngleSpinBox;
+    QComboBox * _wallpaperGroupComboBox;
+    QSpinBox * _cellSizeSpinBox;
+    QSpinBox * _centersSpinBox;
+    QSpinBox * _radiusSpinBox;
+
+signals:
+    void symmetryChanged(SymmetrySettings);
+
+private slots:
+    void emitSymmetryChanged();
+};
+
+#endif // SYMMETRYPANEL_H
@@ -0,0 +1,136 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   thumbnailModel.h
+ * @date   October 2026
+ *
+ * @brief  thumbnailModel is the list model of the images of a directory: the thumbnails are decoded on a thread pool (only the rows the view asks for),
+ * cached in memory and on the disk (the disk cache is keyed by the image path and its last modification time)
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef THUMBNAILMODEL_H
+#define THUMBNAILMODEL_H
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QDateTime>
+#include <QImage>
+#include <QMutex>
+#include <QPixmap>
+#include <QSet>
+#include <QSize>
+#include <QThreadPool>
+#include <QVector>
+
+class ThumbnailModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    // PathRole is the role of the image absolute path
+    enum { PathRole = Qt::UserRole + 1 };
+
+    explicit ThumbnailModel(QObject *parent = nullptr);
+    ~ThumbnailModel() override;
+
+    /**
+     * @brief List the images (png, jpg, jpeg, bmp) of a directory: nothing is decoded until the view shows the rows
+     * @param The directory path
+     *
+     */
+    void setDirectory(const QString &);
+
+    /**
+     * @brief Let us get the listed directory
+     * @return The directory path
+     *
+     */
+    QString directory() const;
+
+    /**
+     * @brief Set the size in which the thumbnails fit
+     * @param The thumbnail size
+     *
+     */
+    void setThumbnailSize(QSize);
+
+    int rowCount(const QModelIndex & parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &, int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief Let us get the path of the disk cache file of a thumbnail
+     * @param The image path
+     * @param The image last modification time
+     * @param The thumbnail size
+     * @return The cache file path
+     *
+     */
+    static QString cachePath(const QString &, const QDateTime &, QSize);
+
+    /**
+     * @brief Load a thumbnail: from the disk cache if it is there, else decoded at the thumbnail size with QImageReader::setScaledSize (and saved in the disk cache).
+     * It is called by the worker threads.
+     * @param The image path
+     * @param The image last modification time
+     * @param The thumbnail size
+     * @return The thumbnail
+     *
+     */
+    static QImage loadThumbnail(const QString &, const QDateTime &, QSize);
+
+private:
+    struct Entry {
+        QString path;
+        QString name;
+        QDateTime lastModified;
+    };
+
+    QString _directory;
+    QVector<Entry> _entries;
+    QSize _thumbnailSize = QSize(96, 96);
+
+    // _generation changes each time we list a directory, so that we forget the thumbnails of the previous one
+    int _generation = 0;
+
+    // _thumbnails is the memory cache (cost in kilobytes), _requested are the rows being loaded
+    mutable QCache<int, QPixmap> _thumbnails;
+    mutable QSet<int> _requested;
+
+    // _memoryConsumer is the identifier of the thumbnails cache in the memory manager
+    int _memoryConsumer;
+
+    // Request is a thumbnail to load: the workers never read _entries, the GUI thread may list another directory meanwhile
+    struct Request {
+        int generation;
+        int row;
+        QString path;
+        QDateTime lastModified;
+        QSize size;
+    };
+
+    // _pendingRequests is shared with the workers: the last request is loaded first (the rows on screen after a scroll)
+    mutable QMutex _pendingMutex;
+    mutable QVector<Request> _pendingRequests;
+    mutable int _activeWorkers = 0;
+    QThreadPool _threadPool;
+
+    /**
+     * @brief Queue the loading of a thumbnail and start a worker if needed
+     * @param The row of the thumbnail
+     *
+     */
+    void requestThumbnail(int) const;
+
+    /**
+     * @brief The loop of a worker: it loads the pending thumbnails until there is none left
+     *
+     */
+    void runWorker();
+
+private slots:
+    void thumbnailLoaded(int, int, QImage);
+};
+
+#endif // THUMBNAILMODEL_H
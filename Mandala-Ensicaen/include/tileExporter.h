@@ -0,0 +1,77 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   tileExporter.h
+ * @date   October 2026
+ *
+ * @brief  tileExporter exports a seamless tile of a wallpaper mandala with its mip-mapped downscales (box or Lanczos filtered pyramid, computed on all the CPU cores),
+ * as separate images or packed in an atlas, with a JSON manifest. It never touches the widgets: it runs on a worker thread
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef TILEEXPORTER_H
+#define TILEEXPORTER_H
+
+#include <QImage>
+#include <QJsonObject>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+// TileExportSettings defines how we export a tile
+struct TileExportSettings {
+    enum Filter { Box, Lanczos };
+
+    Filter filter = Lanczos;
+    // atlas packs the pyramid in one image (the downscales in a column on the right of the tile), else each level is saved in its own image
+    bool atlas = true;
+    // levels is the maximum number of levels of the pyramid (the tile included), 0 goes down to one pixel
+    int levels = 0;
+};
+
+class TileExporter
+{
+public:
+    /**
+     * @brief Compute the mip pyramid of a seamless tile: each level halves the previous one, and the filter wraps around the tile borders so that every level stays seamless
+     * @param The tile (the level 0)
+     * @param The filter
+     * @param The maximum number of levels (0: down to one pixel)
+     * @return The levels of the pyramid
+     *
+     */
+    static QVector<QImage> mipPyramid(const QImage &, TileExportSettings::Filter, int);
+
+    /**
+     * @brief Pack a mip pyramid in one image: the level 0 on the left, and the next levels in a column on its right
+     * @param The levels of the pyramid
+     * @param The rectangles of the levels in the atlas (output)
+     * @return The atlas
+     *
+     */
+    static QImage packAtlas(const QVector<QImage> &, QVector<QRect> &);
+
+    /**
+     * @brief Compute the pyramid of a tile and save it with its JSON manifest (file name with a .json extension)
+     * @param The tile
+     * @param The export settings
+     * @param The file name of the atlas (or the base name of the level images: name_mip0.png, name_mip1.png...)
+     * @param What we describe in the manifest besides the levels (symmetry group, tile size...)
+     * @return An error message, empty if the export succeeded
+     *
+     */
+    static QString exportTile(const QImage &, const TileExportSettings &, const QString &, const QJsonObject &);
+
+private:
+    /**
+     * @brief Compute a level of the pyramid from the previous one, a band of rows after the other on all the CPU cores
+     * @param The previous level
+     * @param The filter
+     * @return The level
+     *
+     */
+    static QImage halve(const QImage &, TileExportSettings::Filter);
+};
+
+#endif // TILEEXPORTER_H
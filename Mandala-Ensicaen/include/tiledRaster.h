@@ -0,0 +1,151 @@
+/** -*- mode: c++ ; c-basic-offset: 3 -*-
+ * @file   tiledRaster.h
+ * @date   October 2026
+ *
+ * @brief  tiledRaster is a sparse raster image made of fixed size square tiles: a tile is only allocated once something is painted on it
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#ifndef TILEDRASTER_H
+#define TILEDRASTER_H
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QPoint>
+#include <QRect>
+#include <QRectF>
+#include <functional>
+
+class QPainter;
+
+class TiledRaster
+{
+public:
+    // TileSize is the side (in scene pixels) of every tile of the raster: a tile has TileSize * scale() device pixels on each side
+    static const int TileSize = 256;
+
+    TiledRaster();
+
+    /**
+     * @brief Set the device pixel ratio of the tiles (2 on a HiDPI screen): the tiles are resampled once to the new resolution, and the tiles
+     * of the previous resolution are kept so that they are reused as they are if we come back to it before anything is painted
+     * @param The device pixel ratio
+     *
+     */
+    void setScale(qreal);
+
+    /**
+     * @brief Let us get the device pixel ratio of the tiles
+     * @return The device pixel ratio
+     *
+     */
+    qreal scale() const;
+
+    /**
+     * @brief Let us get the tile at the given tile coordinates, the tile is allocated (fully transparent) if it doesn't exist yet
+     * @param The tile coordinates (the scene coordinates divided by TileSize)
+     * @return The tile image
+     *
+     */
+    QImage & tile(const QPoint &);
+
+    /**
+     * @brief Let us know if a tile has already been allocated
+     * @param The tile coordinates
+     * @return True if the tile exists, and false if not
+     *
+     */
+    bool hasTile(const QPoint &) const;
+
+    /**
+     * @brief Compute the range of tile coordinates covering a scene rectangle
+     * @param The scene rectangle
+     * @return The rectangle of tile coordinates (left/top are the first tile, right/bottom the last one)
+     *
+     */
+    static QRect tileRange(const QRectF &);
+
+    /**
+     * @brief Compute the scene rectangle covered by a tile
+     * @param The tile coordinates
+     * @return The scene rectangle of the tile
+     *
+     */
+    static QRect tileRect(const QPoint &);
+
+    /**
+     * @brief Paint the allocated tiles that intersect the exposed rectangle
+     * @param The painter (in scene coordinates)
+     * @param The exposed scene rectangle
+     *
+     */
+    void paint(QPainter *, const QRectF &) const;
+
+    /**
+     * @brief Paint on the raster through every tile covering a scene rectangle: the drawing function is called once per tile with a painter in scene coordinates
+     * @param The scene rectangle covered by the drawing
+     * @param The drawing function
+     *
+     */
+    void render(const QRectF &, const std::function<void(QPainter *)> &);
+
+    /**
+     * @brief Paint an image over the raster, allocating the tiles it covers
+     * @param The scene position of the image top left corner
+     * @param The image to paint
+     *
+     */
+    void drawImage(const QPointF &, const QImage &);
+
+    /**
+     * @brief Free all the tiles
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Make every allocated tile fully transparent again, keeping its memory: a raster reused for the next drawing doesn't allocate its tiles again
+     *
+     */
+    void eraseTiles();
+
+    /**
+     * @brief Let us know if nothing has been painted on the raster
+     * @return True if no tile is allocated, and false if not
+     *
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Let us get the memory used by the allocated tiles
+     * @return The bytes of the tiles
+     *
+     */
+    qint64 byteCount() const;
+
+private:
+    // _tiles stores the allocated tiles, the key packs the tile coordinates (see tileKey())
+    QHash<quint64, QImage> _tiles;
+    qreal _scale = 1;
+
+    // _generation changes whenever the tiles may change: _previousTiles (at _previousScale) are only reused if it didn't change since we left them
+    quint64 _generation = 0;
+    QHash<quint64, QImage> _previousTiles;
+    qreal _previousScale = 0;
+    quint64 _previousGeneration = 0;
+
+    /**
+     * @brief Let us get the side of a tile in device pixels
+     * @return The side of a tile
+     *
+     */
+    int tileSide() const;
+
+    static quint64 tileKey(const QPoint &);
+};
+
+#endif // TILEDRASTER_H
@@ -23,14 +23,14 @@ public:
     explicit WidgetDrawLineWidth(QWidget *parent = nullptr);
 
     /**
-     * @brief Set the size of the pen used to draw the point defining the pen we use in the QGraphicsView
+     * @brief Set the size of the pen used to draw the point defining the pen we use in the QGraphicsView (the widget is painted again only if it changed)
      * @param The size of the pen
      *
      */
     void setPenSize(int);
 
     /**
-     * @brief Set the color of the pen used to draw the point defining the pen we use in the QGraphicsView
+     * @brief Set the color of the pen used to draw the point defining the pen we use in the QGraphicsView (the widget is painted again only if it changed)
      * @param The color of the pen
      *
      */
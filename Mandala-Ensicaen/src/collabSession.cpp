@@ -0,0 +1,559 @@
+/**
+ * @file   collabSession.cpp
+ * @date   October 2026
+ *
+ * @brief  collabSession lets several instances of the application draw on one mandala: a relay server orders the messages of the clients and
+ * forwards them, and each client sends the points of its strokes as compact deltas batched per frame. The symmetry copies are never sent:
+ * every client projects the strokes it receives with its own symmetry
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "collabSession.h"
+#include "symmetryEngine.h"
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QLineF>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <limits.h>
+#include <math.h>
+
+const quint16 CollabServer::DefaultPort = 47820;
+const int CollabServer::MaxFrameBytes = 65535;
+const int CollabSession::FrameInterval = 16;
+const int CollabSession::PointQuantum = 8;
+const int CollabSession::MinPenWidth = 2;
+const int CollabSession::MaxPenWidth = 15;
+
+namespace {
+    const quint32 SessionMagic = 0x4D434F4C;
+    const quint16 SessionVersion = 1;
+
+    // PointsPerMessage bounds the points of a message: a frame never gets larger than MaxFrameBytes
+    const int PointsPerMessage = 4096;
+
+    // The numbers are written as varints (7 bits per byte), the signed ones zigzag encoded first: the small deltas of a stroke take a byte each
+    void appendVarint(QByteArray & out, quint32 value) {
+        while(value >= 0x80) {
+            out.append(char(value | 0x80));
+            value >>= 7;
+        }
+        out.append(char(value));
+    }
+
+    void appendSigned(QByteArray & out, qint32 value) {
+        appendVarint(out, (quint32(value) << 1) ^ quint32(value >> 31));
+    }
+
+    bool readVarint(const QByteArray & data, int & position, quint32 & value) {
+        value = 0;
+        for(int shift=0; shift<35; shift+=7) {
+            if(position >= data.size())
+                return false;
+            quint8 byte = quint8(data[position++]);
+            value |= quint32(byte & 0x7F) << shift;
+            if(!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    bool readSigned(const QByteArray & data, int & position, qint32 & value) {
+        quint32 encoded;
+        if(!readVarint(data, position, encoded))
+            return false;
+        value = qint32(encoded >> 1) ^ -qint32(encoded & 1);
+        return true;
+    }
+
+    void appendFrame(QByteArray & out, int type, const QByteArray & content) {
+        int size = content.size() + 1;
+        out.append(char(size >> 8));
+        out.append(char(size & 0xFF));
+        out.append(char(type));
+        out.append(content);
+    }
+
+    // Let us take the next complete frame of the bytes received (a frame of size 0 gets the type 0, which no one accepts)
+    bool takeFrame(QByteArray & pending, int & type, QByteArray & content) {
+        if(pending.size() < 2)
+            return false;
+        int size = (quint8(pending[0]) << 8) | quint8(pending[1]);
+        if(pending.size() < 2 + size)
+            return false;
+        type = size > 0 ? quint8(pending[2]) : 0;
+        content = size > 1 ? pending.mid(3, size - 1) : QByteArray();
+        pending.remove(0, 2 + size);
+        return true;
+    }
+
+    QPoint quantize(QPointF point) {
+        return QPoint(qRound(point.x() * CollabSession::PointQuantum), qRound(point.y() * CollabSession::PointQuantum));
+    }
+
+    QPointF unquantize(QPoint point) {
+        return QPointF(point) / CollabSession::PointQuantum;
+    }
+
+    void waitFor(int milliseconds) {
+        QEventLoop loop;
+        QTimer::singleShot(milliseconds, &loop, SLOT(quit()));
+        loop.exec();
+    }
+}
+
+CollabServer::CollabServer(QObject *parent) : QObject(parent), _server(new QTcpServer(this)) {
+    connect(_server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+}
+
+bool CollabServer::listen(const QHostAddress & address, quint16 port) {
+    if(_server->listen(address, port))
+        return true;
+    _error = _server->errorString();
+    return false;
+}
+
+QString CollabServer::errorString() const {
+    return _error;
+}
+
+quint16 CollabServer::port() const {
+    return _server->serverPort();
+}
+
+QJsonObject CollabServer::stats() const {
+    QJsonObject stats;
+    stats["clients"] = _clients.size();
+    stats["sequence"] = double(_sequence);
+    stats["framesRelayed"] = double(_framesRelayed);
+    stats["bytesReceived"] = double(_bytesReceived);
+    stats["bytesSent"] = double(_bytesSent);
+    stats["logBytes"] = _log.size();
+    return stats;
+}
+
+void CollabServer::newConnection() {
+    while(_server->hasPendingConnections()) {
+        QTcpSocket * client = _server->nextPendingConnection();
+        // The frames are small and sent once per frame: they mustn't wait for the acknowledgement of the previous ones
+        client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(client, SIGNAL(readyRead()), this, SLOT(readClient()));
+        connect(client, SIGNAL(disconnected()), this, SLOT(clientDisconnected()));
+        connect(client, SIGNAL(disconnected()), client, SLOT(deleteLater()));
+    }
+}
+
+void CollabServer::readClient() {
+    QTcpSocket * client = qobject_cast<QTcpSocket *>(sender());
+    if(!client)
+        return;
+
+    QByteArray & pending = _pending[client];
+    QByteArray data = client->readAll();
+    _bytesReceived += data.size();
+    pending += data;
+
+    int type;
+    QByteArray content;
+    while(takeFrame(pending, type, content)) {
+        if(!handleFrame(client, type, content)) {
+            client->abort();
+            return;
+        }
+    }
+}
+
+bool CollabServer::handleFrame(QTcpSocket * client, int type, const QByteArray & content) {
+    if(type == Hello) {
+        int position = 0;
+        quint32 magic, version;
+        if(_clients.contains(client) || !readVarint(content, position, magic) || !readVarint(content, position, version)
+                || magic != SessionMagic || version != SessionVersion)
+            return false;
+
+        // The new client gets its number, then the drawing done before it joined
+        quint32 id = _nextClient++;
+        _clients.insert(client, id);
+        QByteArray welcome, number;
+        appendVarint(number, id);
+        appendFrame(welcome, Welcome, number);
+        welcome += _log;
+        client->write(welcome);
+        _bytesSent += welcome.size();
+        return true;
+    }
+
+    if((type != StrokeBegin && type != StrokePoints && type != StrokeEnd) || !_clients.contains(client) || content.size() + 11 > MaxFrameBytes)
+        return false;
+
+    // The server only reads the stroke number of the messages (never their points): the stroke a client leaves unfinished is finished for it
+    int position = 0;
+    quint32 stroke;
+    if(!readVarint(content, position, stroke))
+        return false;
+    if(type == StrokeBegin)
+        _openStrokes.insert(client, stroke);
+    else if(type == StrokeEnd)
+        _openStrokes.remove(client);
+    relay(client, type, content);
+    return true;
+}
+
+void CollabServer::relay(QTcpSocket * client, int type, const QByteArray & content) {
+    QByteArray relayed;
+    appendVarint(relayed, ++_sequence);
+    appendVarint(relayed, _clients.value(client));
+    relayed += content;
+    QByteArray frame;
+    appendFrame(frame, type, relayed);
+    _log += frame;
+    ++_framesRelayed;
+    for(auto iter = _clients.begin(); iter != _clients.end(); ++iter) {
+        if(iter.key() != client) {
+            iter.key()->write(frame);
+            _bytesSent += frame.size();
+        }
+    }
+}
+
+void CollabServer::clientDisconnected() {
+    QTcpSocket * client = qobject_cast<QTcpSocket *>(sender());
+    if(_openStrokes.contains(client)) {
+        QByteArray content;
+        appendVarint(content, _openStrokes.take(client));
+        relay(client, StrokeEnd, content);
+    }
+    _clients.remove(client);
+    _pending.remove(client);
+}
+
+CollabSession::CollabSession(QObject *parent) : QObject(parent), _socket(new QTcpSocket(this)) {
+    _frameTimer.setSingleShot(true);
+    _frameTimer.setInterval(FrameInterval);
+    connect(&_frameTimer, SIGNAL(timeout()), this, SLOT(sendFrame()));
+    connect(_socket, SIGNAL(connected()), this, SLOT(socketConnected()));
+    connect(_socket, SIGNAL(readyRead()), this, SLOT(readServer()));
+    connect(_socket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
+    connect(_socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(socketError()));
+}
+
+void CollabSession::connectToHost(const QString & host, quint16 port) {
+    disconnectFromHost();
+    _pending.clear();
+    _remotePoints.clear();
+    _lastSequence = 0;
+    _bytesSent = 0;
+    _bytesReceived = 0;
+    _socket->connectToHost(host, port);
+}
+
+void CollabSession::disconnectFromHost() {
+    if(_drawing)
+        endStroke();
+    sendFrame();
+    _socket->disconnectFromHost();
+    _clientId = 0;
+}
+
+bool CollabSession::isConnected() const {
+    return _clientId != 0 && _socket->state() == QAbstractSocket::ConnectedState;
+}
+
+quint32 CollabSession::clientId() const {
+    return _clientId;
+}
+
+qint64 CollabSession::bytesSent() const {
+    return _bytesSent;
+}
+
+qint64 CollabSession::bytesReceived() const {
+    return _bytesReceived;
+}
+
+void CollabSession::beginStroke(CollabStroke stroke, QPointF point) {
+    if(!isConnected())
+        return;
+    if(_drawing)
+        endStroke();
+
+    _drawing = true;
+    _lastPoint = quantize(point);
+    QByteArray content;
+    appendVarint(content, ++_stroke);
+    appendVarint(content, quint32(qMax(0, stroke.layer)));
+    appendVarint(content, quint32(qMax(0, stroke.penWidth)));
+    appendVarint(content, stroke.color);
+    appendVarint(content, quint32(stroke.colorStroke));
+    content.append(char(stroke.symmetric ? 1 : 0));
+    appendSigned(content, _lastPoint.x());
+    appendSigned(content, _lastPoint.y());
+    appendFrame(_outgoing, CollabServer::StrokeBegin, content);
+    if(!_frameTimer.isActive())
+        _frameTimer.start();
+}
+
+void CollabSession::addPoints(const QVector<QPointF> & points) {
+    if(!_drawing)
+        return;
+
+    // Only the moves of at least one step are sent: the others are drawn by the next point
+    for(auto iter = points.begin(); iter != points.end(); ++iter) {
+        QPoint point = quantize(*iter);
+        if(point == _lastPoint)
+            continue;
+        _pendingDeltas.push_back(point - _lastPoint);
+        _lastPoint = point;
+    }
+    if(!_pendingDeltas.isEmpty() && !_frameTimer.isActive())
+        _frameTimer.start();
+}
+
+void CollabSession::endStroke() {
+    if(!_drawing)
+        return;
+
+    framePoints();
+    QByteArray content;
+    appendVarint(content, _stroke);
+    appendFrame(_outgoing, CollabServer::StrokeEnd, content);
+    _drawing = false;
+    if(!_frameTimer.isActive())
+        _frameTimer.start();
+}
+
+void CollabSession::framePoints() {
+    for(int first=0; first<_pendingDeltas.size(); first+=PointsPerMessage) {
+        int count = qMin(PointsPerMessage, _pendingDeltas.size() - first);
+        QByteArray content;
+        appendVarint(content, _stroke);
+        appendVarint(content, quint32(count));
+        for(int i=first; i<first+count; ++i) {
+            appendSigned(content, _pendingDeltas[i].x());
+            appendSigned(content, _pendingDeltas[i].y());
+        }
+        appendFrame(_outgoing, CollabServer::StrokePoints, content);
+    }
+    _pendingDeltas.clear();
+}
+
+void CollabSession::sendFrame() {
+    // All the messages of the frame go in one write
+    framePoints();
+    if(_outgoing.isEmpty())
+        return;
+    if(_socket->state() == QAbstractSocket::ConnectedState) {
+        _socket->write(_outgoing);
+        _bytesSent += _outgoing.size();
+    }
+    _outgoing.clear();
+}
+
+void CollabSession::socketConnected() {
+    _socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    QByteArray hello, content;
+    appendVarint(content, SessionMagic);
+    appendVarint(content, SessionVersion);
+    appendFrame(hello, CollabServer::Hello, content);
+    _socket->write(hello);
+    _bytesSent += hello.size();
+}
+
+void CollabSession::readServer() {
+    QByteArray data = _socket->readAll();
+    _bytesReceived += data.size();
+    _pending += data;
+
+    int type;
+    QByteArray content;
+    while(takeFrame(_pending, type, content)) {
+        if(!handleFrame(type, content)) {
+            _socket->abort();
+            emit left(tr("The session server sent a malformed message"));
+            return;
+        }
+    }
+}
+
+bool CollabSession::handleFrame(int type, const QByteArray & content) {
+    int position = 0;
+    if(type == CollabServer::Welcome) {
+        if(!readVarint(content, position, _clientId))
+            return false;
+        emit joined(_clientId);
+        return true;
+    }
+
+    quint32 sequence, client, stroke;
+    if(!readVarint(content, position, sequence) || !readVarint(content, position, client) || !readVarint(content, position, stroke))
+        return false;
+    // The messages are applied in the order of the server
+    if(sequence <= _lastSequence)
+        return true;
+    _lastSequence = sequence;
+    quint64 key = (quint64(client) << 32) | stroke;
+
+    if(type == CollabServer::StrokeBegin) {
+        quint32 layer, penWidth, color, colorStroke;
+        qint32 x, y;
+        if(!readVarint(content, position, layer) || !readVarint(content, position, penWidth) || !readVarint(content, position, color)
+                || !readVarint(content, position, colorStroke) || position >= content.size())
+            return false;
+        // The server doesn't check the strokes it relays: a pen width or a color stroke we would never send isn't drawn
+        if(penWidth < quint32(MinPenWidth) || penWidth > quint32(MaxPenWidth) || colorStroke > quint32(INT_MAX))
+            return false;
+        bool symmetric = content[position++] != 0;
+        if(!readSigned(content, position, x) || !readSigned(content, position, y))
+            return false;
+        _remotePoints.insert(key, QPoint(x, y));
+        emit remoteStrokeBegan(key, {int(layer), int(penWidth), color, int(colorStroke), symmetric}, unquantize(QPoint(x, y)));
+    } else if(type == CollabServer::StrokePoints) {
+        quint32 count;
+        if(!readVarint(content, position, count) || !_remotePoints.contains(key))
+            return false;
+        QPoint point = _remotePoints.value(key);
+        QVector<QPointF> points;
+        points.reserve(qMin(count, quint32(PointsPerMessage)));
+        for(quint32 i=0; i<count; ++i) {
+            qint32 dx, dy;
+            if(!readSigned(content, position, dx) || !readSigned(content, position, dy))
+                return false;
+            point += QPoint(dx, dy);
+            points.push_back(unquantize(point));
+        }
+        _remotePoints.insert(key, point);
+        emit remoteStrokePoints(key, points);
+    } else if(type == CollabServer::StrokeEnd) {
+        _remotePoints.remove(key);
+        emit remoteStrokeEnded(key);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void CollabSession::socketDisconnected() {
+    // The strokes the other clients were drawing are finished as they are
+    QList<quint64> strokes = _remotePoints.keys();
+    _remotePoints.clear();
+    for(auto iter = strokes.begin(); iter != strokes.end(); ++iter)
+        emit remoteStrokeEnded(*iter);
+
+    // We left by ourselves if disconnectFromHost() forgot our number already
+    QString reason = _clientId ? _socket->errorString() : QString();
+    _drawing = false;
+    _pendingDeltas.clear();
+    _outgoing.clear();
+    _clientId = 0;
+    emit left(reason);
+}
+
+void CollabSession::socketError() {
+    // A session we could not join never gets disconnected(): it is reported here
+    if(_clientId == 0 && _socket->state() != QAbstractSocket::ConnectedState)
+        emit left(_socket->errorString());
+}
+
+QStringList CollabSession::runLoopback(int clientCount, int slices, int duration) {
+    QStringList report;
+    CollabServer server;
+    if(!server.listen(QHostAddress::LocalHost, 0))
+        return report << server.errorString();
+
+    clientCount = qMax(2, clientCount);
+    QVector<CollabSession *> clients;
+    for(int i=0; i<clientCount; ++i) {
+        clients.push_back(new CollabSession);
+        clients.last()->connectToHost("127.0.0.1", server.port());
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    int joined = 0;
+    while(joined < clientCount && clock.elapsed() < 5000) {
+        waitFor(10);
+        joined = 0;
+        for(auto iter = clients.begin(); iter != clients.end(); ++iter)
+            joined += (*iter)->isConnected() ? 1 : 0;
+    }
+    if(joined < clientCount) {
+        qDeleteAll(clients);
+        return report << QString("Only %1 of %2 clients joined the loopback session").arg(joined).arg(clientCount);
+    }
+
+    // Each receiving client projects the points it gets with its own symmetry: that is the work the senders never do for them
+    SymmetryEngine symmetry;
+    symmetry.setCenter(QPointF(500, 500));
+    symmetry.setSlices(slices);
+    symmetry.setMirror(true);
+    QVector<QPointF> drawn;
+    QVector<int> received(clientCount, 0);
+    QVector<qint64> segments(clientCount, 0);
+    QVector<double> largestError(clientCount, 0);
+    QVector<QPointF> previous(clientCount);
+    for(int i=1; i<clientCount; ++i) {
+        connect(clients[i], &CollabSession::remoteStrokeBegan, clients[i], [&, i](quint64, CollabStroke, QPointF point) {
+            largestError[i] = qMax(largestError[i], QLineF(point, drawn.value(received[i], point)).length());
+            previous[i] = point;
+            ++received[i];
+        });
+        connect(clients[i], &CollabSession::remoteStrokePoints, clients[i], [&, i](quint64, QVector<QPointF> points) {
+            QVector<MandalaSegment> batch;
+            batch.reserve(points.size() * symmetry.copyCount());
+            for(auto iter = points.begin(); iter != points.end(); ++iter) {
+                largestError[i] = qMax(largestError[i], QLineF(*iter, drawn.value(received[i], *iter)).length());
+                symmetry.apply(QLineF(previous[i], *iter), 0xFFFFFFFF, nullptr, batch);
+                previous[i] = *iter;
+                ++received[i];
+            }
+            segments[i] += batch.size();
+        });
+    }
+
+    // The first client draws a spiral with the mouse rate of a screen (125 Hz), in strokes of 2 seconds
+    const int MouseInterval = 8;
+    CollabStroke stroke = {0, 2, 0xFF2060C0, 0, true};
+    clock.restart();
+    int step = 0;
+    while(clock.elapsed() < duration) {
+        double angle = step * 0.05;
+        QPointF point(500 + (60 + step * 0.05) * cos(angle), 500 + (60 + step * 0.05) * sin(angle));
+        drawn.push_back(point);
+        if(step % 250 == 0)
+            clients[0]->beginStroke(stroke, point);
+        else
+            clients[0]->addPoints(QVector<QPointF>() << point);
+        ++step;
+        waitFor(MouseInterval);
+    }
+    clients[0]->endStroke();
+    double seconds = clock.elapsed() / 1000.0;
+
+    // The last frames are given the time to arrive
+    clock.restart();
+    bool complete = false;
+    while(!complete && clock.elapsed() < 2000) {
+        waitFor(10);
+        complete = true;
+        for(int i=1; i<clientCount; ++i)
+            complete = complete && received[i] == drawn.size();
+    }
+
+    report << QString("loopback session: %1 clients, %2 slices, %3 points drawn at %4 Hz in %5 s")
+              .arg(clientCount).arg(slices).arg(drawn.size()).arg(1000 / MouseInterval).arg(seconds, 0, 'f', 1);
+    report << QString("client 1 (drawing): sent %1 bytes, %2 KB/s, %3 bytes per point")
+              .arg(clients[0]->bytesSent()).arg(clients[0]->bytesSent() / seconds / 1024, 0, 'f', 2)
+              .arg(double(clients[0]->bytesSent()) / qMax(1, drawn.size()), 0, 'f', 2);
+    for(int i=1; i<clientCount; ++i)
+        report << QString("client %1: received %2/%3 points, %4 KB/s, %5 segments projected locally, largest error %6 px")
+                  .arg(i + 1).arg(received[i]).arg(drawn.size()).arg(clients[i]->bytesReceived() / seconds / 1024, 0, 'f', 2)
+                  .arg(segments[i]).arg(largestError[i], 0, 'f', 3);
+    report << QString("server: %1").arg(QString::fromUtf8(QJsonDocument(server.stats()).toJson(QJsonDocument::Compact)));
+
+    qDeleteAll(clients);
+    return report;
+}
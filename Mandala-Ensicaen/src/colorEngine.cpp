@@ -0,0 +1,137 @@
+/**
+ * @file   colorEngine.cpp
+ * @date   October 2026
+ *
+ * @brief  colorEngine gives the colors of the rainbow mode: a palette (HSV wheel, gradient, per stroke cycle or radial) is precomputed in a lookup table
+ * each time its settings change, so that the color of a drawn segment is an index in a flat array
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "colorEngine.h"
+#include <math.h>
+
+const int ColorEngine::StrokeCycleLength = 16;
+const int ColorEngine::RadialSteps = 256;
+
+ColorEngine::ColorEngine() {
+    _gradientStops << QGradientStop(0, QColor(255, 0, 128)) << QGradientStop(0.5, QColor(255, 200, 0)) << QGradientStop(1, QColor(0, 160, 255));
+    rebuild();
+}
+
+void ColorEngine::setPalette(Palette palette) {
+    if(palette != _palette) {
+        _palette = palette;
+        rebuild();
+    }
+}
+
+ColorEngine::Palette ColorEngine::palette() const {
+    return _palette;
+}
+
+void ColorEngine::setBaseColor(QColor baseColor) {
+    if(baseColor != _baseColor) {
+        _baseColor = baseColor;
+        rebuild();
+    }
+}
+
+void ColorEngine::setCopyCount(int copyCount) {
+    if(copyCount != _copyCount) {
+        _copyCount = copyCount;
+        rebuild();
+    }
+}
+
+void ColorEngine::setGradientStops(const QGradientStops & gradientStops) {
+    if(!gradientStops.isEmpty()) {
+        _gradientStops = gradientStops;
+        rebuild();
+    }
+}
+
+QGradientStops ColorEngine::gradientStops() const {
+    return _gradientStops;
+}
+
+void ColorEngine::setRadius(double radius) {
+    _radius = qMax(1.0, radius);
+    _radialScale = (RadialSteps - 1) / _radius;
+}
+
+void ColorEngine::nextStroke() {
+    ++_stroke;
+}
+
+void ColorEngine::setStroke(int stroke) {
+    _stroke = stroke;
+}
+
+int ColorEngine::stroke() const {
+    return _stroke;
+}
+
+QRgb ColorEngine::color(int copy, double distance) const {
+    switch(_palette) {
+    case StrokeCycle:
+        // The stroke number of another client may be anything: the remainder stays in the table
+        return _lookupTable[((_stroke % StrokeCycleLength) + StrokeCycleLength) % StrokeCycleLength];
+    case Radial:
+        return _lookupTable[qMin(RadialSteps - 1, int(distance * _radialScale))];
+    default:
+        return _lookupTable[copy];
+    }
+}
+
+QRgb ColorEngine::gradientColor(const QGradientStops & gradientStops, double position) {
+    if(position <= gradientStops.first().first)
+        return gradientStops.first().second.rgba();
+    for(int i=1; i<gradientStops.size(); ++i) {
+        if(position <= gradientStops[i].first) {
+            const QGradientStop & from = gradientStops[i-1];
+            const QGradientStop & to = gradientStops[i];
+            double t = (to.first > from.first) ? (position - from.first) / (to.first - from.first) : 1;
+            QColor c = QColor::fromRgbF(from.second.redF() + t * (to.second.redF() - from.second.redF()),
+                                        from.second.greenF() + t * (to.second.greenF() - from.second.greenF()),
+                                        from.second.blueF() + t * (to.second.blueF() - from.second.blueF()),
+                                        from.second.alphaF() + t * (to.second.alphaF() - from.second.alphaF()));
+            return c.rgba();
+        }
+    }
+    return gradientStops.last().second.rgba();
+}
+
+void ColorEngine::rebuild() {
+    // The hue steps are computed in floating point: 360 degrees are shared evenly between the copies, whatever their number
+    QColor base = _baseColor.toHsv();
+    double hue = qMax(0.0, base.hueF());
+    int copies = qMax(1, _copyCount);
+
+    _lookupTable.clear();
+    switch(_palette) {
+    case HsvWheel:
+        _lookupTable.reserve(copies);
+        for(int i=0; i<copies; ++i)
+            _lookupTable.push_back(QColor::fromHsvF(fmod(hue + double(i) / copies, 1.0), base.hsvSaturationF(), base.valueF(), base.alphaF()).rgba());
+        break;
+    case Gradient:
+        _lookupTable.reserve(copies);
+        for(int i=0; i<copies; ++i)
+            _lookupTable.push_back(gradientColor(_gradientStops, (copies > 1) ? double(i) / (copies - 1) : 0));
+        break;
+    case StrokeCycle:
+        _lookupTable.reserve(StrokeCycleLength);
+        for(int i=0; i<StrokeCycleLength; ++i)
+            _lookupTable.push_back(QColor::fromHsvF(fmod(hue + double(i) / StrokeCycleLength, 1.0), base.hsvSaturationF(), base.valueF(), base.alphaF()).rgba());
+        break;
+    case Radial:
+        _lookupTable.reserve(RadialSteps);
+        for(int i=0; i<RadialSteps; ++i)
+            _lookupTable.push_back(gradientColor(_gradientStops, double(i) / (RadialSteps - 1)));
+        break;
+    }
+    setRadius(_radius);
+}
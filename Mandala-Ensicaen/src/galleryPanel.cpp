@@ -0,0 +1,88 @@
+/**
+ * @file   galleryPanel.cpp
+ * @date   October 2026
+ *
+ * @brief  galleryPanel is the dock panel that shows the thumbnails of the mandalas of a folder: a double click opens a mandala in the painting widget
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "galleryPanel.h"
+#include "thumbnailModel.h"
+#include <QFileDialog>
+#include <QLabel>
+#include <QListView>
+#include <QPushButton>
+#include <QSettings>
+#include <QVBoxLayout>
+
+GalleryPanel::GalleryPanel(QWidget *parent) : QDockWidget(tr("Gallery"), parent) {
+    setObjectName("galleryPanel");
+
+    QWidget * content = new QWidget(this);
+    QVBoxLayout * layout = new QVBoxLayout(content);
+
+    QPushButton * folderButton = new QPushButton(tr("Open Folder..."), content);
+    layout->addWidget(folderButton);
+
+    _folderLabel = new QLabel(content);
+    _folderLabel->setWordWrap(true);
+    layout->addWidget(_folderLabel);
+
+    _model = new ThumbnailModel(this);
+    _model->setThumbnailSize(QSize(96, 96));
+
+    // All the cells have the same size and are laid out by batches: the view never asks for the rows it doesn't show,
+    // so a folder of thousands of images is listed at once and only the visible thumbnails are decoded
+    _listView = new QListView(content);
+    _listView->setViewMode(QListView::IconMode);
+    _listView->setIconSize(QSize(96, 96));
+    _listView->setGridSize(QSize(112, 128));
+    _listView->setUniformItemSizes(true);
+    _listView->setLayoutMode(QListView::Batched);
+    _listView->setBatchSize(200);
+    _listView->setMovement(QListView::Static);
+    _listView->setResizeMode(QListView::Adjust);
+    _listView->setTextElideMode(Qt::ElideMiddle);
+    _listView->setModel(_model);
+    layout->addWidget(_listView, 1);
+
+    setWidget(content);
+
+    connect(folderButton, SIGNAL(clicked()), this, SLOT(chooseFolder()));
+    connect(_listView, SIGNAL(activated(QModelIndex)), this, SLOT(emitImageActivated(QModelIndex)));
+    connect(this, SIGNAL(visibilityChanged(bool)), this, SLOT(loadLastFolder(bool)));
+}
+
+void GalleryPanel::setFolder(const QString & folder) {
+    _folderLabel->setText(folder);
+    _model->setDirectory(folder);
+
+    QSettings settings;
+    settings.setValue("gallery/folder", folder);
+}
+
+void GalleryPanel::loadLastFolder(bool visible) {
+    // The last folder is only listed when the panel is shown for the first time, not while the application starts
+    if(!visible || _lastFolderLoaded)
+        return;
+    _lastFolderLoaded = true;
+
+    QSettings settings;
+    QString folder = settings.value("gallery/folder").toString();
+    if(!folder.isEmpty() && _model->directory().isEmpty())
+        setFolder(folder);
+}
+
+void GalleryPanel::chooseFolder() {
+    QString folder = QFileDialog::getExistingDirectory(this, tr("Open A Mandalas Folder"), _model->directory());
+
+    if(!folder.isEmpty())
+        setFolder(folder);
+}
+
+void GalleryPanel::emitImageActivated(const QModelIndex & index) {
+    emit imageActivated(index.data(ThumbnailModel::PathRole).toString());
+}
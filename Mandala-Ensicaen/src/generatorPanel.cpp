@@ -0,0 +1,86 @@
+/**
+ * @file   generatorPanel.cpp
+ * @date   October 2026
+ *
+ * @brief  generatorPanel is the dock panel that let the user choose the mandala generator settings (pattern, seed, number of lines and radius)
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "generatorPanel.h"
+#include <QComboBox>
+#include <QDateTime>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+
+GeneratorPanel::GeneratorPanel(QWidget *parent) : QDockWidget(tr("Generator"), parent) {
+    setObjectName("generatorPanel");
+
+    QWidget * content = new QWidget(this);
+    QFormLayout * layout = new QFormLayout(content);
+
+    // The items order follows GeneratorSettings::Pattern
+    _patternComboBox = new QComboBox(content);
+    _patternComboBox->addItem(tr("Random strokes"));
+    _patternComboBox->addItem(tr("Rosette"));
+    _patternComboBox->addItem(tr("Spirograph"));
+    _patternComboBox->addItem(tr("L-system"));
+    _patternComboBox->setCurrentIndex(GeneratorSettings::Rosette);
+    layout->addRow(tr("Pattern"), _patternComboBox);
+
+    _seedSpinBox = new QSpinBox(content);
+    _seedSpinBox->setRange(0, 2147483647);
+    _seedSpinBox->setValue(1);
+    QPushButton * randomSeedButton = new QPushButton(tr("Random"), content);
+    QHBoxLayout * seedLayout = new QHBoxLayout();
+    seedLayout->addWidget(_seedSpinBox, 1);
+    seedLayout->addWidget(randomSeedButton);
+    layout->addRow(tr("Seed"), seedLayout);
+
+    _segmentsSpinBox = new QSpinBox(content);
+    _segmentsSpinBox->setRange(1, 1000000);
+    _segmentsSpinBox->setSingleStep(1000);
+    _segmentsSpinBox->setValue(2000);
+    layout->addRow(tr("Lines per slice"), _segmentsSpinBox);
+
+    _radiusSpinBox = new QSpinBox(content);
+    _radiusSpinBox->setRange(10, 5000);
+    _radiusSpinBox->setValue(200);
+    layout->addRow(tr("Radius"), _radiusSpinBox);
+
+    _generateButton = new QPushButton(tr("Generate"), content);
+    layout->addRow(_generateButton);
+
+    _resultLabel = new QLabel(content);
+    _resultLabel->setWordWrap(true);
+    _resultLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    layout->addRow(_resultLabel);
+
+    setWidget(content);
+
+    connect(_generateButton, SIGNAL(clicked()), this, SLOT(emitGenerateRequested()));
+    connect(randomSeedButton, SIGNAL(clicked()), this, SLOT(randomizeSeed()));
+}
+
+void GeneratorPanel::showResult(const QByteArray & fingerprint, int lines, qint64 milliseconds) {
+    _resultLabel->setText(tr("%1 lines in %2 ms\nFingerprint: %3").arg(lines).arg(milliseconds).arg(QString::fromLatin1(fingerprint)));
+}
+
+void GeneratorPanel::emitGenerateRequested() {
+    GeneratorSettings settings;
+    settings.pattern = GeneratorSettings::Pattern(_patternComboBox->currentIndex());
+    settings.seed = quint64(_seedSpinBox->value());
+    settings.segments = _segmentsSpinBox->value();
+    settings.radius = _radiusSpinBox->value();
+    emit generateRequested(settings);
+}
+
+void GeneratorPanel::randomizeSeed() {
+    // Only the seed is random: once chosen, the generation is reproducible
+    _seedSpinBox->setValue(int(QDateTime::currentMSecsSinceEpoch() % 2147483647));
+}
@@ -0,0 +1,179 @@
+/**
+ * @file   historySnapshot.cpp
+ * @date   October 2026
+ *
+ * @brief  historySnapshot is an undo/redo keyframe: the composite image is run-length encoded on a worker thread (a mandala is mostly flat colors
+ * and transparent areas), and it is only decoded when we undo or redo to it
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "historySnapshot.h"
+#include "memoryBudget.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QWeakPointer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <string.h>
+
+namespace {
+    // A token is (length << 1 | isRun): a run is followed by its pixel, a literal by its length pixels
+    const quint32 RunFlag = 1;
+
+    // A run shorter than MinimumRun is cheaper as literals
+    const int MinimumRun = 3;
+
+    QThreadPool * compressionPool() {
+        // One thread: the snapshots are compressed in the order they are pushed, and the rasterizer keeps the other cores
+        static QThreadPool * pool = []() {
+            QThreadPool * threadPool = new QThreadPool();
+            threadPool->setMaxThreadCount(1);
+            return threadPool;
+        }();
+        return pool;
+    }
+}
+
+struct HistorySnapshot::Data {
+    QMutex mutex;
+    QSize size;
+    qreal devicePixelRatio;
+    // image is kept until the compression is done, then compressed holds the encoded pixels
+    QImage image;
+    QByteArray compressed;
+    StrokeDocument document;
+};
+
+HistorySnapshot::HistorySnapshot() {
+}
+
+HistorySnapshot::HistorySnapshot(const QImage & image, const StrokeDocument & document) : _data(new Data) {
+    _data->size = image.size();
+    _data->devicePixelRatio = image.devicePixelRatio();
+    _data->document = document;
+    _data->image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    // The worker holds a weak pointer: a snapshot dropped before its turn isn't compressed. The image is shared with the
+    // composite (implicit sharing), the composite is detached by the GUI thread if it draws meanwhile
+    QWeakPointer<Data> weak = _data;
+    QtConcurrent::run(compressionPool(), [weak]() {
+        QSharedPointer<Data> data = weak.toStrongRef();
+        if(!data)
+            return;
+        QImage image;
+        {
+            QMutexLocker locker(&data->mutex);
+            image = data->image;
+        }
+        QByteArray compressed = compress(image);
+        {
+            QMutexLocker locker(&data->mutex);
+            data->compressed = compressed;
+            data->image = QImage();
+        }
+        // The memory manager shows the new usage
+        QMetaObject::invokeMethod(MemoryBudget::instance(), "requestEnforce", Qt::QueuedConnection);
+    });
+}
+
+QImage HistorySnapshot::image() const {
+    if(!_data)
+        return QImage();
+    QMutexLocker locker(&_data->mutex);
+    if(!_data->image.isNull())
+        return _data->image;
+    // The snapshot is restored at the resolution it was taken at
+    QImage image = decompress(_data->compressed, _data->size);
+    image.setDevicePixelRatio(_data->devicePixelRatio);
+    return image;
+}
+
+StrokeDocument HistorySnapshot::document() const {
+    return _data ? _data->document : StrokeDocument();
+}
+
+qint64 HistorySnapshot::byteCount() const {
+    if(!_data)
+        return 0;
+    QMutexLocker locker(&_data->mutex);
+    return _data->image.isNull() ? _data->compressed.size() : _data->image.byteCount();
+}
+
+bool HistorySnapshot::isNull() const {
+    return !_data || _data->size.isEmpty();
+}
+
+QByteArray HistorySnapshot::compress(const QImage & image) {
+    QByteArray result;
+    int count = image.width() * image.height();
+    if(count == 0)
+        return result;
+    if(image.format() != QImage::Format_ARGB32_Premultiplied)
+        return compress(image.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+
+    // The rows of a 32 bits image are contiguous: the runs go on from a row to the next one
+    const quint32 * pixels = reinterpret_cast<const quint32 *>(image.constBits());
+
+    QVector<quint32> tokens;
+    tokens.reserve(1024);
+    int literalStart = 0;
+    int i = 0;
+    auto flushLiterals = [&](int end) {
+        if(end > literalStart) {
+            tokens.push_back(quint32(end - literalStart) << 1);
+            for(int j=literalStart; j<end; ++j)
+                tokens.push_back(pixels[j]);
+        }
+    };
+
+    while(i < count) {
+        int runEnd = i + 1;
+        while(runEnd < count && pixels[runEnd] == pixels[i])
+            ++runEnd;
+        if(runEnd - i >= MinimumRun) {
+            flushLiterals(i);
+            tokens.push_back((quint32(runEnd - i) << 1) | RunFlag);
+            tokens.push_back(pixels[i]);
+            literalStart = runEnd;
+        }
+        i = runEnd;
+    }
+    flushLiterals(count);
+
+    result.resize(tokens.size() * int(sizeof(quint32)));
+    memcpy(result.data(), tokens.constData(), size_t(result.size()));
+    return result;
+}
+
+QImage HistorySnapshot::decompress(const QByteArray & compressed, QSize size) {
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    if(image.isNull())
+        return image;
+
+    quint32 * pixels = reinterpret_cast<quint32 *>(image.bits());
+    const quint32 * tokens = reinterpret_cast<const quint32 *>(compressed.constData());
+    int tokenCount = compressed.size() / int(sizeof(quint32));
+    qint64 count = qint64(size.width()) * size.height();
+    qint64 written = 0;
+
+    for(int t=0; t<tokenCount; ) {
+        quint32 length = tokens[t] >> 1;
+        bool run = tokens[t] & RunFlag;
+        ++t;
+        if(written + length > count || t + (run ? 1 : qint64(length)) > tokenCount)
+            return QImage();
+        if(run) {
+            quint32 pixel = tokens[t++];
+            std::fill(pixels + written, pixels + written + length, pixel);
+        } else {
+            memcpy(pixels + written, tokens + t, length * sizeof(quint32));
+            t += int(length);
+        }
+        written += length;
+    }
+    return (written == count) ? image : QImage();
+}
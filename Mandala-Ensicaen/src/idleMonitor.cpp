@@ -0,0 +1,63 @@
+/**
+ * @file   idleMonitor.cpp
+ * @date   October 2026
+ *
+ * @brief  idleMonitor counts the work of the application while it runs (--wakeup-report): the wakeups of the event loop, the paint, timer and
+ * mouse move events per second. An idle window must show no wakeups and no paints
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "idleMonitor.h"
+#include <QAbstractEventDispatcher>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QTextStream>
+
+IdleMonitor::IdleMonitor(int period, QObject *parent) : QObject(parent) {
+    // The events of every object go through the application event filters: they are counted before they are delivered
+    QCoreApplication::instance()->installEventFilter(this);
+    connect(QAbstractEventDispatcher::instance(), SIGNAL(awake()), this, SLOT(awake()));
+    _reportTimer.setInterval(qMax(100, period));
+    connect(&_reportTimer, SIGNAL(timeout()), this, SLOT(report()));
+    _reportTimer.start();
+    _clock.start();
+}
+
+bool IdleMonitor::eventFilter(QObject * watched, QEvent * event) {
+    switch(event->type()) {
+    case QEvent::Paint:
+        ++_paints;
+        break;
+    case QEvent::Timer:
+        ++_timers;
+        break;
+    case QEvent::MouseMove:
+    case QEvent::HoverMove:
+        ++_mouseMoves;
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void IdleMonitor::awake() {
+    ++_wakeups;
+}
+
+void IdleMonitor::report() {
+    // Our own timer woke the loop once and sent one timer event
+    double seconds = _clock.restart() / 1000.0;
+    QTextStream out(stdout);
+    out << QString("wakeups %1/s, paints %2/s, timers %3/s, mouse moves %4/s\n")
+           .arg(qMax<qint64>(0, _wakeups - 1) / seconds, 0, 'f', 1).arg(_paints / seconds, 0, 'f', 1)
+           .arg(qMax<qint64>(0, _timers - 1) / seconds, 0, 'f', 1).arg(_mouseMoves / seconds, 0, 'f', 1);
+    out.flush();
+    _wakeups = 0;
+    _paints = 0;
+    _timers = 0;
+    _mouseMoves = 0;
+}
@@ -0,0 +1,613 @@
+/**
+ * @file   imageExporter.cpp
+ * @date   October 2026
+ *
+ * @brief  imageExporter saves the drawing in small files: a mandala has few colors, so it is quantized to a palette (exact when it has 256 colors
+ * or less, else median cut or octree) and saved as an indexed PNG with a chosen compression level and filter strategy, or as a JPEG of a chosen quality.
+ * The quantization and the encoding run on worker threads, and every export reports its size and times
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "imageExporter.h"
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <string.h>
+
+namespace {
+    // The rows are mapped and filtered by bands of BandHeight rows: a band is the work of one worker
+    const int BandHeight = 16;
+
+    // The palettes are computed on a histogram of 5 bits per channel: HistogramBits bits per channel, HistogramSize bins
+    const int HistogramBits = 5;
+    const int HistogramSize = 1 << (3 * HistogramBits);
+
+    // ColorBin holds the pixels of a bin of the histogram: their number and the sums of their channels (the palette colors are the exact means)
+    struct ColorBin {
+        qint64 count = 0;
+        qint64 red = 0;
+        qint64 green = 0;
+        qint64 blue = 0;
+    };
+
+    inline int binOf(QRgb color) {
+        return ((qRed(color) >> 3) << 10) | ((qGreen(color) >> 3) << 5) | (qBlue(color) >> 3);
+    }
+
+    inline int binChannel(int bin, int channel) {
+        return (bin >> (10 - 5 * channel)) & 31;
+    }
+
+    QRgb meanColor(const ColorBin & bin) {
+        if(bin.count == 0)
+            return qRgb(0, 0, 0);
+        return qRgb(int((bin.red + bin.count / 2) / bin.count), int((bin.green + bin.count / 2) / bin.count), int((bin.blue + bin.count / 2) / bin.count));
+    }
+
+    void addBin(ColorBin & to, const ColorBin & from) {
+        to.count += from.count;
+        to.red += from.red;
+        to.green += from.green;
+        to.blue += from.blue;
+    }
+
+    // Run a function on the ranges [first, last) of [0, count): ranges of step items, or one range per thread if step is 0
+    void forEachRange(int count, int step, const std::function<void(int, int)> & work) {
+        if(step <= 0)
+            step = qMax(1, (count + QThread::idealThreadCount() - 1) / QThread::idealThreadCount());
+        QVector<QPair<int, int>> ranges;
+        for(int i=0; i<count; i+=step)
+            ranges.push_back(qMakePair(i, qMin(count, i + step)));
+        QtConcurrent::blockingMap(ranges, [&work](const QPair<int, int> & range) { work(range.first, range.second); });
+    }
+
+    // The histogram is counted on one range of rows per thread, then the ranges are summed
+    QVector<ColorBin> histogram(const QImage & image) {
+        int threads = QThread::idealThreadCount();
+        QVector<QVector<ColorBin>> partial(threads);
+        int rowsPerThread = qMax(1, (image.height() + threads - 1) / threads);
+        forEachRange(image.height(), rowsPerThread, [&](int first, int last) {
+            QVector<ColorBin> & bins = partial[first / rowsPerThread];
+            bins.resize(HistogramSize);
+            for(int y=first; y<last; ++y) {
+                const QRgb * row = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+                for(int x=0; x<image.width(); ++x) {
+                    ColorBin & bin = bins[binOf(row[x])];
+                    ++bin.count;
+                    bin.red += qRed(row[x]);
+                    bin.green += qGreen(row[x]);
+                    bin.blue += qBlue(row[x]);
+                }
+            }
+        });
+
+        QVector<ColorBin> bins(HistogramSize);
+        for(auto iter = partial.begin(); iter != partial.end(); ++iter)
+            for(int i=0; i<iter->size(); ++i)
+                addBin(bins[i], (*iter)[i]);
+        return bins;
+    }
+
+    // The nearest palette color of each bin of the histogram (from the center of the bin)
+    QVector<uchar> nearestColors(const QVector<QRgb> & palette) {
+        QVector<uchar> nearest(HistogramSize);
+        forEachRange(HistogramSize, 1024, [&](int first, int last) {
+            for(int bin=first; bin<last; ++bin) {
+                int r = (binChannel(bin, 0) << 3) | 4, g = (binChannel(bin, 1) << 3) | 4, b = (binChannel(bin, 2) << 3) | 4;
+                int best = 0, bestDistance = INT_MAX;
+                for(int i=0; i<palette.size(); ++i) {
+                    int dr = qRed(palette[i]) - r, dg = qGreen(palette[i]) - g, db = qBlue(palette[i]) - b;
+                    int distance = dr * dr + dg * dg + db * db;
+                    if(distance < bestDistance) {
+                        bestDistance = distance;
+                        best = i;
+                    }
+                }
+                nearest[bin] = uchar(best);
+            }
+        });
+        return nearest;
+    }
+
+    // The CRC of the PNG chunks (the one of zlib, table driven)
+    quint32 crc32(const QByteArray & data) {
+        static const QVector<quint32> table = [] {
+            QVector<quint32> t(256);
+            for(quint32 n=0; n<256; ++n) {
+                quint32 c = n;
+                for(int k=0; k<8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[int(n)] = c;
+            }
+            return t;
+        }();
+        quint32 crc = 0xFFFFFFFFu;
+        for(int i=0; i<data.size(); ++i)
+            crc = table[int((crc ^ uchar(data[i])) & 0xFF)] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    void appendBigEndian(QByteArray & out, quint32 value) {
+        out.append(char(value >> 24)).append(char(value >> 16)).append(char(value >> 8)).append(char(value));
+    }
+
+    void appendChunk(QByteArray & png, const char * type, const QByteArray & data) {
+        QByteArray chunk = QByteArray(type, 4) + data;
+        appendBigEndian(png, quint32(data.size()));
+        png.append(chunk);
+        appendBigEndian(png, crc32(chunk));
+    }
+
+    inline uchar paeth(int a, int b, int c) {
+        int p = a + b - c;
+        int pa = qAbs(p - a), pb = qAbs(p - b), pc = qAbs(p - c);
+        if(pa <= pb && pa <= pc)
+            return uchar(a);
+        return (pb <= pc) ? uchar(b) : uchar(c);
+    }
+
+    // Filter a row with one of the five PNG filters (type 0 to 4): out gets the type then the filtered bytes.
+    // prev is the previous raw row (nullptr for the first row), bpp the bytes per complete pixel (at least one)
+    void filterRow(int type, const uchar * row, const uchar * prev, int rowBytes, int bpp, uchar * out) {
+        out[0] = uchar(type);
+        for(int i=0; i<rowBytes; ++i) {
+            int a = (i >= bpp) ? row[i - bpp] : 0;
+            int b = prev ? prev[i] : 0;
+            int c = (prev && i >= bpp) ? prev[i - bpp] : 0;
+            int predicted = 0;
+            switch(type) {
+            case 1: predicted = a; break;
+            case 2: predicted = b; break;
+            case 3: predicted = (a + b) / 2; break;
+            case 4: predicted = paeth(a, b, c); break;
+            default: break;
+            }
+            out[i + 1] = uchar(row[i] - predicted);
+        }
+    }
+
+    // The adaptive strategy keeps the filter whose bytes, read as signed, have the smallest sum of absolute values
+    qint64 filterCost(const uchar * filtered, int rowBytes) {
+        qint64 cost = 0;
+        for(int i=1; i<=rowBytes; ++i)
+            cost += qAbs(int(qint8(filtered[i])));
+        return cost;
+    }
+
+    QString paletteName(ImageExportSettings::Palette palette) {
+        switch(palette) {
+        case ImageExportSettings::MedianCut: return "median cut";
+        case ImageExportSettings::Octree: return "octree";
+        default: return "full color";
+        }
+    }
+
+    QString filterName(ImageExportSettings::PngFilter filter) {
+        static const char * names[] = { "none", "sub", "up", "average", "paeth", "adaptive" };
+        return names[filter];
+    }
+
+    double milliseconds(const QElapsedTimer & clock) {
+        return clock.nsecsElapsed() / 1e6;
+    }
+}
+
+QString ImageExportReport::toString() const {
+    if(!error.isEmpty())
+        return QString("%1 %2: %3").arg(format, options, error);
+    QString palette = (colors == 0) ? QString("full color") : QString("%1 colors%2").arg(colors).arg(exact ? " (exact)" : "");
+    return QString("%1 %2: %3 bytes (%4 KB), %5, quantized in %6 ms, encoded in %7 ms")
+            .arg(format, options).arg(bytes).arg(bytes / 1024.0, 0, 'f', 1).arg(palette)
+            .arg(quantizeTime, 0, 'f', 1).arg(encodeTime, 0, 'f', 1);
+}
+
+QVector<QRgb> ImageExporter::exactPalette(const QImage & image, int maxColors) {
+    // The pixels of a mandala come in runs: the last color found is checked first
+    QSet<QRgb> colors;
+    QRgb last = 0;
+    bool hasLast = false;
+    for(int y=0; y<image.height(); ++y) {
+        const QRgb * row = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for(int x=0; x<image.width(); ++x) {
+            QRgb color = row[x] | 0xFF000000;
+            if(hasLast && color == last)
+                continue;
+            last = color;
+            hasLast = true;
+            colors.insert(color);
+            if(colors.size() > maxColors)
+                return QVector<QRgb>();
+        }
+    }
+
+    QVector<QRgb> palette = colors.toList().toVector();
+    std::sort(palette.begin(), palette.end());
+    return palette;
+}
+
+QVector<QRgb> ImageExporter::medianCutPalette(const QImage & image, int colors) {
+    QVector<ColorBin> bins = histogram(image);
+    QVector<int> entries;
+    for(int i=0; i<HistogramSize; ++i)
+        if(bins[i].count > 0)
+            entries.push_back(i);
+
+    // Box is a range of entries: its pixels, and its widest channel and range
+    struct Box {
+        int first;
+        int last;
+        qint64 count;
+        int channel;
+        int range;
+    };
+    auto measure = [&](int first, int last) {
+        Box box = { first, last, 0, 0, 0 };
+        int low[3] = { 31, 31, 31 }, high[3] = { 0, 0, 0 };
+        for(int i=first; i<last; ++i) {
+            box.count += bins[entries[i]].count;
+            for(int c=0; c<3; ++c) {
+                low[c] = qMin(low[c], binChannel(entries[i], c));
+                high[c] = qMax(high[c], binChannel(entries[i], c));
+            }
+        }
+        for(int c=0; c<3; ++c)
+            if(high[c] - low[c] > box.range) {
+                box.range = high[c] - low[c];
+                box.channel = c;
+            }
+        return box;
+    };
+
+    QVector<Box> boxes;
+    if(!entries.isEmpty())
+        boxes.push_back(measure(0, entries.size()));
+    while(boxes.size() < colors) {
+        // The box to cut is the one with the most pixels times its widest range (a box of one bin can't be cut)
+        int chosen = -1;
+        qint64 bestScore = 0;
+        for(int i=0; i<boxes.size(); ++i) {
+            qint64 score = boxes[i].count * boxes[i].range;
+            if(boxes[i].last - boxes[i].first > 1 && score > bestScore) {
+                bestScore = score;
+                chosen = i;
+            }
+        }
+        if(chosen < 0)
+            break;
+
+        Box box = boxes[chosen];
+        std::sort(entries.begin() + box.first, entries.begin() + box.last, [&](int a, int b) {
+            return binChannel(a, box.channel) < binChannel(b, box.channel);
+        });
+        // The cut is at the median pixel, keeping at least one bin on each side
+        qint64 seen = 0;
+        int cut = box.first + 1;
+        for(int i=box.first; i<box.last - 1; ++i) {
+            seen += bins[entries[i]].count;
+            cut = i + 1;
+            if(seen * 2 >= box.count)
+                break;
+        }
+        boxes[chosen] = measure(box.first, cut);
+        boxes.push_back(measure(cut, box.last));
+    }
+
+    QVector<QRgb> palette;
+    for(auto iter = boxes.begin(); iter != boxes.end(); ++iter) {
+        ColorBin sum;
+        for(int i=iter->first; i<iter->last; ++i)
+            addBin(sum, bins[entries[i]]);
+        palette.push_back(meanColor(sum));
+    }
+    return palette;
+}
+
+QVector<QRgb> ImageExporter::octreePalette(const QImage & image, int colors) {
+    QVector<ColorBin> bins = histogram(image);
+
+    // Every node sums the pixels of its subtree: merging the children of a node only turns it into a leaf
+    struct Node {
+        ColorBin sum;
+        int children[8];
+        int childCount;
+        bool leaf;
+    };
+    QVector<Node> nodes;
+    QVector<QVector<int>> levels(HistogramBits);
+    auto newNode = [&](int level) {
+        Node node;
+        std::fill(node.children, node.children + 8, -1);
+        node.childCount = 0;
+        node.leaf = (level == HistogramBits);
+        nodes.push_back(node);
+        if(level < HistogramBits)
+            levels[level].push_back(nodes.size() - 1);
+        return nodes.size() - 1;
+    };
+
+    newNode(0);
+    int leaves = 0;
+    for(int bin=0; bin<HistogramSize; ++bin) {
+        if(bins[bin].count == 0)
+            continue;
+        int node = 0;
+        addBin(nodes[node].sum, bins[bin]);
+        for(int level=0; level<HistogramBits; ++level) {
+            int bit = HistogramBits - 1 - level;
+            int child = (((binChannel(bin, 0) >> bit) & 1) << 2) | (((binChannel(bin, 1) >> bit) & 1) << 1) | ((binChannel(bin, 2) >> bit) & 1);
+            if(nodes[node].children[child] < 0) {
+                int created = newNode(level + 1);
+                nodes[node].children[child] = created;
+                ++nodes[node].childCount;
+                if(level + 1 == HistogramBits)
+                    ++leaves;
+            }
+            node = nodes[node].children[child];
+            addBin(nodes[node].sum, bins[bin]);
+        }
+    }
+
+    // The deepest nodes are reduced first, the ones holding the fewest pixels first
+    for(int level=HistogramBits - 1; level>=0 && leaves>colors; --level) {
+        QVector<int> & candidates = levels[level];
+        std::sort(candidates.begin(), candidates.end(), [&](int a, int b) { return nodes[a].sum.count < nodes[b].sum.count; });
+        for(auto iter = candidates.begin(); iter != candidates.end() && leaves > colors; ++iter) {
+            Node & node = nodes[*iter];
+            leaves -= node.childCount - 1;
+            node.leaf = true;
+        }
+    }
+
+    QVector<QRgb> palette;
+    QVector<int> stack;
+    stack.push_back(0);
+    while(!stack.isEmpty()) {
+        const Node & node = nodes[stack.takeLast()];
+        if(node.leaf) {
+            if(node.sum.count > 0)
+                palette.push_back(meanColor(node.sum));
+            continue;
+        }
+        for(int i=0; i<8; ++i)
+            if(node.children[i] >= 0)
+                stack.push_back(node.children[i]);
+    }
+    return palette;
+}
+
+QImage ImageExporter::quantize(const QImage & source, ImageExportSettings::Palette method, int colors, bool & exact) {
+    QImage image = source.convertToFormat(QImage::Format_RGB32);
+    exact = false;
+    if(method == ImageExportSettings::FullColor)
+        return image;
+
+    colors = qBound(2, colors, 256);
+    QVector<QRgb> palette = exactPalette(image, colors);
+    exact = !palette.isEmpty();
+    QHash<QRgb, int> exactIndex;
+    QVector<uchar> nearest;
+    if(exact) {
+        for(int i=0; i<palette.size(); ++i)
+            exactIndex.insert(palette[i], i);
+    } else {
+        palette = (method == ImageExportSettings::Octree) ? octreePalette(image, colors) : medianCutPalette(image, colors);
+        nearest = nearestColors(palette);
+    }
+
+    QImage indexed(image.size(), QImage::Format_Indexed8);
+    indexed.setColorTable(palette);
+    forEachRange(image.height(), BandHeight, [&](int first, int last) {
+        for(int y=first; y<last; ++y) {
+            const QRgb * in = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            uchar * out = indexed.scanLine(y);
+            for(int x=0; x<image.width(); ++x)
+                out[x] = exact ? uchar(exactIndex.value(in[x] | 0xFF000000)) : nearest[binOf(in[x])];
+        }
+    });
+    return indexed;
+}
+
+QByteArray ImageExporter::encodePng(const QImage & source, int level, ImageExportSettings::PngFilter filter) {
+    bool indexed = (source.format() == QImage::Format_Indexed8);
+    QImage image = indexed ? source : source.convertToFormat(QImage::Format_RGB32);
+    int width = image.width(), height = image.height();
+
+    // An indexed image takes the smallest bit depth that holds its palette
+    int depth = 8;
+    if(indexed) {
+        int colors = image.colorCount();
+        depth = (colors <= 2) ? 1 : (colors <= 4) ? 2 : (colors <= 16) ? 4 : 8;
+    }
+    int rowBytes = indexed ? (width * depth + 7) / 8 : width * 3;
+    int bpp = indexed ? 1 : 3;
+
+    // The raw rows (the packed indices or the RGB bytes) are written, then filtered: a filtered row only reads its raw row and the previous one
+    QByteArray raw(height * rowBytes, 0);
+    forEachRange(height, BandHeight, [&](int first, int last) {
+        for(int y=first; y<last; ++y) {
+            uchar * out = reinterpret_cast<uchar *>(raw.data()) + y * rowBytes;
+            if(indexed) {
+                const uchar * in = image.constScanLine(y);
+                int pixelsPerByte = 8 / depth;
+                for(int x=0; x<width; ++x)
+                    out[x / pixelsPerByte] |= uchar(in[x] << (8 - depth * (x % pixelsPerByte + 1)));
+            } else {
+                const QRgb * in = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+                for(int x=0; x<width; ++x) {
+                    out[3*x] = uchar(qRed(in[x]));
+                    out[3*x + 1] = uchar(qGreen(in[x]));
+                    out[3*x + 2] = uchar(qBlue(in[x]));
+                }
+            }
+        }
+    });
+
+    QByteArray filtered(height * (rowBytes + 1), 0);
+    forEachRange(height, BandHeight, [&](int first, int last) {
+        QByteArray trial(rowBytes + 1, 0);
+        for(int y=first; y<last; ++y) {
+            const uchar * row = reinterpret_cast<const uchar *>(raw.constData()) + y * rowBytes;
+            const uchar * prev = (y > 0) ? row - rowBytes : nullptr;
+            uchar * out = reinterpret_cast<uchar *>(filtered.data()) + y * (rowBytes + 1);
+            if(filter != ImageExportSettings::Adaptive) {
+                filterRow(int(filter), row, prev, rowBytes, bpp, out);
+                continue;
+            }
+            qint64 bestCost = -1;
+            for(int type=0; type<5; ++type) {
+                uchar * candidate = reinterpret_cast<uchar *>(trial.data());
+                filterRow(type, row, prev, rowBytes, bpp, candidate);
+                qint64 cost = filterCost(candidate, rowBytes);
+                if(bestCost < 0 || cost < bestCost) {
+                    bestCost = cost;
+                    memcpy(out, candidate, size_t(rowBytes + 1));
+                }
+            }
+        }
+    });
+
+    QByteArray png("\x89PNG\r\n\x1a\n", 8);
+    QByteArray header;
+    appendBigEndian(header, quint32(width));
+    appendBigEndian(header, quint32(height));
+    header.append(char(depth)).append(char(indexed ? 3 : 2)).append(char(0)).append(char(0)).append(char(0));
+    appendChunk(png, "IHDR", header);
+    if(indexed) {
+        QByteArray palette;
+        QVector<QRgb> table = image.colorTable();
+        for(auto iter = table.begin(); iter != table.end(); ++iter)
+            palette.append(char(qRed(*iter))).append(char(qGreen(*iter))).append(char(qBlue(*iter)));
+        appendChunk(png, "PLTE", palette);
+    }
+
+    // qCompress gives a zlib stream behind the 4 bytes of the uncompressed size: the stream is the content of IDAT
+    QByteArray compressed = qCompress(filtered, qBound(0, level, 9));
+    compressed.remove(0, 4);
+    appendChunk(png, "IDAT", compressed);
+    appendChunk(png, "IEND", QByteArray());
+    return png;
+}
+
+ImageExportReport ImageExporter::encode(const QImage & image, const ImageExportSettings & settings, const QString & format, QByteArray & data) {
+    ImageExportReport report;
+    report.format = format;
+    QElapsedTimer clock;
+
+    if(format == "jpg") {
+        report.options = QString("quality %1").arg(settings.jpegQuality);
+        clock.start();
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&buffer, "JPG");
+        writer.setQuality(settings.jpegQuality);
+        if(!writer.write(image.convertToFormat(QImage::Format_RGB32)))
+            report.error = writer.errorString();
+        report.encodeTime = milliseconds(clock);
+        return report;
+    }
+
+    clock.start();
+    QImage quantized = quantize(image, settings.palette, settings.colors, report.exact);
+    report.quantizeTime = milliseconds(clock);
+    report.colors = quantized.colorCount();
+    report.options = (report.colors == 0) ? paletteName(ImageExportSettings::FullColor)
+                                          : QString("%1 %2").arg(paletteName(settings.palette)).arg(qBound(2, settings.colors, 256));
+
+    clock.restart();
+    if(format == "png") {
+        report.options += QString(", filter %1, level %2").arg(filterName(settings.pngFilter)).arg(settings.pngCompression);
+        data = encodePng(quantized, settings.pngCompression, settings.pngFilter);
+    } else {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&buffer, "BMP");
+        if(!writer.write(quantized))
+            report.error = writer.errorString();
+    }
+    report.encodeTime = milliseconds(clock);
+    return report;
+}
+
+ImageExportReport ImageExporter::exportImage(const QImage & image, const ImageExportSettings & settings, const QString & fileName) {
+    QString format = QFileInfo(fileName).suffix().toLower();
+    if(format == "jpeg")
+        format = "jpg";
+    if(format != "png" && format != "bmp" && format != "jpg") {
+        ImageExportReport report;
+        report.format = format;
+        report.error = QString("Can't save the format of %1").arg(fileName);
+        return report;
+    }
+
+    QByteArray data;
+    ImageExportReport report = encode(image, settings, format, data);
+    if(!report.error.isEmpty())
+        return report;
+
+    QSaveFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        report.error = QString("Can't write %1").arg(fileName);
+        return report;
+    }
+    report.bytes = data.size();
+    return report;
+}
+
+QStringList ImageExporter::compareOptions(const QImage & image, int colors) {
+    // The options are encoded one after the other: each one has all the CPU cores for itself, so their times can be compared
+    QVector<QPair<QString, ImageExportSettings>> options;
+    ImageExportSettings settings;
+    settings.colors = colors;
+
+    settings.palette = ImageExportSettings::FullColor;
+    options.push_back(qMakePair(QString("bmp"), settings));
+    options.push_back(qMakePair(QString("png"), settings));
+    settings.palette = ImageExportSettings::MedianCut;
+    options.push_back(qMakePair(QString("bmp"), settings));
+    for(int filter=ImageExportSettings::NoFilter; filter<=ImageExportSettings::Adaptive; ++filter) {
+        settings.pngFilter = ImageExportSettings::PngFilter(filter);
+        options.push_back(qMakePair(QString("png"), settings));
+    }
+    settings.pngCompression = 6;
+    options.push_back(qMakePair(QString("png"), settings));
+    settings.pngCompression = 1;
+    options.push_back(qMakePair(QString("png"), settings));
+    settings.pngCompression = 9;
+    settings.palette = ImageExportSettings::Octree;
+    options.push_back(qMakePair(QString("png"), settings));
+    int qualities[] = { 95, 90, 75, 50 };
+    for(int quality : qualities) {
+        settings.jpegQuality = quality;
+        options.push_back(qMakePair(QString("jpg"), settings));
+    }
+
+    QStringList report;
+    QElapsedTimer clock;
+    clock.start();
+    QByteArray reference;
+    QBuffer buffer(&reference);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    report << QString("png Qt writer: %1 bytes (%2 KB), full color, encoded in %3 ms")
+              .arg(reference.size()).arg(reference.size() / 1024.0, 0, 'f', 1).arg(milliseconds(clock), 0, 'f', 1);
+
+    for(auto iter = options.begin(); iter != options.end(); ++iter) {
+        QByteArray data;
+        ImageExportReport line = encode(image, iter->second, iter->first, data);
+        line.bytes = data.size();
+        report << line.toString();
+    }
+    return report;
+}
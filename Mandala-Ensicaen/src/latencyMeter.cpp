@@ -0,0 +1,63 @@
+/**
+ * @file   latencyMeter.cpp
+ * @date   October 2026
+ *
+ * @brief  latencyMeter keeps the last latency samples of the draw path (in milliseconds) and summarizes them: mean and percentiles
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "latencyMeter.h"
+#include <QObject>
+#include <algorithm>
+#include <math.h>
+
+const int LatencyMeter::SampleCount;
+
+LatencyMeter::LatencyMeter() {
+    _samples.reserve(SampleCount);
+}
+
+void LatencyMeter::addSample(double latency) {
+    if(_samples.size() < SampleCount)
+        _samples.push_back(latency);
+    else
+        _samples[_next] = latency;
+    _next = (_next + 1) % SampleCount;
+}
+
+void LatencyMeter::reset() {
+    _samples.clear();
+    _next = 0;
+}
+
+int LatencyMeter::count() const {
+    return _samples.size();
+}
+
+double LatencyMeter::mean() const {
+    if(_samples.isEmpty())
+        return 0;
+    double sum = 0;
+    for(auto iter = _samples.begin(); iter != _samples.end(); ++iter)
+        sum += *iter;
+    return sum / _samples.size();
+}
+
+double LatencyMeter::percentile(double percent) const {
+    if(_samples.isEmpty())
+        return 0;
+    QVector<double> sorted = _samples;
+    int index = qBound(0, int(ceil(percent / 100 * sorted.size())) - 1, sorted.size() - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+QString LatencyMeter::summary() const {
+    if(_samples.isEmpty())
+        return QObject::tr("no samples");
+    return QObject::tr("mean %1 ms, median %2 ms, p95 %3 ms")
+            .arg(mean(), 0, 'f', 1).arg(percentile(50), 0, 'f', 1).arg(percentile(95), 0, 'f', 1);
+}
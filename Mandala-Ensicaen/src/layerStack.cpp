@@ -0,0 +1,221 @@
+/**
+ * @file   layerStack.cpp
+ * @date   October 2026
+ *
+ * @brief  layerStack defines the layers of a mandala: the background image, any number of stroke layers and the guides overlay (grid slices and mirror lines),
+ * and keeps a cached composite of the content layers that is only redone where a layer changed
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "layerStack.h"
+#include <QPainter>
+
+// MandalaLayer:
+MandalaLayer::MandalaLayer(const QString & name) : _name(name) {
+}
+
+QString MandalaLayer::name() const {
+    return _name;
+}
+
+bool MandalaLayer::isVisible() const {
+    return _visible;
+}
+
+void MandalaLayer::setVisible(bool visible) {
+    _visible = visible;
+    ++_revision;
+}
+
+TiledRaster & MandalaLayer::raster() {
+    return _raster;
+}
+
+const TiledRaster & MandalaLayer::raster() const {
+    return _raster;
+}
+
+void MandalaLayer::markDirty(const QRectF & rect) {
+    _dirtyRect |= rect;
+    ++_revision;
+}
+
+bool MandalaLayer::isDirty() const {
+    return !_dirtyRect.isNull();
+}
+
+QRectF MandalaLayer::dirtyRect() const {
+    return _dirtyRect;
+}
+
+void MandalaLayer::clearDirty() {
+    _dirtyRect = QRectF();
+}
+
+quint64 MandalaLayer::revision() const {
+    return _revision;
+}
+
+// LayerStack:
+LayerStack::LayerStack() : _background(QStringLiteral("Background")), _guides(QStringLiteral("Guides")) {
+}
+
+void LayerStack::setCanvasRect(const QRect & canvasRect) {
+    _canvasRect = canvasRect;
+    _guides.markDirty(_canvasRect);
+    ++_revision;
+}
+
+QRect LayerStack::canvasRect() const {
+    return _canvasRect;
+}
+
+void LayerStack::setScale(qreal scale) {
+    if(scale == _scale)
+        return;
+    _scale = scale;
+    ++_revision;
+    _background.raster().setScale(scale);
+    _guides.raster().setScale(scale);
+    for(auto iter = _strokeLayers.begin(); iter != _strokeLayers.end(); ++iter)
+        iter->raster().setScale(scale);
+    // The composite is reallocated at the new resolution
+    _composite = QImage();
+}
+
+qreal LayerStack::scale() const {
+    return _scale;
+}
+
+MandalaLayer & LayerStack::background() {
+    return _background;
+}
+
+MandalaLayer & LayerStack::guides() {
+    return _guides;
+}
+
+int LayerStack::addStrokeLayer(const QString & name) {
+    _strokeLayers.push_back(MandalaLayer(name));
+    _strokeLayers.last().raster().setScale(_scale);
+    ++_revision;
+    return _strokeLayers.size() - 1;
+}
+
+void LayerStack::removeStrokeLayers() {
+    for(auto iter = _strokeLayers.begin(); iter != _strokeLayers.end(); ++iter)
+        _revision += iter->revision();
+    ++_revision;
+    _strokeLayers.clear();
+    _currentStrokeLayer = 0;
+    // What was drawn in the removed layers must disappear from the composite
+    _itemsDirtyRect |= _canvasRect;
+}
+
+int LayerStack::strokeLayerCount() const {
+    return _strokeLayers.size();
+}
+
+MandalaLayer & LayerStack::strokeLayer(int index) {
+    return _strokeLayers[index];
+}
+
+void LayerStack::setCurrentStrokeLayer(int index) {
+    if(index >= 0 && index < _strokeLayers.size())
+        _currentStrokeLayer = index;
+}
+
+int LayerStack::currentStrokeLayerIndex() const {
+    return _currentStrokeLayer;
+}
+
+MandalaLayer & LayerStack::currentStrokeLayer() {
+    return _strokeLayers[_currentStrokeLayer];
+}
+
+void LayerStack::setItemsRenderer(const std::function<void(QPainter *, const QRectF &)> & itemsRenderer) {
+    _itemsRenderer = itemsRenderer;
+}
+
+void LayerStack::markItemsDirty(const QRectF & rect) {
+    _itemsDirtyRect |= rect;
+    ++_revision;
+}
+
+quint64 LayerStack::revision() const {
+    quint64 revision = _revision + _background.revision();
+    for(auto iter = _strokeLayers.begin(); iter != _strokeLayers.end(); ++iter)
+        revision += iter->revision();
+    return revision;
+}
+
+void LayerStack::paintContent(QPainter * painter, const QRectF & exposed) const {
+    if(_background.isVisible())
+        _background.raster().paint(painter, exposed);
+    for(auto iter = _strokeLayers.begin(); iter != _strokeLayers.end(); ++iter)
+        if(iter->isVisible())
+            iter->raster().paint(painter, exposed);
+}
+
+const QImage & LayerStack::composite() {
+    QRectF dirty = _itemsDirtyRect | _background.dirtyRect();
+    for(auto iter = _strokeLayers.begin(); iter != _strokeLayers.end(); ++iter)
+        dirty |= iter->dirtyRect();
+
+    // The composite has the resolution of the layers: the painter works in scene pixels on it
+    QSize size = _canvasRect.size() * _scale;
+    if(_composite.size() != size) {
+        _composite = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        _composite.setDevicePixelRatio(_scale);
+        dirty = _canvasRect;
+    }
+
+    // We only redo the composite where a layer changed
+    QRect area = dirty.toAlignedRect() & _canvasRect;
+    if(!area.isEmpty()) {
+        QPainter painter(&_composite);
+        painter.translate(-_canvasRect.topLeft());
+        painter.setClipRect(area);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(area, Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        paintContent(&painter, area);
+        if(_itemsRenderer)
+            _itemsRenderer(&painter, area);
+    }
+
+    _itemsDirtyRect = QRectF();
+    _background.clearDirty();
+    for(auto iter = _strokeLayers.begin(); iter != _strokeLayers.end(); ++iter)
+        iter->clearDirty();
+
+    return _composite;
+}
+
+void LayerStack::clearContent() {
+    _background.raster().clear();
+    _background.markDirty(_canvasRect);
+    for(auto iter = _strokeLayers.begin(); iter != _strokeLayers.end(); ++iter) {
+        iter->raster().clear();
+        iter->markDirty(_canvasRect);
+    }
+}
+
+bool LayerStack::contentIsEmpty() const {
+    if(!_background.raster().isEmpty())
+        return false;
+    for(auto iter = _strokeLayers.begin(); iter != _strokeLayers.end(); ++iter)
+        if(!iter->raster().isEmpty())
+            return false;
+    return true;
+}
+
+qint64 LayerStack::byteCount() const {
+    qint64 bytes = _background.raster().byteCount() + _guides.raster().byteCount() + _composite.byteCount();
+    for(auto iter = _strokeLayers.begin(); iter != _strokeLayers.end(); ++iter)
+        bytes += iter->raster().byteCount();
+    return bytes;
+}
@@ -11,15 +11,35 @@
  */
 
 #include "mainWindow.h"
+#include "startupTimer.h"
+#include "idleMonitor.h"
+#include "renderVerifier.h"
+#include "mandalaScript.h"
+#include "symmetryEngine.h"
+#include "renderServer.h"
+#include "collabSession.h"
+#include "imageExporter.h"
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
 #include <QTranslator>
 #include <QInputDialog>
 #include <QDebug>
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer clock;
+    clock.start();
+
     QApplication a(argc, argv);
 
+    // --startup-timing prints the time of each startup phase until the first frame, then quits
+    StartupTimer * startupTimer = nullptr;
+    if(a.arguments().contains("--startup-timing")) {
+        startupTimer = new StartupTimer(clock, &a);
+        startupTimer->mark("application");
+    }
+
     QApplication::setOrganizationDomain("ensicaen.fr");
     QApplication::setOrganizationName("ENSICAEN");
     QApplication::setApplicationName("Mandala");
@@ -38,9 +58,151 @@ int main(int argc, char *argv[])
     if(languages[0].split("-")[0] != "en"){
         a.installTranslator(&translator);
     }
+    // The translations must be installed before the widgets are created (their texts are translated once): they are memory mapped from the resources
+    if(startupTimer)
+        startupTimer->mark("translations");
+
+    // --benchmark-symmetry compares the specialised symmetry kernels with the generic transforms, then quits
+    if(a.arguments().contains("--benchmark-symmetry")) {
+        QStringList report = SymmetryEngine::benchmarkKernels(100000);
+        QTextStream out(stdout);
+        for(auto iter = report.begin(); iter != report.end(); ++iter)
+            out << *iter << "\n";
+        return 0;
+    }
+
+    // --script <file> renders and exports the variations of a command file without any window, then quits
+    int scriptArgument = a.arguments().indexOf("--script");
+    if(scriptArgument > 0) {
+        MandalaScript script;
+        QTextStream out(stdout);
+        if(scriptArgument + 1 >= a.arguments().size()) {
+            out << "--script needs a file\n";
+            return 1;
+        }
+        if(!script.load(a.arguments()[scriptArgument + 1])) {
+            out << script.errorString() << "\n";
+            return 1;
+        }
+        QStringList reports = script.run();
+        for(auto iter = reports.begin(); iter != reports.end(); ++iter)
+            out << *iter << "\n";
+        return 0;
+    }
+
+    // --render-server [name] keeps rendering the jobs sent on a local socket, --render-job <file> [--server name] [--size WxH] [--timeout ms]
+    // sends a command file to it and saves the images, --render-stats [name] prints its counters
+    QStringList arguments = a.arguments();
+    auto argumentValue = [&arguments](const QString & option, const QString & defaultValue) {
+        int index = arguments.indexOf(option);
+        return (index > 0 && index + 1 < arguments.size() && !arguments[index + 1].startsWith("--")) ? arguments[index + 1] : defaultValue;
+    };
+    if(arguments.contains("--render-server")) {
+        QTextStream out(stdout);
+        RenderServer server;
+        QString name = argumentValue("--render-server", RenderServer::DefaultName);
+        if(!server.listen(name)) {
+            out << server.errorString() << "\n";
+            return 1;
+        }
+        out << "Render server listening on " << name << "\n";
+        out.flush();
+        return a.exec();
+    }
+    if(arguments.contains("--render-job")) {
+        QTextStream out(stdout);
+        QString script = argumentValue("--render-job", QString());
+        if(script.isEmpty()) {
+            out << "--render-job needs a file\n";
+            return 1;
+        }
+        QStringList size = argumentValue("--size", QString()).split("x");
+        QSize imageSize = (size.size() == 2) ? QSize(size[0].toInt(), size[1].toInt()) : QSize();
+        QStringList reports = RenderServer::submit(argumentValue("--server", RenderServer::DefaultName), script, imageSize,
+                                                   argumentValue("--timeout", QString::number(RenderServer::DefaultTimeout)).toInt());
+        for(auto iter = reports.begin(); iter != reports.end(); ++iter)
+            out << *iter << "\n";
+        return 0;
+    }
+    if(arguments.contains("--render-stats")) {
+        QTextStream out(stdout);
+        out << RenderServer::requestStats(argumentValue("--render-stats", RenderServer::DefaultName)) << "\n";
+        return 0;
+    }
+
+    // --collab-server [port] relays a drawing session without a window, --collab-loopback [clients] [--slices n] [--duration ms]
+    // measures the bandwidth of a session on this host: the first client draws, the others project its stroke with the symmetry
+    if(arguments.contains("--collab-server")) {
+        QTextStream out(stdout);
+        CollabServer server;
+        if(!server.listen(QHostAddress::Any, argumentValue("--collab-server", QString::number(CollabServer::DefaultPort)).toUShort())) {
+            out << server.errorString() << "\n";
+            return 1;
+        }
+        out << "Session server listening on port " << server.port() << "\n";
+        out.flush();
+        return a.exec();
+    }
+    if(arguments.contains("--collab-loopback")) {
+        QTextStream out(stdout);
+        QStringList reports = CollabSession::runLoopback(argumentValue("--collab-loopback", "4").toInt(),
+                                                         argumentValue("--slices", "360").toInt(),
+                                                         argumentValue("--duration", "5000").toInt());
+        for(auto iter = reports.begin(); iter != reports.end(); ++iter)
+            out << *iter << "\n";
+        return 0;
+    }
+
+    // --export-report <image> [--colors n] encodes an image with each export option (palettes, PNG filters and levels, JPEG qualities)
+    // and prints the size and times of each one
+    if(arguments.contains("--export-report")) {
+        QTextStream out(stdout);
+        QImage image(argumentValue("--export-report", QString()));
+        if(image.isNull()) {
+            out << "--export-report needs an image\n";
+            return 1;
+        }
+        QStringList reports = ImageExporter::compareOptions(image, argumentValue("--colors", "256").toInt());
+        for(auto iter = reports.begin(); iter != reports.end(); ++iter)
+            out << *iter << "\n";
+        return 0;
+    }
+
+    // --verify-render [file] [--output dir] [--tolerance n] [--ssim x] replays the drawings of a command file (or the built-in corpus) through each
+    // render backend, compares them with the QGraphicsLineItem images and prints the speedup and result of each backend (exit code 2 on a mismatch)
+    if(arguments.contains("--verify-render")) {
+        QTextStream out(stdout);
+        QVector<ScriptVariation> corpus = RenderVerifier::builtinCorpus();
+        QString file = argumentValue("--verify-render", QString());
+        if(!file.isEmpty()) {
+            MandalaScript script;
+            if(!script.load(file)) {
+                out << script.errorString() << "\n";
+                return 1;
+            }
+            corpus = script.variations();
+        }
+        bool passed;
+        QStringList reports = RenderVerifier::verify(corpus, argumentValue("--output", QString()),
+                                                     argumentValue("--tolerance", QString::number(RenderVerifier::DefaultTolerance)).toInt(),
+                                                     argumentValue("--ssim", QString::number(RenderVerifier::DefaultMinimumSsim)).toDouble(), passed);
+        for(auto iter = reports.begin(); iter != reports.end(); ++iter)
+            out << *iter << "\n";
+        return passed ? 0 : 2;
+    }
+
+    // --wakeup-report [ms] prints the wakeups of the event loop and the paint, timer and mouse move events of each period (1 second by default)
+    if(arguments.contains("--wakeup-report"))
+        new IdleMonitor(argumentValue("--wakeup-report", "1000").toInt(), &a);
 
     MainWindow w;
+    if(startupTimer) {
+        startupTimer->mark("main window");
+        startupTimer->watchFirstFrame(&w);
+    }
     w.show();
+    if(startupTimer)
+        startupTimer->mark("show");
 
     return a.exec();
 }
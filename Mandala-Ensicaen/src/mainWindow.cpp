@@ -12,12 +12,39 @@
 
 #include "mainWindow.h"
 #include "ui_mainwindow.h"
+#include "generatorPanel.h"
+#include "galleryPanel.h"
+#include "symmetryPanel.h"
+#include "stabilizerPanel.h"
+#include "resourceCache.h"
+#include "tileExporter.h"
+#include "imageExporter.h"
+#include "memoryBudget.h"
+#include "mandalaScript.h"
 #include <QMessageBox>
 #include <QCloseEvent>
 #include <QColorDialog>
 #include <QPixmap>
 #include <QFileDialog>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFileInfo>
+#include <QActionGroup>
+#include <QComboBox>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QInputDialog>
+#include <QLabel>
+#include <QLineEdit>
+#include <QSettings>
+#include <QSignalBlocker>
+#include <QTimer>
+#include <QJsonObject>
+#include <QSpinBox>
+#include <QTabBar>
+#include <QtConcurrent/QtConcurrent>
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -29,16 +56,65 @@ MainWindow::MainWindow(QWidget *parent) :
     this->setWindowIcon(QIcon(":/img/mandala.png"));
     this->window()->setWindowTitle(tr("Mandala-Ensicaen"));
 
+    _generatorPanel = new GeneratorPanel(this);
+    addDockWidget(Qt::RightDockWidgetArea, _generatorPanel);
+    _generatorPanel->hide();
+    _generatorPanel->setEnabled(false);
+    ui->menu_View->addAction(_generatorPanel->toggleViewAction());
+
+    _symmetryPanel = new SymmetryPanel(this);
+    addDockWidget(Qt::RightDockWidgetArea, _symmetryPanel);
+    _symmetryPanel->hide();
+    _symmetryPanel->setEnabled(false);
+    ui->menu_View->addAction(_symmetryPanel->toggleViewAction());
+
+    _stabilizerPanel = new StabilizerPanel(this);
+    addDockWidget(Qt::RightDockWidgetArea, _stabilizerPanel);
+    _stabilizerPanel->hide();
+    ui->menu_View->addAction(_stabilizerPanel->toggleViewAction());
+    _latencyTimer = new QTimer(this);
+    _latencyTimer->setInterval(500);
+
+    _galleryPanel = new GalleryPanel(this);
+    addDockWidget(Qt::LeftDockWidgetArea, _galleryPanel);
+    _galleryPanel->hide();
+    ui->menu_View->addAction(_galleryPanel->toggleViewAction());
+
+    // Each open document has its tab above the canvas: they all share the view, its scene, its layer rasters and the caches
+    _documentTabs = new QTabBar(this);
+    _documentTabs->setDocumentMode(true);
+    _documentTabs->setTabsClosable(true);
+    _documentTabs->setExpanding(false);
+    _documentTabs->addTab(tr("Untitled %1").arg(_untitledCount));
+    _documents.resize(1);
+    ui->verticalLayout->insertWidget(1, _documentTabs);
+    _documentsConsumer = MemoryBudget::instance()->addConsumer(tr("Inactive documents"), MemoryBudget::History,
+                                                               [this]() {
+                                                                   qint64 bytes = 0;
+                                                                   for(auto iter = _documents.begin(); iter != _documents.end(); ++iter)
+                                                                       bytes += iter->byteCount();
+                                                                   return bytes;
+                                                               },
+                                                               [this](qint64 bytes) { return releaseDocumentHistories(bytes); });
+
+    // The palettes of the rainbow mode are exclusive, their order follows ColorEngine::Palette
+    _paletteGroup = new QActionGroup(this);
+    _paletteGroup->addAction(ui->actionPalette_HSV_Wheel);
+    _paletteGroup->addAction(ui->actionPalette_Gradient);
+    _paletteGroup->addAction(ui->actionPalette_Stroke_Cycle);
+    _paletteGroup->addAction(ui->actionPalette_Radial);
+
     connectSignalSlots();
 
     QPixmap squareColor(70,70);
     squareColor.fill(Qt::white);
     ui->colorButton->setIcon(QIcon(squareColor));
 
-    // Fix the graphicsView:
+    // Fix the graphicsView canvas:
     QRect rcontent = ui->graphicsView->contentsRect();
-    ui->graphicsView->setSceneRect(0, 0, rcontent.width(), rcontent.height());
+    ui->graphicsView->setCanvasSize(rcontent.size());
 
+    // A QIcon made from a file is only decoded when it is painted: the menu icons are never decoded before a menu is opened
     ui->multiColor->setIcon(QIcon (":/img/rgbColors.png"));
     ui->eraserButton->setIcon(QIcon (":/img/eraser.png"));
     ui->brushButton->setIcon(QIcon (":/img/brush.png"));
@@ -56,11 +132,14 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->brushButton->setEnabled(false);
     ui->eraserButton->setEnabled(false);
     ui->singlePainterActivator->setEnabled(false);
+    ui->layerComboBox->setEnabled(false);
+    ui->layerComboBox->addItem(ui->graphicsView->strokeLayerName(0));
 
     ui->action_Redo->setEnabled(false);
     ui->action_Undo->setEnabled(false);
     ui->actionSave_As->setEnabled(false);
     ui->action_Open_File->setEnabled(false);
+    ui->actionNew_Layer->setEnabled(false);
 
     ui->actionSave_As->setIcon(QIcon(":/img/save_image.png"));
     ui->action_Open_File->setIcon(QIcon(":/img/open_new.png"));
@@ -70,9 +149,46 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->action_Redo->setIcon(QIcon(":/img/redo.png"));
     ui->action_About->setIcon(QIcon(":/img/about.png"));
 
+    // The journal of a crashed session is read on a worker thread: the window is shown at once and we ask the user once it is read
+    // The memory ceiling is the one the user chose in a previous run
+    QSettings settings;
+    MemoryBudget * budget = MemoryBudget::instance();
+    _memoryLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(_memoryLabel);
+    connect(budget, SIGNAL(usageChanged(qint64, qint64)), this, SLOT(updateMemoryUsage(qint64, qint64)));
+    budget->setCeiling(settings.value("memory/ceiling", budget->ceiling()).toLongLong());
+    _exportScale = settings.value("export/scale", 1.0).toDouble();
+    _imageExportSettings.palette = ImageExportSettings::Palette(settings.value("export/palette", _imageExportSettings.palette).toInt());
+    _imageExportSettings.colors = settings.value("export/colors", _imageExportSettings.colors).toInt();
+    _imageExportSettings.pngCompression = settings.value("export/pngCompression", _imageExportSettings.pngCompression).toInt();
+    _imageExportSettings.pngFilter = ImageExportSettings::PngFilter(settings.value("export/pngFilter", _imageExportSettings.pngFilter).toInt());
+    _imageExportSettings.jpegQuality = settings.value("export/jpegQuality", _imageExportSettings.jpegQuality).toInt();
+
+    // The session label is only shown while we are in a session
+    _collabSession = new CollabSession(this);
+    _sessionLabel = new QLabel(this);
+    _sessionLabel->hide();
+    statusBar()->addPermanentWidget(_sessionLabel);
+    _sessionTimer = new QTimer(this);
+    _sessionTimer->setInterval(1000);
+
+    _scriptWatcher = new QFutureWatcher<ScriptReport>(this);
+    connect(_scriptWatcher, SIGNAL(progressValueChanged(int)), this, SLOT(scriptProgress(int)));
+    connect(_scriptWatcher, SIGNAL(finished()), this, SLOT(scriptFinished()));
+
+    _tileExportWatcher = new QFutureWatcher<QString>(this);
+    connect(_tileExportWatcher, SIGNAL(finished()), this, SLOT(tileExported()));
+
+    _imageExportWatcher = new QFutureWatcher<ImageExportReport>(this);
+    connect(_imageExportWatcher, SIGNAL(finished()), this, SLOT(imageExported()));
+
+    _journalWatcher = new QFutureWatcher<QVector<JournalRecovery>>(this);
+    connect(_journalWatcher, SIGNAL(finished()), this, SLOT(journalRecovered()));
+    _journalWatcher->setFuture(QtConcurrent::run(&StrokeJournal::recoverAll, StrokeJournal::defaultDirectory()));
 }
 
 MainWindow::~MainWindow() {
+    MemoryBudget::instance()->removeConsumer(_documentsConsumer);
     delete ui;
     qDebug() << "Deleted UI";
 }
@@ -82,10 +198,46 @@ void MainWindow::connectSignalSlots() {
     connect(ui->actionQuit, SIGNAL(triggered(bool)), this, SLOT(actionExit_triggered()));
     connect(ui->action_About, SIGNAL(triggered(bool)), this, SLOT(actionAbout_triggered()));
     connect(ui->actionSave_As, SIGNAL(triggered(bool)), this, SLOT(actionSaveAs_triggered()));
+    connect(ui->actionExport_Tile, SIGNAL(triggered(bool)), this, SLOT(actionExportTile_triggered()));
+    connect(ui->actionExport_Scale, SIGNAL(triggered(bool)), this, SLOT(actionExportScale_triggered()));
+    connect(ui->actionSelect_Strokes, SIGNAL(toggled(bool)), this, SLOT(actionSelectStrokes_toggled(bool)));
     connect(ui->action_Redo, SIGNAL(triggered(bool)), this, SLOT(actionRedo_triggered()));
     connect(ui->action_Undo, SIGNAL(triggered(bool)), this, SLOT(actionUndo_triggered()));
     connect(ui->action_Open_File, SIGNAL(triggered(bool)), this, SLOT(actionOpenFile_triggered()));
     connect(ui->actionNew_File, SIGNAL(triggered(bool)), this, SLOT(actionNewFile_triggered()));
+    connect(ui->actionNew_Layer, SIGNAL(triggered(bool)), this, SLOT(actionNewLayer_triggered()));
+    connect(_documentTabs, SIGNAL(currentChanged(int)), this, SLOT(switchDocument(int)));
+    connect(_documentTabs, SIGNAL(tabCloseRequested(int)), this, SLOT(closeDocument(int)));
+    connect(ui->actionReset_Zoom, SIGNAL(triggered(bool)), this, SLOT(actionResetZoom_triggered()));
+    connect(ui->actionMemory_Limit, SIGNAL(triggered(bool)), this, SLOT(actionMemoryLimit_triggered()));
+    connect(ui->actionRun_Script, SIGNAL(triggered(bool)), this, SLOT(actionRunScript_triggered()));
+    connect(ui->actionHost_Session, SIGNAL(triggered(bool)), this, SLOT(actionHostSession_triggered()));
+    connect(ui->actionJoin_Session, SIGNAL(triggered(bool)), this, SLOT(actionJoinSession_triggered()));
+    connect(ui->actionLeave_Session, SIGNAL(triggered(bool)), this, SLOT(actionLeaveSession_triggered()));
+    connect(_generatorPanel, SIGNAL(generateRequested(GeneratorSettings)), this, SLOT(generateMandala(GeneratorSettings)));
+    connect(_galleryPanel, SIGNAL(imageActivated(QString)), this, SLOT(openGalleryImage(QString)));
+    connect(_symmetryPanel, SIGNAL(symmetryChanged(SymmetrySettings)), this, SLOT(setSymmetry(SymmetrySettings)));
+    connect(_paletteGroup, SIGNAL(triggered(QAction *)), this, SLOT(selectPalette(QAction *)));
+    connect(_stabilizerPanel, SIGNAL(stabilizerChanged(StabilizerSettings)), this, SLOT(setStabilizer(StabilizerSettings)));
+    connect(_stabilizerPanel, SIGNAL(latencyResetRequested()), this, SLOT(resetLatency()));
+    connect(_stabilizerPanel, SIGNAL(visibilityChanged(bool)), this, SLOT(stabilizerPanelVisibilityChanged(bool)));
+    connect(ui->graphicsView, SIGNAL(deviceScaleChanged()), this, SLOT(deviceScaleChanged()));
+    connect(_latencyTimer, SIGNAL(timeout()), this, SLOT(showLatency()));
+    connect(ui->graphicsView, SIGNAL(strokeStarted(CollabStroke, QPointF)), this, SLOT(startLatencyRefresh()));
+    connect(ui->graphicsView, SIGNAL(strokeFinished()), this, SLOT(stopLatencyRefresh()));
+    connect(ui->graphicsView, SIGNAL(journalFailed(QString)), this, SLOT(showJournalError(QString)));
+    connect(ui->actionGradient_Colors, SIGNAL(triggered(bool)), this, SLOT(actionGradientColors_triggered()));
+
+    // Connect the session: our strokes go to the other clients, theirs are drawn by the view
+    connect(ui->graphicsView, SIGNAL(strokeStarted(CollabStroke, QPointF)), _collabSession, SLOT(beginStroke(CollabStroke, QPointF)));
+    connect(ui->graphicsView, SIGNAL(strokeExtended(QVector<QPointF>)), _collabSession, SLOT(addPoints(QVector<QPointF>)));
+    connect(ui->graphicsView, SIGNAL(strokeFinished()), _collabSession, SLOT(endStroke()));
+    connect(_collabSession, SIGNAL(remoteStrokeBegan(quint64, CollabStroke, QPointF)), ui->graphicsView, SLOT(beginRemoteStroke(quint64, CollabStroke, QPointF)));
+    connect(_collabSession, SIGNAL(remoteStrokePoints(quint64, QVector<QPointF>)), ui->graphicsView, SLOT(extendRemoteStroke(quint64, QVector<QPointF>)));
+    connect(_collabSession, SIGNAL(remoteStrokeEnded(quint64)), ui->graphicsView, SLOT(endRemoteStroke(quint64)));
+    connect(_collabSession, SIGNAL(joined(quint32)), this, SLOT(sessionJoined(quint32)));
+    connect(_collabSession, SIGNAL(left(QString)), this, SLOT(sessionLeft(QString)));
+    connect(_sessionTimer, SIGNAL(timeout()), this, SLOT(updateSessionRate()));
 
     // Connect Sliders
     connect(ui->sliceSlider, SIGNAL(valueChanged(int)), this, SLOT(updateSlicesSpinBox(int )));
@@ -103,6 +255,7 @@ void MainWindow::connectSignalSlots() {
     // Connect Boxes
     connect(ui->spinBox, SIGNAL(valueChanged(int)), this, SLOT(updateSlicesSlider(int)));
     connect(ui->pixelComboBox, SIGNAL(currentTextChanged(const QString &)), this, SLOT(resizePaintWidget(QString)));
+    connect(ui->layerComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(selectLayer(int)));
 
     // Connect CheckBox
     connect(ui->grid, SIGNAL(stateChanged(int)), this, SLOT(activateGrid(int)));
@@ -123,10 +276,10 @@ void MainWindow::actionExit_triggered() {
 
 void MainWindow::actionAbout_triggered()
 {
-    showMessageBox(QIcon(":/img/mandala.png"), tr("About Mandala-Ensicaen"), tr("Mandala\n\n(c) 2019 Abdelmalik GHOUBIR"), QPixmap(":/img/ensicaen.jpg"), 1);
+    showMessageBox(QIcon(":/img/mandala.png"), tr("About Mandala-Ensicaen"), tr("Mandala\n\n(c) 2019 Abdelmalik GHOUBIR"), ":/img/ensicaen.jpg", 1);
 }
 
-QString MainWindow::showMessageBox(QIcon icon, QString title, QString text, QPixmap pixmap, int buttonsNumber) {
+QString MainWindow::showMessageBox(QIcon icon, QString title, QString text, QString pixmapPath, int buttonsNumber) {
     QMessageBox message;
     message.setWindowIcon(icon);
     message.setWindowTitle(title);
@@ -139,9 +292,9 @@ QString MainWindow::showMessageBox(QIcon icon, QString title, QString text, QPix
         message.setDefaultButton(QMessageBox::No);
     }
 
+    // The image is decoded and scaled the first time a message box shows it (at the pixel ratio of the screen)
     QSize myRessortSize(100,100);
-    QPixmap pixmap1 = pixmap.scaled(myRessortSize,Qt::IgnoreAspectRatio,Qt::SmoothTransformation);
-    message.setIconPixmap(pixmap1);
+    message.setIconPixmap(ResourceCache::scaledPixmap(pixmapPath, myRessortSize, devicePixelRatio()));
     message.show();
     message.exec();
 
@@ -157,54 +310,623 @@ void MainWindow::actionSaveAs_triggered() {
 
 
     qDebug() << selectedFilter;
+    if(fileName.isEmpty() || _imageExportWatcher->isRunning())
+        return;
+    QString format = QFileInfo(fileName).suffix().toLower();
+    if(format == "jpeg")
+        format = "jpg";
+    if(!askImageExportSettings(format))
+        return;
+
     // we don't need to save the splices and the mirror lines ;)
-    bool gridState = ui->grid->isChecked();
-    bool mirrorState = ui->mirrorCheckBox->isChecked();
-
-    ui->grid->setChecked(false);
-    ui->mirrorCheckBox->setChecked(false);
-    if (!fileName.isEmpty()) {
-        QPixmap pixMap = ui->graphicsView->grab();
-        pixMap.save(fileName);
+    // the exported image is read from the content layers composite: the grid and mirror options stay untouched and nothing is redrawn
+    // (an export scale other than the pixel ratio of the screen is rendered offscreen).
+    // The image is copied before it is handed to the workers: the next export paints the view buffer again
+    QImage image = ui->graphicsView->exportImage(_exportScale).copy();
+    _documentTabs->setTabText(_activeDocument, QFileInfo(fileName).fileName());
+    statusBar()->showMessage(tr("Saving the image..."));
+    _imageExportWatcher->setFuture(QtConcurrent::run(&ImageExporter::exportImage, image, _imageExportSettings, fileName));
+}
+
+bool MainWindow::askImageExportSettings(const QString & format) {
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Image Options"));
+    QFormLayout * form = new QFormLayout(&dialog);
+    QComboBox * paletteComboBox = nullptr;
+    QSpinBox * colorsSpinBox = nullptr;
+    QSpinBox * compressionSpinBox = nullptr;
+    QComboBox * filterComboBox = nullptr;
+    QSpinBox * qualitySpinBox = nullptr;
+
+    if(format == "jpg") {
+        qualitySpinBox = new QSpinBox(&dialog);
+        qualitySpinBox->setRange(0, 100);
+        qualitySpinBox->setValue(_imageExportSettings.jpegQuality);
+        form->addRow(tr("Quality"), qualitySpinBox);
+    } else {
+        // An image with fewer colors than the palette keeps its exact colors whatever the method
+        paletteComboBox = new QComboBox(&dialog);
+        paletteComboBox->addItem(tr("Median cut"), ImageExportSettings::MedianCut);
+        paletteComboBox->addItem(tr("Octree"), ImageExportSettings::Octree);
+        paletteComboBox->addItem(tr("Full color"), ImageExportSettings::FullColor);
+        paletteComboBox->setCurrentIndex(paletteComboBox->findData(_imageExportSettings.palette));
+        form->addRow(tr("Palette"), paletteComboBox);
+        colorsSpinBox = new QSpinBox(&dialog);
+        colorsSpinBox->setRange(2, 256);
+        colorsSpinBox->setValue(_imageExportSettings.colors);
+        form->addRow(tr("Colors"), colorsSpinBox);
+    }
+    if(format == "png") {
+        compressionSpinBox = new QSpinBox(&dialog);
+        compressionSpinBox->setRange(0, 9);
+        compressionSpinBox->setValue(_imageExportSettings.pngCompression);
+        form->addRow(tr("Compression level"), compressionSpinBox);
+        filterComboBox = new QComboBox(&dialog);
+        filterComboBox->addItem(tr("Adaptive"), ImageExportSettings::Adaptive);
+        filterComboBox->addItem(tr("None"), ImageExportSettings::NoFilter);
+        filterComboBox->addItem(tr("Sub"), ImageExportSettings::Sub);
+        filterComboBox->addItem(tr("Up"), ImageExportSettings::Up);
+        filterComboBox->addItem(tr("Average"), ImageExportSettings::Average);
+        filterComboBox->addItem(tr("Paeth"), ImageExportSettings::Paeth);
+        filterComboBox->setCurrentIndex(filterComboBox->findData(_imageExportSettings.pngFilter));
+        form->addRow(tr("Row filter"), filterComboBox);
+    }
+    QDialogButtonBox * buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    form->addRow(buttons);
+    connect(buttons, SIGNAL(accepted()), &dialog, SLOT(accept()));
+    connect(buttons, SIGNAL(rejected()), &dialog, SLOT(reject()));
+    if(dialog.exec() != QDialog::Accepted)
+        return false;
+
+    QSettings settings;
+    if(qualitySpinBox) {
+        _imageExportSettings.jpegQuality = qualitySpinBox->value();
+        settings.setValue("export/jpegQuality", _imageExportSettings.jpegQuality);
+    }
+    if(paletteComboBox) {
+        _imageExportSettings.palette = ImageExportSettings::Palette(paletteComboBox->currentData().toInt());
+        _imageExportSettings.colors = colorsSpinBox->value();
+        settings.setValue("export/palette", _imageExportSettings.palette);
+        settings.setValue("export/colors", _imageExportSettings.colors);
+    }
+    if(compressionSpinBox) {
+        _imageExportSettings.pngCompression = compressionSpinBox->value();
+        _imageExportSettings.pngFilter = ImageExportSettings::PngFilter(filterComboBox->currentData().toInt());
+        settings.setValue("export/pngCompression", _imageExportSettings.pngCompression);
+        settings.setValue("export/pngFilter", _imageExportSettings.pngFilter);
+    }
+    return true;
+}
+
+void MainWindow::imageExported() {
+    ImageExportReport report = _imageExportWatcher->result();
+    statusBar()->showMessage(report.error.isEmpty() ? tr("Image saved: %1").arg(report.toString()) : report.error, 8000);
+}
+
+void MainWindow::actionExportScale_triggered() {
+    bool ok;
+    double scale = QInputDialog::getDouble(this, tr("Export Scale"),
+                                           tr("Scale of the saved images, relative to the canvas size\n\nCanvas: %1 x %2")
+                                           .arg(ui->graphicsView->canvasSize().width()).arg(ui->graphicsView->canvasSize().height()),
+                                           _exportScale, 0.25, 8, 2, &ok);
+    if(!ok)
+        return;
+
+    _exportScale = scale;
+    QSettings settings;
+    settings.setValue("export/scale", scale);
+}
+
+void MainWindow::actionHostSession_triggered() {
+    QSettings settings;
+    bool ok;
+    int port = QInputDialog::getInt(this, tr("Host Session"),
+                                    tr("Port of the session\n\nThe other instances join it with the address of this host and this port"),
+                                    settings.value("session/port", CollabServer::DefaultPort).toInt(), 1024, 65535, 1, &ok);
+    if(!ok)
+        return;
+
+    // We host the relay and join it like the other clients: our strokes are ordered with theirs
+    actionLeaveSession_triggered();
+    _collabServer = new CollabServer(this);
+    if(!_collabServer->listen(QHostAddress::Any, port)) {
+        QMessageBox::warning(this, tr("Host Session"), tr("The session could not be started:\n%1").arg(_collabServer->errorString()));
+        delete _collabServer;
+        _collabServer = nullptr;
+        return;
+    }
+    settings.setValue("session/port", port);
+    _collabSession->connectToHost("127.0.0.1", _collabServer->port());
+}
+
+void MainWindow::actionJoinSession_triggered() {
+    QSettings settings;
+    bool ok;
+    QString address = QInputDialog::getText(this, tr("Join Session"), tr("Address of the session (host:port)"), QLineEdit::Normal,
+                                            settings.value("session/host", QString("127.0.0.1:%1").arg(CollabServer::DefaultPort)).toString(), &ok);
+    if(!ok || address.isEmpty())
+        return;
+
+    QStringList parts = address.split(':');
+    quint16 port = CollabServer::DefaultPort;
+    if(parts.size() > 1) {
+        port = parts.last().toUShort(&ok);
+        if(!ok) {
+            QMessageBox::warning(this, tr("Join Session"), tr("The port of %1 is not valid").arg(address));
+            return;
+        }
+    }
+
+    actionLeaveSession_triggered();
+    settings.setValue("session/host", address);
+    _collabSession->connectToHost(parts.first(), port);
+}
+
+void MainWindow::actionLeaveSession_triggered() {
+    _collabSession->disconnectFromHost();
+    if(_collabServer) {
+        delete _collabServer;
+        _collabServer = nullptr;
+    }
+}
+
+void MainWindow::sessionJoined(quint32 clientId) {
+    _sessionBytesSent = _collabSession->bytesSent();
+    _sessionBytesReceived = _collabSession->bytesReceived();
+    _sessionLabel->setText(tr("Session: client %1").arg(clientId));
+    _sessionLabel->show();
+    _sessionTimer->start();
+    ui->actionLeave_Session->setEnabled(true);
+    statusBar()->showMessage(_collabServer ? tr("Hosting the session on port %1").arg(_collabServer->port()) : tr("Joined the session"), 3000);
+}
+
+void MainWindow::sessionLeft(QString reason) {
+    _sessionTimer->stop();
+    _sessionLabel->hide();
+    ui->actionLeave_Session->setEnabled(false);
+    if(!reason.isEmpty())
+        statusBar()->showMessage(tr("Left the session: %1").arg(reason), 5000);
+}
+
+void MainWindow::updateSessionRate() {
+    // The rates are the bytes counted since the last refresh, a second ago
+    qint64 sent = _collabSession->bytesSent();
+    qint64 received = _collabSession->bytesReceived();
+    _sessionLabel->setText(tr("Session: client %1, up %2 KB/s, down %3 KB/s").arg(_collabSession->clientId())
+                           .arg((sent - _sessionBytesSent) / 1024.0, 0, 'f', 1).arg((received - _sessionBytesReceived) / 1024.0, 0, 'f', 1));
+    _sessionBytesSent = sent;
+    _sessionBytesReceived = received;
+}
+
+void MainWindow::actionExportTile_triggered() {
+    QRectF tile;
+    if(!ui->graphicsView->seamlessTileRect(tile)) {
+        showMessageBox(QIcon(":/img/mandala.png"), tr("Export Seamless Tile"),
+                       tr("Only a wallpaper drawn in mandala mode has a seamless tile.\n\nChoose a wallpaper group in the symmetry panel."),
+                       ":/img/ensicaen.jpg", 1);
+        return;
+    }
+    if(_tileExportWatcher->isRunning())
+        return;
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Export Seamless Tile"));
+    QFormLayout * form = new QFormLayout(&dialog);
+    QSpinBox * sizeSpinBox = new QSpinBox(&dialog);
+    sizeSpinBox->setRange(16, 8192);
+    sizeSpinBox->setSuffix(tr(" px"));
+    sizeSpinBox->setValue(1024);
+    form->addRow(tr("Tile width"), sizeSpinBox);
+    QComboBox * filterComboBox = new QComboBox(&dialog);
+    filterComboBox->addItem(tr("Lanczos"), TileExportSettings::Lanczos);
+    filterComboBox->addItem(tr("Box"), TileExportSettings::Box);
+    form->addRow(tr("Mipmap filter"), filterComboBox);
+    QComboBox * layoutComboBox = new QComboBox(&dialog);
+    layoutComboBox->addItem(tr("Packed atlas"));
+    layoutComboBox->addItem(tr("Separate images"));
+    form->addRow(tr("Output"), layoutComboBox);
+    QDialogButtonBox * buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    form->addRow(buttons);
+    connect(buttons, SIGNAL(accepted()), &dialog, SLOT(accept()));
+    connect(buttons, SIGNAL(rejected()), &dialog, SLOT(reject()));
+    if(dialog.exec() != QDialog::Accepted)
+        return;
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export Seamless Tile"), QCoreApplication::applicationDirPath(), "PNG (*.png)");
+    if(fileName.isEmpty())
+        return;
+
+    TileExportSettings settings;
+    settings.filter = TileExportSettings::Filter(filterComboBox->currentData().toInt());
+    settings.atlas = (layoutComboBox->currentIndex() == 0);
+
+    // The tile keeps the aspect ratio of the lattice cell, it is the only rendering done on the GUI thread: the symmetry projection is rasterized
+    // directly at the tile resolution, so the pyramid starts from sharp pixels instead of an upscale of the screen
+    QSize size(sizeSpinBox->value(), qMax(1, qRound(sizeSpinBox->value() * tile.height() / tile.width())));
+    QImage image = ui->graphicsView->renderArea(tile, size);
+
+    SymmetrySettings symmetry = _symmetryPanel->settings();
+    QJsonObject description;
+    description["group"] = SymmetryEngine::wallpaperGroupName(symmetry.wallpaperGroup);
+    description["cellSize"] = symmetry.cellSize;
+    description["sceneWidth"] = tile.width();
+    description["sceneHeight"] = tile.height();
+
+    statusBar()->showMessage(tr("Exporting the seamless tile..."));
+    ui->actionExport_Tile->setEnabled(false);
+    _tileExportWatcher->setFuture(QtConcurrent::run(&TileExporter::exportTile, image, settings, fileName, description));
+}
+
+void MainWindow::tileExported() {
+    ui->actionExport_Tile->setEnabled(ui->actionSave_As->isEnabled());
+    QString error = _tileExportWatcher->result();
+    statusBar()->showMessage(error.isEmpty() ? tr("Seamless tile exported") : error, 5000);
+}
+
+void MainWindow::actionMemoryLimit_triggered() {
+    MemoryBudget * budget = MemoryBudget::instance();
+    bool ok;
+    int megabytes = QInputDialog::getInt(this, tr("Memory Limit"),
+                                         tr("Memory the drawing, its history and the caches may use, in MB (0: no limit)\n\nIn use: %1 MB")
+                                         .arg(budget->usedBytes() / (1024 * 1024)),
+                                         int(budget->ceiling() / (1024 * 1024)), 0, 1024 * 1024, 64, &ok);
+    if(!ok)
+        return;
+
+    qint64 ceiling = qint64(megabytes) * 1024 * 1024;
+    QSettings settings;
+    settings.setValue("memory/ceiling", ceiling);
+    budget->setCeiling(ceiling);
+}
+
+void MainWindow::actionRunScript_triggered() {
+    if(_scriptWatcher->isRunning())
+        return;
+
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Run A Mandala Script"), QString(), tr("Mandala scripts (*.mds *.txt)"));
+    if(fileName.isEmpty())
+        return;
+
+    MandalaScript script;
+    if(!script.load(fileName)) {
+        showMessageBox(QIcon(":/img/mandala.png"), tr("Run Script"), script.errorString(), ":/img/ensicaen.jpg", 1);
+        return;
     }
-    ui->grid->setChecked(gridState);
-    ui->mirrorCheckBox->setChecked(mirrorState);
 
+    // Each variation is rendered offscreen by a worker: the painting widget is never touched
+    QVector<ScriptVariation> variations = script.variations();
+    ui->actionRun_Script->setEnabled(false);
+    _scriptWatcher->setFuture(QtConcurrent::mapped(variations, &MandalaScript::renderAndExport));
+    statusBar()->showMessage(tr("Rendering %1 variations...").arg(variations.size()));
+}
+
+void MainWindow::scriptProgress(int done) {
+    statusBar()->showMessage(tr("Rendering variations: %1 / %2").arg(done).arg(_scriptWatcher->progressMaximum()));
+}
+
+void MainWindow::scriptFinished() {
+    ui->actionRun_Script->setEnabled(true);
+    int variations = _scriptWatcher->future().resultCount();
+    QStringList failures;
+    for(int i=0; i<variations; ++i) {
+        ScriptReport report = _scriptWatcher->resultAt(i);
+        if(!report.error.isEmpty())
+            failures << report.toString();
+    }
+
+    if(failures.isEmpty()) {
+        statusBar()->showMessage(tr("%1 variations rendered").arg(variations), 5000);
+        return;
+    }
+    // The message box lists the first failures only, a sweep may fail on every variation for the same reason
+    const int listedFailures = 10;
+    statusBar()->showMessage(tr("%1 variations rendered, %2 failed").arg(variations - failures.size()).arg(failures.size()), 8000);
+    showMessageBox(QIcon(":/img/mandala.png"), tr("Run Script"),
+                   tr("%1 of the %2 variations could not be exported:\n\n%3").arg(failures.size()).arg(variations)
+                   .arg(failures.mid(0, listedFailures).join("\n") + (failures.size() > listedFailures ? "\n..." : "")),
+                   ":/img/ensicaen.jpg", 1);
+}
+
+void MainWindow::updateMemoryUsage(qint64 usedBytes, qint64 ceiling) {
+    const qint64 megabyte = 1024 * 1024;
+    if(ceiling > 0)
+        _memoryLabel->setText(tr("Memory: %1 / %2 MB").arg(usedBytes / megabyte).arg(ceiling / megabyte));
+    else
+        _memoryLabel->setText(tr("Memory: %1 MB").arg(usedBytes / megabyte));
+
+    QStringList details;
+    QVector<MemoryUsage> usages = MemoryBudget::instance()->usages();
+    for(auto iter = usages.begin(); iter != usages.end(); ++iter)
+        details << QString("%1: %2 KB").arg(iter->name).arg(iter->bytes / 1024);
+    _memoryLabel->setToolTip(details.join("\n"));
 }
 
 void MainWindow::actionOpenFile_triggered() {
     QString file = QFileDialog::getOpenFileName(this, tr("Open An Existing Image"), QString(), "Images (*.png *.jpg *.jpeg *.bmp)");
 
     if (!file.isEmpty())
-        ui->graphicsView->openImage(file);
+        openDocument(file);
 }
 
-void MainWindow::actionNewFile_triggered() {
-    if(!ui->graphicsView->sceneIsEmpty()) {
-        QString warningResponse = showMessageBox(QIcon(":/img/mandala.png"), tr("WARNING"),
-                                  tr("Are you sure you want to create a new image?\n\nThis will clear all your drawn items history...\n\nSave your image if not done!"),
-                                  QPixmap(":/img/ensicaen.jpg"), 2);
-
-        if(warningResponse == "&Yes") {
-            _color = Qt::white;
-            QPixmap pixmap(70,70);
-            pixmap.fill(_color);
-            ui->colorButton->setIcon(QIcon(pixmap));
-            ui->lineWidthWidget->setPenColor(_color);
-            if(!_eraserActive)
-                ui->graphicsView->setPenColor(_color);
-            _singlePaintMode = true;
-            ui->lineWidthSlider->setValue(2);
-            ui->pixelComboBox->setCurrentIndex(0);
-            ui->singlePainterActivator->setText(tr("Single Mode"));
-
-            ui->graphicsView->clearAllHistories();
-
-            ui->sliceSlider->setValue(2);
-            ui->graphicsView->setAndDrawSlices(0);
+void MainWindow::openGalleryImage(QString file) {
+    // We can only open an image once the painting widget has a size
+    if(ui->action_Open_File->isEnabled())
+        openDocument(file);
+}
+
+void MainWindow::openDocument(const QString & file) {
+    QString title = QFileInfo(file).fileName();
+    if(!ui->graphicsView->sceneIsEmpty())
+        newDocument(title);
+    else
+        _documentTabs->setTabText(_activeDocument, title);
+    ui->graphicsView->openImage(file);
+}
+
+void MainWindow::newDocument(const QString & title) {
+    // A new document is drawn with the settings of the one we leave
+    HibernatedDocument document;
+    document.canvasSize = ui->graphicsView->canvasSize();
+    document.settings = ui->graphicsView->documentSettings();
+    _documents.push_back(document);
+    _documentTabs->setCurrentIndex(_documentTabs->addTab(title));
+}
+
+void MainWindow::switchDocument(int index) {
+    // index is the tab already in the view while a tab before it is removed
+    if(index < 0 || index == _activeDocument || index >= _documents.size())
+        return;
+
+    // The document we leave is flattened and compressed in the background, the one we show is decoded once, now
+    _documents[_activeDocument] = ui->graphicsView->hibernateDocument();
+    HibernatedDocument document = _documents[index];
+    _documents[index] = HibernatedDocument();
+    _activeDocument = index;
+
+    // A drawn document keeps its canvas size: the size combo box resizes the view to it (an empty one takes the current size)
+    if(!document.content.isNull() && document.canvasSize.isValid() && ui->action_Open_File->isEnabled()) {
+        QString size = QString("%1x%2").arg(document.canvasSize.width()).arg(document.canvasSize.height());
+        int sizeIndex = ui->pixelComboBox->findText(size);
+        if(sizeIndex < 0) {
+            ui->pixelComboBox->addItem(size);
+            sizeIndex = ui->pixelComboBox->count() - 1;
+        }
+        ui->pixelComboBox->setCurrentIndex(sizeIndex);
+    } else {
+        document.canvasSize = ui->graphicsView->canvasSize();
+    }
+    ui->graphicsView->restoreDocument(document);
+    showDocumentSettings(document.settings);
+    updateLayerComboBox();
+}
+
+void MainWindow::closeDocument(int index) {
+    bool empty = (index == _activeDocument) ? ui->graphicsView->sceneIsEmpty() : _documents[index].content.isNull();
+    if(!empty) {
+        QString closeResponse = showMessageBox(QIcon(":/img/mandala.png"), tr("Close %1?").arg(_documentTabs->tabText(index)),
+                                               tr("Are you sure you want to close this drawing?\n\nIts drawn items and its history will be lost...\n\nSave your image if not done!"),
+                                               ":/img/ensicaen.jpg", 2);
+        if(closeResponse != "&Yes")
+            return;
+    }
+
+    // The last tab is never closed: it is emptied
+    if(_documents.size() == 1) {
+        HibernatedDocument document;
+        document.canvasSize = ui->graphicsView->canvasSize();
+        document.settings = ui->graphicsView->documentSettings();
+        ui->graphicsView->restoreDocument(document);
+        updateLayerComboBox();
+        _documentTabs->setTabText(0, tr("Untitled %1").arg(++_untitledCount));
+        return;
+    }
+
+    // The closed document is emptied before we leave it: there is nothing left to compress
+    if(index == _activeDocument) {
+        ui->graphicsView->clearAllHistories();
+        _documentTabs->setCurrentIndex(index > 0 ? index - 1 : index + 1);
+    }
+    // The closed document has nothing to recover anymore
+    if(!_documents[index].journalDirectory.isEmpty())
+        QDir(_documents[index].journalDirectory).removeRecursively();
+    _documents.remove(index);
+    if(index < _activeDocument)
+        --_activeDocument;
+    _documentTabs->removeTab(index);
+}
+
+void MainWindow::updateLayerComboBox() {
+    ui->layerComboBox->clear();
+    for(int i=0; i<ui->graphicsView->strokeLayerCount(); ++i)
+        ui->layerComboBox->addItem(ui->graphicsView->strokeLayerName(i));
+}
+
+void MainWindow::showDocumentSettings(const DocumentSettings & settings) {
+    // The widgets follow the document without their signals: the view would project it again with what it already has
+    QSignalBlocker sliceBlocker(ui->sliceSlider), spinBoxBlocker(ui->spinBox), mirrorBlocker(ui->mirrorCheckBox);
+    if(settings.slices > 0) {
+        ui->sliceSlider->setValue(settings.slices);
+        ui->spinBox->setValue(settings.slices);
+    }
+    ui->mirrorCheckBox->setChecked(settings.mirror);
+    _hsvActivator = settings.rainbow;
+    _paletteGroup->actions().at(settings.palette)->setChecked(true);
+    _symmetryPanel->setSettings(settings.symmetry);
+
+    // The mode buttons are only enabled while we can paint
+    _singlePaintMode = (settings.slices == 0);
+    ui->singlePainterActivator->setText(_singlePaintMode ? tr("Single Mode") : tr("Mandala Mode"));
+    bool mandalaTools = !_singlePaintMode && ui->singlePainterActivator->isEnabled();
+    ui->mirrorCheckBox->setEnabled(mandalaTools);
+    ui->multiColor->setEnabled(mandalaTools);
+    ui->spinBox->setEnabled(mandalaTools);
+    ui->sliceSlider->setEnabled(mandalaTools);
+    ui->grid->setEnabled(mandalaTools);
+    if(!mandalaTools)
+        ui->grid->setChecked(false);
+}
+
+qint64 MainWindow::releaseDocumentHistories(qint64 bytes) {
+    qint64 released = 0;
+    for(auto iter = _documents.begin(); iter != _documents.end() && released < bytes; ++iter) {
+        while(!iter->redoHistory.isEmpty() && released < bytes) {
+            released += iter->redoHistory.first().byteCount();
+            iter->redoHistory.remove(0);
+        }
+    }
+    for(auto iter = _documents.begin(); iter != _documents.end() && released < bytes; ++iter) {
+        while(iter->undoHistory.size() > 1 && released < bytes) {
+            released += iter->undoHistory.first().byteCount();
+            iter->undoHistory.remove(0);
+            iter->historyTruncated = true;
+        }
+    }
+    return released;
+}
+
+void MainWindow::journalRecovered() {
+    QVector<JournalRecovery> recoveries = _journalWatcher->result();
+    _journalRecovered = true;
+    bool hasCanvas = ui->action_Open_File->isEnabled();
+
+    // Each document of the crashed session has its journal: a journal of an empty canvas has nothing to give back
+    QVector<JournalRecovery> drawn;
+    for(auto iter = recoveries.begin(); iter != recoveries.end(); ++iter) {
+        if(iter->isValid() && !iter->isEmpty())
+            drawn.push_back(*iter);
+        else
+            QDir(iter->directory).removeRecursively();
+    }
+
+    QString recoverResponse;
+    if(drawn.size() == 1)
+        recoverResponse = showMessageBox(QIcon(":/img/mandala.png"), tr("Recover your mandala?"),
+                                         tr("The application was closed before your last mandala was saved.\n\nDo you want to recover it? It opens in a new tab."),
+                                         ":/img/ensicaen.jpg", 2);
+    else if(drawn.size() > 1)
+        recoverResponse = showMessageBox(QIcon(":/img/mandala.png"), tr("Recover your mandalas?"),
+                                         tr("The application was closed before %1 of your mandalas were saved.\n\nDo you want to recover them? Each one opens in a new tab.")
+                                         .arg(drawn.size()),
+                                         ":/img/ensicaen.jpg", 2);
+
+    if(recoverResponse != "&Yes") {
+        for(auto iter = drawn.begin(); iter != drawn.end(); ++iter)
+            QDir(iter->directory).removeRecursively();
+        if(hasCanvas)
+            ui->graphicsView->setJournalEnabled(true);
+        return;
+    }
+
+    for(int i=0; i<drawn.size(); ++i) {
+        // A recovered mandala never replaces what was drawn since the start: it gets its own tab
+        QString title = drawn.size() == 1 ? tr("Recovered") : tr("Recovered %1").arg(i + 1);
+        if(!ui->graphicsView->sceneIsEmpty())
+            newDocument(title);
+        else
+            _documentTabs->setTabText(_activeDocument, title);
+
+        QString size = QString("%1x%2").arg(drawn[i].canvasSize.width()).arg(drawn[i].canvasSize.height());
+        int index = ui->pixelComboBox->findText(size);
+        if(index < 0) {
+            ui->pixelComboBox->addItem(size);
+            index = ui->pixelComboBox->count() - 1;
         }
+        // The canvas already has the recovered size when the combo box doesn't change: journaling is turned on here
+        if(index == ui->pixelComboBox->currentIndex())
+            ui->graphicsView->setJournalEnabled(true);
+        else
+            ui->pixelComboBox->setCurrentIndex(index);
+        // The document takes over the recovered journal directory
+        ui->graphicsView->replayJournal(drawn[i]);
+        updateLayerComboBox();
     }
+}
+
+void MainWindow::showJournalError(QString error) {
+    statusBar()->showMessage(tr("The drawing isn't autosaved: %1").arg(error), 10000);
+}
+
+void MainWindow::actionNewFile_triggered() {
+    // The new document opens in its own tab: the current one keeps its drawing and its history in its tab
+    newDocument(tr("Untitled %1").arg(++_untitledCount));
+}
+
+void MainWindow::actionNewLayer_triggered() {
+    int index = ui->graphicsView->addStrokeLayer(tr("Layer %1").arg(ui->graphicsView->strokeLayerCount() + 1));
+    ui->layerComboBox->addItem(ui->graphicsView->strokeLayerName(index));
+    ui->layerComboBox->setCurrentIndex(index);
+}
+
+void MainWindow::actionResetZoom_triggered() {
+    ui->graphicsView->resetZoom();
+}
+
+void MainWindow::generateMandala(GeneratorSettings settings) {
+    QElapsedTimer timer;
+    timer.start();
+    QVector<QLineF> lines = ui->graphicsView->generate(settings);
+    _generatorPanel->showResult(MandalaGenerator::fingerprint(lines), lines.size(), timer.elapsed());
+}
+
+void MainWindow::setSymmetry(SymmetrySettings settings) {
+    ui->graphicsView->setSymmetrySettings(settings);
+}
+
+void MainWindow::setStabilizer(StabilizerSettings settings) {
+    ui->graphicsView->setStabilizerSettings(settings);
+}
+
+void MainWindow::showLatency() {
+    _stabilizerPanel->showLatency(ui->graphicsView->inputLatency().summary(), ui->graphicsView->tipLatency().summary());
+}
+
+void MainWindow::resetLatency() {
+    ui->graphicsView->resetLatency();
+    showLatency();
+}
+
+void MainWindow::stabilizerPanelVisibilityChanged(bool visible) {
+    // The latency is only refreshed while we can see it, and only changes while we draw: the timer runs during the strokes
+    if(visible)
+        showLatency();
+    else
+        _latencyTimer->stop();
+}
+
+void MainWindow::startLatencyRefresh() {
+    if(_stabilizerPanel->isVisible())
+        _latencyTimer->start();
+}
+
+void MainWindow::stopLatencyRefresh() {
+    if(!_latencyTimer->isActive())
+        return;
+    _latencyTimer->stop();
+    showLatency();
+}
+
+void MainWindow::selectPalette(QAction * action) {
+    ui->graphicsView->setColorPalette(ColorEngine::Palette(_paletteGroup->actions().indexOf(action)));
+}
+
+void MainWindow::actionGradientColors_triggered() {
+    QGradientStops stops = ui->graphicsView->gradientStops();
+    QColor first = QColorDialog::getColor(stops.first().second, this, tr("Gradient Start Color"));
+    if(!first.isValid())
+        return;
+    QColor last = QColorDialog::getColor(stops.last().second, this, tr("Gradient End Color"));
+    if(!last.isValid())
+        return;
 
+    stops.clear();
+    stops << QGradientStop(0, first) << QGradientStop(1, last);
+    ui->graphicsView->setGradientStops(stops);
+}
+
+void MainWindow::selectLayer(int index) {
+    // index is -1 while the combo box is cleared
+    if(index >= 0)
+        ui->graphicsView->setCurrentStrokeLayer(index);
 }
 
 void MainWindow::singleModeActivator() {
@@ -238,19 +960,38 @@ void MainWindow::rainbowActivator() {
     ui->graphicsView->setRainbowMode(_hsvActivator);
 }
 
+void MainWindow::deviceScaleChanged() {
+    // The window moved to a screen with another pixel ratio: the cursor of the tool is taken again at the new ratio
+    if(ui->graphicsView->cursor().shape() != Qt::BitmapCursor)
+        return;
+    if(_eraserActive)
+        ui->graphicsView->setCursor(ResourceCache::cursor(ResourceCache::EraserCursor, ui->graphicsView->devicePixelRatio()));
+    else
+        ui->graphicsView->setCursor(ResourceCache::cursor(ResourceCache::BrushCursor, ui->graphicsView->devicePixelRatio()));
+}
+
+void MainWindow::actionSelectStrokes_toggled(bool checked) {
+    // Leaving the selection tool commits the edited stroke and gives the brush or the eraser back
+    ui->graphicsView->setSelectionEnabled(checked);
+    if(checked)
+        ui->graphicsView->setCursor(Qt::ArrowCursor);
+    else if(_eraserActive)
+        ui->graphicsView->setCursor(ResourceCache::cursor(ResourceCache::EraserCursor, ui->graphicsView->devicePixelRatio()));
+    else
+        ui->graphicsView->setCursor(ResourceCache::cursor(ResourceCache::BrushCursor, ui->graphicsView->devicePixelRatio()));
+}
+
 void MainWindow::useTheBrush() {
     _eraserActive = false;
-    _brush = QPixmap(":/img/brush.png");
-    _brush = _brush.scaled(QSize(50,70), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-    ui->graphicsView->setCursor(QCursor(_brush,0,0));
+    ui->actionSelect_Strokes->setChecked(false);
+    ui->graphicsView->setCursor(ResourceCache::cursor(ResourceCache::BrushCursor, ui->graphicsView->devicePixelRatio()));
     ui->graphicsView->setPenColor(_color);
 }
 
 void MainWindow::useTheEraser() {
     _eraserActive = true;
-    _brush = QPixmap(":/img/eraser.png");
-    _brush = _brush.scaled(QSize(20,20), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-    ui->graphicsView->setCursor(QCursor(_brush, 10, 10));
+    ui->actionSelect_Strokes->setChecked(false);
+    ui->graphicsView->setCursor(ResourceCache::cursor(ResourceCache::EraserCursor, ui->graphicsView->devicePixelRatio()));
     ui->graphicsView->setPenColor(Qt::white);
 }
 
@@ -287,18 +1028,18 @@ void MainWindow::resizePaintWidget(QString s) {
         ui->action_Redo->setEnabled(true);
         ui->action_Undo->setEnabled(true);
         ui->actionSave_As->setEnabled(true);
+        ui->actionExport_Tile->setEnabled(!_tileExportWatcher->isRunning());
         ui->action_Open_File->setEnabled(true);
+        ui->actionNew_Layer->setEnabled(true);
+        ui->layerComboBox->setEnabled(true);
+        _generatorPanel->setEnabled(true);
+        _symmetryPanel->setEnabled(true);
         ui->widget->setStyleSheet("background-color:rgb(218,218,218);border-color: rgb(0, 85, 255);border-style: outset;border-width: 2px;border-radius: 10px;");
-        if(_eraserActive) {
-            _brush = QPixmap(":/img/eraser.png");
-            _brush = _brush.scaled(QSize(20,20), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-            ui->graphicsView->setCursor(QCursor(_brush, 10, 10));
-        } else {
-            _brush = QPixmap(":/img/brush.png");
-            ui->graphicsView->setCursor(QCursor(_brush,0,0));
-            _brush = _brush.scaled(QSize(50,70), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-            ui->graphicsView->setCursor(QCursor(_brush,0,0));
-        }
+        // The cursors are scaled once, the first time they are used
+        if(_eraserActive)
+            ui->graphicsView->setCursor(ResourceCache::cursor(ResourceCache::EraserCursor, ui->graphicsView->devicePixelRatio()));
+        else
+            ui->graphicsView->setCursor(ResourceCache::cursor(ResourceCache::BrushCursor, ui->graphicsView->devicePixelRatio()));
         if(!_singlePaintMode) {
             ui->mirrorCheckBox->setEnabled(true);
             ui->multiColor->setEnabled(true);
@@ -316,6 +1057,7 @@ void MainWindow::resizePaintWidget(QString s) {
 
         ui->graphicsView->setStyleSheet("background-color: rgb(255, 255, 255);border: inherit;border-radius: inherit;");
         ui->graphicsView->resize(s.split("x")[0].toInt(), s.split("x")[0].toInt());
+        ui->graphicsView->setCanvasSize(QSize(s.split("x")[0].toInt(), s.split("x")[0].toInt()));
 
         int x = (ui->widget->width() - ui->graphicsView->width())/2;
         int y = (ui->widget->height() - ui->graphicsView->height())/2;
@@ -324,12 +1066,21 @@ void MainWindow::resizePaintWidget(QString s) {
         ui->graphicsView->clearScene(true);
         if(!ui->graphicsView->undoStackIsEmpty())
             ui->graphicsView->resizePaintedItems();
+        if(_journalRecovered)
+            ui->graphicsView->setJournalEnabled(true);
     }
     else {
         ui->action_Redo->setEnabled(false);
         ui->action_Undo->setEnabled(false);
         ui->actionSave_As->setEnabled(false);
+        ui->actionExport_Tile->setEnabled(false);
         ui->action_Open_File->setEnabled(false);
+        ui->actionNew_Layer->setEnabled(false);
+        ui->layerComboBox->setEnabled(false);
+        _generatorPanel->setEnabled(false);
+        _symmetryPanel->setEnabled(false);
+        if(_journalRecovered)
+            ui->graphicsView->setJournalEnabled(false);
         ui->widget->setStyleSheet("border-color: rgb(218, 218, 218);");
 
         ui->graphicsView->setCursor(QCursor());
@@ -372,14 +1123,23 @@ void MainWindow::openRGBWindow() {
     ui->lineWidthWidget->setPenColor(_color);
     if(!_eraserActive)
         ui->graphicsView->setPenColor(_color);
+    // With the selection tool, the chosen color recolors the selected stroke
+    if(ui->actionSelect_Strokes->isChecked() && _color.isValid())
+        ui->graphicsView->setSelectedStrokeColor(_color);
 }
 
 void MainWindow::closeEvent (QCloseEvent * event) {
     QString exitResponse = showMessageBox(QIcon(":/img/mandala.png"), tr("You want to quit..."),
                                           tr("Are you sure you want to exit the application?"),
-                                          QPixmap(":/img/ensicaen.jpg"), 2);
+                                          ":/img/ensicaen.jpg", 2);
 
     (exitResponse != "&Yes")?event->ignore():event->accept();
+
+    // The user chose to quit: there is nothing to recover at the next start, in any tab
+    if(event->isAccepted()) {
+        ui->graphicsView->setJournalEnabled(false);
+        QDir(StrokeJournal::defaultDirectory()).removeRecursively();
+    }
 }
 
 void MainWindow::resizeEvent(QResizeEvent*) {
@@ -0,0 +1,215 @@
+/**
+ * @file   mandalaGenerator.cpp
+ * @date   October 2026
+ *
+ * @brief  mandalaGenerator generates the lines of a mandala slice from parameters (seeded random strokes, rosettes, spirographs and L-system motifs):
+ * the generated lines go through the same symmetry pipeline as the lines drawn by the user
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "mandalaGenerator.h"
+#include <QCryptographicHash>
+#include <QStack>
+#include <QString>
+#include <QtEndian>
+#include <math.h>
+
+const double MandalaGenerator::Quantum = 1.0/64;
+
+// SeededRandom:
+SeededRandom::SeededRandom(quint64 seed) : _state(seed) {
+}
+
+quint64 SeededRandom::next() {
+    quint64 z = (_state += Q_UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+double SeededRandom::uniform() {
+    // The 53 high bits fill exactly the mantissa of a double
+    return (next() >> 11) * (1.0/9007199254740992.0);
+}
+
+double SeededRandom::uniform(double minimum, double maximum) {
+    return minimum + (maximum - minimum) * uniform();
+}
+
+// MandalaGenerator:
+QVector<QLineF> MandalaGenerator::generate(const GeneratorSettings & settings, QPointF center, int slices) {
+    SeededRandom random(settings.seed);
+    double wedge = (slices > 0) ? 2*M_PI/slices : 2*M_PI;
+
+    QVector<QLineF> lines;
+    lines.reserve(settings.segments);
+    switch(settings.pattern) {
+    case GeneratorSettings::RandomStrokes:
+        generateRandomStrokes(settings, random, wedge, lines);
+        break;
+    case GeneratorSettings::Rosette:
+        generateRosette(settings, random, wedge, lines);
+        break;
+    case GeneratorSettings::Spirograph:
+        generateSpirograph(settings, random, wedge, lines);
+        break;
+    case GeneratorSettings::LSystem:
+        generateLSystem(settings, random, wedge, lines);
+        break;
+    }
+
+    // Move the lines around the symmetry center (the y axis of the scene goes down)
+    for(auto iter = lines.begin(); iter != lines.end(); ++iter) {
+        QPointF p1(center.x() + iter->x1(), center.y() - iter->y1());
+        QPointF p2(center.x() + iter->x2(), center.y() - iter->y2());
+        *iter = QLineF(quantize(p1), quantize(p2));
+    }
+    return lines;
+}
+
+QByteArray MandalaGenerator::fingerprint(const QVector<QLineF> & lines) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for(auto iter = lines.begin(); iter != lines.end(); ++iter) {
+        // The points are on the Quantum grid: the integer coordinates on this grid are exact, and little endian on all the platforms
+        qint64 coordinates[4] = {
+            qToLittleEndian(qint64(qRound64(iter->x1() / Quantum))),
+            qToLittleEndian(qint64(qRound64(iter->y1() / Quantum))),
+            qToLittleEndian(qint64(qRound64(iter->x2() / Quantum))),
+            qToLittleEndian(qint64(qRound64(iter->y2() / Quantum)))
+        };
+        hash.addData(reinterpret_cast<const char *>(coordinates), sizeof(coordinates));
+    }
+    return hash.result().toHex();
+}
+
+QPointF MandalaGenerator::quantize(QPointF point) {
+    return QPointF(qRound64(point.x() / Quantum) * Quantum, qRound64(point.y() / Quantum) * Quantum);
+}
+
+void MandalaGenerator::generateRandomStrokes(const GeneratorSettings & settings, SeededRandom & random, double wedge, QVector<QLineF> & lines) {
+    // Random walks starting in the wedge: they turn back when they reach the radius
+    int steps = 32;
+    int strokes = qMax(1, settings.segments / steps);
+    double stepLength = settings.radius / 40;
+
+    for(int i=0; i<strokes && lines.size() < settings.segments; ++i) {
+        double r = settings.radius * sqrt(random.uniform());
+        double angle = wedge * random.uniform();
+        QPointF point(r * cos(angle), r * sin(angle));
+        double heading = 2*M_PI * random.uniform();
+
+        for(int j=0; j<steps && lines.size() < settings.segments; ++j) {
+            heading += random.uniform(-0.6, 0.6);
+            QPointF next = point + stepLength * QPointF(cos(heading), sin(heading));
+            if(sqrt(QPointF::dotProduct(next, next)) > settings.radius) {
+                heading += M_PI;
+                continue;
+            }
+            lines.push_back(QLineF(point, next));
+            point = next;
+        }
+    }
+}
+
+void MandalaGenerator::generateRosette(const GeneratorSettings & settings, SeededRandom & random, double wedge, QVector<QLineF> & lines) {
+    // Concentric petal rings: r(angle) = radius * (base + (1 - base) * |sin(petals * PI * angle / wedge)|)
+    int rings = 1 + int(random.next() % 4);
+    int samples = qMax(2, settings.segments / rings);
+
+    for(int ring=0; ring<rings; ++ring) {
+        double scale = double(ring + 1) / rings;
+        int petals = 1 + int(random.next() % 4);
+        double base = random.uniform(0.2, 0.7);
+
+        QPointF previous;
+        for(int i=0; i<=samples && lines.size() < settings.segments; ++i) {
+            double angle = wedge * i / samples;
+            double r = settings.radius * scale * (base + (1 - base) * fabs(sin(petals * M_PI * angle / wedge)));
+            QPointF point(r * cos(angle), r * sin(angle));
+            if(i > 0)
+                lines.push_back(QLineF(previous, point));
+            previous = point;
+        }
+    }
+}
+
+void MandalaGenerator::generateSpirograph(const GeneratorSettings & settings, SeededRandom & random, double, QVector<QLineF> & lines) {
+    // Hypotrochoid of a wheel of radius p/q * R rolling inside a ring of radius R: the curve closes after p turns (p/q is irreducible)
+    int q = 3 + int(random.next() % 10);
+    int p = 1 + int(random.next() % (q - 1));
+    int a = p, b = q;
+    while(b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    p /= a;
+    q /= a;
+
+    double R = 1;
+    double r = R * p / q;
+    double d = r * random.uniform(0.3, 1.2);
+    double scale = settings.radius / (R - r + d);
+    double turns = 2*M_PI * p;
+    int samples = qMax(1, settings.segments);
+
+    QPointF previous;
+    for(int i=0; i<=samples; ++i) {
+        double t = turns * i / samples;
+        QPointF point(scale * ((R - r) * cos(t) + d * cos((R - r) / r * t)),
+                      scale * ((R - r) * sin(t) - d * sin((R - r) / r * t)));
+        if(i > 0)
+            lines.push_back(QLineF(previous, point));
+        previous = point;
+    }
+}
+
+void MandalaGenerator::generateLSystem(const GeneratorSettings & settings, SeededRandom & random, double wedge, QVector<QLineF> & lines) {
+    // Branching plants: a turtle interprets the rewritten axiom (F: forward, +/-: turn, [ and ]: push and pop the turtle)
+    static const char * rules[] = { "F[+F]F[-F]F", "FF-[-F+F+F]+[+F-F-F]", "F[+F]F[-F][F]" };
+    QString rule = QString::fromLatin1(rules[random.next() % 3]);
+    double turn = qMin(wedge / 4, M_PI / 7) * random.uniform(0.8, 1.2);
+
+    QString word = QStringLiteral("F");
+    for(int iteration=0; iteration<8 && word.count(QLatin1Char('F')) < settings.segments; ++iteration) {
+        QString rewritten;
+        for(QChar c : word)
+            rewritten += (c == QLatin1Char('F')) ? rule : QString(c);
+        word = rewritten;
+    }
+
+    // The plant grows from the center along the middle of the wedge, with an unit step: it is scaled to the radius afterwards
+    struct Turtle { QPointF position; double heading; };
+    Turtle turtle = { QPointF(0, 0), wedge / 2 };
+    QStack<Turtle> stack;
+    int first = lines.size();
+    double extent = 0;
+
+    for(QChar c : word) {
+        if(lines.size() >= settings.segments)
+            break;
+        if(c == QLatin1Char('F')) {
+            QPointF next = turtle.position + QPointF(cos(turtle.heading), sin(turtle.heading));
+            lines.push_back(QLineF(turtle.position, next));
+            turtle.position = next;
+            extent = qMax(extent, sqrt(QPointF::dotProduct(next, next)));
+        } else if(c == QLatin1Char('+')) {
+            turtle.heading += turn;
+        } else if(c == QLatin1Char('-')) {
+            turtle.heading -= turn;
+        } else if(c == QLatin1Char('[')) {
+            stack.push(turtle);
+        } else if(c == QLatin1Char(']') && !stack.isEmpty()) {
+            turtle = stack.pop();
+        }
+    }
+
+    if(extent > 0) {
+        double scale = settings.radius / extent;
+        for(int i=first; i<lines.size(); ++i)
+            lines[i] = QLineF(lines[i].p1() * scale, lines[i].p2() * scale);
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ * @file   mandalaRasterizer.cpp
+ * @date   October 2026
+ *
+ * @brief  mandalaRasterizer paints batches of mandala segments (the user line and all its symmetrical copies) into a TiledRaster using all the CPU cores
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "mandalaRasterizer.h"
+#include <QPainter>
+#include <QPair>
+#include <QHash>
+#include <QtConcurrent/QtConcurrentMap>
+
+namespace {
+    // RasterJob is the work of one worker: the tile it owns and the indexes of the batch segments that touch this tile
+    struct RasterJob {
+        QPoint tile;
+        QPoint origin;
+        QImage * image;
+        QVector<int> segments;
+    };
+}
+
+MandalaRasterizer::MandalaRasterizer() {
+}
+
+void MandalaRasterizer::setAntialiasing(bool antialiasing) {
+    _antialiasing = antialiasing;
+}
+
+void MandalaRasterizer::setParallelThreshold(int parallelThreshold) {
+    _parallelThreshold = parallelThreshold;
+}
+
+QRectF MandalaRasterizer::segmentBounds(const QLineF & line, qreal penWidth) {
+    // The margin covers the round caps and the antialiasing
+    qreal margin = penWidth/2 + 1;
+    return QRectF(line.p1(), line.p2()).normalized().adjusted(-margin, -margin, margin, margin);
+}
+
+QRectF MandalaRasterizer::segmentsBounds(const QVector<MandalaSegment> & segments, qreal penWidth) {
+    QRectF bounds;
+    for(auto iter = segments.begin(); iter != segments.end(); ++iter)
+        bounds |= segmentBounds(iter->line, penWidth);
+    return bounds;
+}
+
+QRectF MandalaRasterizer::rasterize(TiledRaster & raster, const QVector<MandalaSegment> & segments, qreal penWidth) const {
+    QRectF dirty;
+    QVector<RasterJob> jobs;
+    QHash<QPair<int, int>, int> jobIndexes;
+
+    // Fan out the batch to the tiles touched by the segments
+    for(int i=0; i<segments.size(); ++i) {
+        QRectF bounds = segmentBounds(segments[i].line, penWidth);
+        dirty |= bounds;
+
+        QRect range = TiledRaster::tileRange(bounds);
+        for(int y=range.top(); y<=range.bottom(); ++y) {
+            for(int x=range.left(); x<=range.right(); ++x) {
+                QHash<QPair<int, int>, int>::iterator iter = jobIndexes.find(qMakePair(x, y));
+                if(iter == jobIndexes.end()) {
+                    RasterJob job;
+                    job.tile = QPoint(x, y);
+                    job.origin = TiledRaster::tileRect(job.tile).topLeft();
+                    job.image = nullptr;
+                    iter = jobIndexes.insert(qMakePair(x, y), jobs.size());
+                    jobs.push_back(job);
+                }
+                jobs[iter.value()].segments.push_back(i);
+            }
+        }
+    }
+
+    // The tiles are allocated here, on the calling thread, because the raster tiles hash isn't thread safe:
+    // we first create all of them, and only then we take their addresses
+    for(auto iter = jobs.begin(); iter != jobs.end(); ++iter)
+        raster.tile(iter->tile);
+    for(auto iter = jobs.begin(); iter != jobs.end(); ++iter)
+        iter->image = &raster.tile(iter->tile);
+
+    bool antialiasing = _antialiasing;
+    auto paintTile = [&segments, penWidth, antialiasing](RasterJob & job) {
+        QPainter painter(job.image);
+        painter.setRenderHint(QPainter::Antialiasing, antialiasing);
+        painter.translate(-job.origin);
+
+        // We only change the pen when the color changes (rainbow mode)
+        QRgb penColor = segments[job.segments.first()].color;
+        QPen pen(QBrush(QColor::fromRgba(penColor)), penWidth, Qt::SolidLine, Qt::RoundCap);
+        painter.setPen(pen);
+        for(int index : job.segments) {
+            const MandalaSegment & segment = segments[index];
+            if(segment.color != penColor) {
+                penColor = segment.color;
+                pen.setColor(QColor::fromRgba(penColor));
+                painter.setPen(pen);
+            }
+            painter.drawLine(segment.line);
+        }
+    };
+
+    if(jobs.size() < _parallelThreshold) {
+        for(auto iter = jobs.begin(); iter != jobs.end(); ++iter)
+            paintTile(*iter);
+    } else {
+        QtConcurrent::blockingMap(jobs, paintTile);
+    }
+
+    return dirty;
+}
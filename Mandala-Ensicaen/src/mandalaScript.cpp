@@ -0,0 +1,373 @@
+/**
+ * @file   mandalaScript.cpp
+ * @date   October 2026
+ *
+ * @brief  mandalaScript reads a command file describing a drawing (strokes, generated patterns) and the view parameters (slices, mirror, pen, colors,
+ * symmetry group), with parameter sweeps: every variation is rendered offscreen with its own symmetry and color engines and exported, in parallel
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "mandalaScript.h"
+#include "mandalaRasterizer.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QTransform>
+#include <QtConcurrent/QtConcurrentMap>
+#include <limits.h>
+#include <math.h>
+
+const int MandalaScript::MaxCanvasSide = 16384;
+
+namespace {
+    const char * PaletteNames[] = { "hsv", "gradient", "cycle", "radial" };
+    const char * ModeNames[] = { "dihedral", "wallpaper", "kaleidoscope" };
+    const char * PatternNames[] = { "random", "rosette", "spirograph", "lsystem" };
+
+    int indexOf(const char * names[], int count, const QString & name) {
+        for(int i=0; i<count; ++i)
+            if(name == QLatin1String(names[i]))
+                return i;
+        return -1;
+    }
+
+    bool parseSwitch(const QString & value, bool & result) {
+        if(value == "on" || value == "true" || value == "1")
+            result = true;
+        else if(value == "off" || value == "false" || value == "0")
+            result = false;
+        else
+            return false;
+        return true;
+    }
+}
+
+MandalaScript::MandalaScript() {
+}
+
+bool MandalaScript::load(const QString & fileName) {
+    QFileInfo info(fileName);
+    if(_loading.contains(info.absoluteFilePath())) {
+        _error = QString("%1 loads itself").arg(fileName);
+        return false;
+    }
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        _error = QString("Can't read %1").arg(fileName);
+        return false;
+    }
+
+    _loading << info.absoluteFilePath();
+    bool loaded = parse(QTextStream(&file).readAll(), info.absolutePath());
+    _loading.removeLast();
+    if(!loaded)
+        _error = QString("%1: %2").arg(info.fileName()).arg(_error);
+    return loaded;
+}
+
+bool MandalaScript::parse(const QString & text, const QString & directory) {
+    QStringList lines = text.split('\n');
+    for(int i=0; i<lines.size(); ++i) {
+        QString line = lines[i].trimmed();
+        if(line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        QStringList words = line.split(QRegularExpression("\\s+"));
+        QString command = words.takeFirst().toLower();
+        QString error;
+
+        if(command == "stroke") {
+            // A stroke is a polyline: x,y x,y ...
+            QPolygonF stroke;
+            for(auto iter = words.begin(); iter != words.end() && error.isEmpty(); ++iter) {
+                QStringList coordinates = iter->split(',');
+                bool xOk = false, yOk = false;
+                if(coordinates.size() == 2)
+                    stroke << QPointF(coordinates[0].toDouble(&xOk), coordinates[1].toDouble(&yOk));
+                if(!xOk || !yOk)
+                    error = QString("bad point %1").arg(*iter);
+            }
+            if(error.isEmpty() && stroke.size() < 2)
+                error = "a stroke needs two points at least";
+            if(error.isEmpty())
+                _base.strokes << stroke;
+        } else if(command == "generate") {
+            // generate <pattern> [seed] [segments] [radius]
+            GeneratorSettings settings;
+            int pattern = words.isEmpty() ? -1 : indexOf(PatternNames, 4, words[0]);
+            bool ok = true;
+            if(pattern < 0)
+                error = "generate needs a pattern: random, rosette, spirograph or lsystem";
+            else
+                settings.pattern = GeneratorSettings::Pattern(pattern);
+            if(error.isEmpty() && words.size() > 1)
+                settings.seed = words[1].toULongLong(&ok);
+            if(ok && words.size() > 2)
+                settings.segments = words[2].toInt(&ok);
+            if(ok && words.size() > 3)
+                settings.radius = words[3].toDouble(&ok);
+            if(error.isEmpty() && !ok)
+                error = "bad generator settings";
+            if(error.isEmpty())
+                _base.generators << settings;
+        } else if(command == "load") {
+            if(words.isEmpty())
+                error = "load needs a file";
+            else if(!load(QDir(directory).absoluteFilePath(words.join(' '))))
+                error = _error;
+        } else if(command == "sweep") {
+            if(words.size() < 2) {
+                error = "sweep needs a parameter and its values";
+            } else {
+                Sweep sweep = {words.takeFirst().toLower(), words};
+                // Every value is checked now: the rendering never fails on a bad value
+                for(auto iter = sweep.values.begin(); iter != sweep.values.end() && error.isEmpty(); ++iter) {
+                    ScriptVariation check = _base;
+                    error = setParameter(check, sweep.parameter, QStringList() << *iter);
+                }
+                if(error.isEmpty())
+                    _sweeps << sweep;
+            }
+        } else if(command == "export") {
+            if(words.isEmpty())
+                error = "export needs a file name";
+            else
+                _output = QDir(directory).absoluteFilePath(words.join(' '));
+        } else {
+            error = setParameter(_base, command, words);
+        }
+
+        if(!error.isEmpty()) {
+            _error = QString("line %1: %2").arg(i + 1).arg(error);
+            return false;
+        }
+    }
+    return true;
+}
+
+QString MandalaScript::errorString() const {
+    return _error;
+}
+
+QString MandalaScript::setParameter(ScriptVariation & variation, const QString & name, const QStringList & values) {
+    bool ok = !values.isEmpty();
+    QString value = values.value(0).toLower();
+
+    if(name == "canvas") {
+        int width = value.toInt(&ok);
+        bool heightOk = true;
+        int height = (values.size() > 1) ? values[1].toInt(&heightOk) : width;
+        if(!ok || !heightOk || width < 1 || height < 1 || width > MaxCanvasSide || height > MaxCanvasSide)
+            return "canvas needs a width and a height";
+        variation.canvasSize = QSize(width, height);
+    } else if(name == "slices") {
+        int slices = value.toInt(&ok);
+        if(!ok || slices < 0 || slices > 360)
+            return "slices needs a number between 0 and 360";
+        variation.slices = slices;
+    } else if(name == "pen") {
+        int penSize = value.toInt(&ok);
+        if(!ok || penSize < 1 || penSize > 200)
+            return "pen needs a width between 1 and 200";
+        variation.penSize = penSize;
+    } else if(name == "color") {
+        QColor color(value);
+        if(!color.isValid())
+            return QString("bad color %1").arg(values.value(0));
+        variation.color = color;
+    } else if(name == "rainbow") {
+        if(!ok || !parseSwitch(value, variation.rainbow))
+            return "rainbow needs on or off";
+    } else if(name == "antialiasing") {
+        if(!ok || !parseSwitch(value, variation.antialiasing))
+            return "antialiasing needs on or off";
+    } else if(name == "mirror") {
+        // mirror on|off [axis angle]
+        if(!ok || !parseSwitch(value, variation.mirror))
+            return "mirror needs on or off";
+        if(values.size() > 1) {
+            variation.symmetry.mirrorAngle = values[1].toDouble(&ok);
+            if(!ok)
+                return "bad mirror angle";
+        }
+    } else if(name == "palette") {
+        int palette = indexOf(PaletteNames, 4, value);
+        if(palette < 0)
+            return "palette needs hsv, gradient, cycle or radial";
+        variation.palette = ColorEngine::Palette(palette);
+    } else if(name == "symmetry") {
+        // symmetry dihedral | wallpaper [group] [cell size] | kaleidoscope [centers] [radius]
+        int mode = indexOf(ModeNames, 3, value);
+        if(mode < 0)
+            return "symmetry needs dihedral, wallpaper or kaleidoscope";
+        variation.symmetry.mode = SymmetrySettings::Mode(mode);
+        if(mode == SymmetrySettings::Wallpaper) {
+            if(values.size() > 1) {
+                QString error = setParameter(variation, "group", values.mid(1, 1));
+                if(!error.isEmpty())
+                    return error;
+            }
+            if(values.size() > 2)
+                return setParameter(variation, "cell", values.mid(2, 1));
+        } else if(mode == SymmetrySettings::Kaleidoscope) {
+            bool centersOk = true, radiusOk = true;
+            if(values.size() > 1)
+                variation.symmetry.kaleidoscopeCenters = values[1].toInt(&centersOk);
+            if(values.size() > 2)
+                variation.symmetry.kaleidoscopeRadius = values[2].toDouble(&radiusOk);
+            if(!centersOk || !radiusOk || variation.symmetry.kaleidoscopeCenters < 1)
+                return "bad kaleidoscope settings";
+        }
+    } else if(name == "group") {
+        for(int group=SymmetrySettings::P1; group<=SymmetrySettings::P6M; ++group) {
+            if(SymmetryEngine::wallpaperGroupName(SymmetrySettings::WallpaperGroup(group)) == value) {
+                variation.symmetry.wallpaperGroup = SymmetrySettings::WallpaperGroup(group);
+                return QString();
+            }
+        }
+        return QString("unknown wallpaper group %1").arg(values.value(0));
+    } else if(name == "cell") {
+        double cellSize = value.toDouble(&ok);
+        if(!ok || cellSize < 4)
+            return "cell needs a size of 4 pixels at least";
+        variation.symmetry.cellSize = cellSize;
+    } else {
+        return QString("unknown command %1").arg(name);
+    }
+    return QString();
+}
+
+QVector<ScriptVariation> MandalaScript::variations() const {
+    QVector<ScriptVariation> variations;
+    variations << _base;
+    for(auto sweep = _sweeps.begin(); sweep != _sweeps.end(); ++sweep) {
+        QVector<ScriptVariation> swept;
+        for(auto iter = variations.begin(); iter != variations.end(); ++iter) {
+            for(auto value = sweep->values.begin(); value != sweep->values.end(); ++value) {
+                ScriptVariation variation = *iter;
+                setParameter(variation, sweep->parameter, QStringList() << *value);
+                swept << variation;
+            }
+        }
+        variations = swept;
+    }
+
+    QString output = _output.isEmpty() ? QDir::current().absoluteFilePath("mandala.png") : _output;
+    for(int i=0; i<variations.size(); ++i) {
+        variations[i].index = i;
+        variations[i].output = outputName(output, variations[i], variations.size());
+    }
+    return variations;
+}
+
+QString MandalaScript::outputName(const QString & pattern, const ScriptVariation & variation, int count) {
+    QString name = pattern;
+    // Without any placeholder, the variations would overwrite each other: they get their index
+    if(count > 1 && !name.contains('{')) {
+        QFileInfo info(name);
+        name = info.path() + "/" + info.completeBaseName() + "_{index}." + (info.suffix().isEmpty() ? QString("png") : info.suffix());
+    }
+    name.replace("{index}", QString::number(variation.index));
+    name.replace("{slices}", QString::number(variation.slices));
+    name.replace("{pen}", QString::number(variation.penSize));
+    name.replace("{color}", variation.color.name().mid(1));
+    name.replace("{rainbow}", variation.rainbow ? "rainbow" : "plain");
+    name.replace("{mirror}", variation.mirror ? "mirror" : "nomirror");
+    name.replace("{palette}", QLatin1String(PaletteNames[variation.palette]));
+    name.replace("{group}", SymmetryEngine::wallpaperGroupName(variation.symmetry.wallpaperGroup));
+    name.replace("{cell}", QString::number(variation.symmetry.cellSize));
+    return name;
+}
+
+QImage MandalaScript::render(const ScriptVariation & variation) {
+    ScriptBuffers buffers;
+    return render(variation, buffers, variation.canvasSize);
+}
+
+QImage MandalaScript::render(const ScriptVariation & variation, ScriptBuffers & buffers, QSize size) {
+    // The same engines as the painting widget, set like MyQGraphicsView does for its canvas
+    QSize canvas = variation.canvasSize;
+    QPointF center(canvas.width()/2, canvas.height()/2);
+    SymmetryEngine symmetry;
+    symmetry.setSettings(variation.symmetry);
+    symmetry.setCenter(center);
+    symmetry.setSlices(variation.slices);
+    symmetry.setMirror(variation.mirror);
+    symmetry.setVisibleArea(QRectF(QPointF(0, 0), canvas), variation.penSize / 2.0);
+
+    ColorEngine colors;
+    colors.setPalette(variation.palette);
+    colors.setBaseColor(variation.color);
+    colors.setCopyCount(symmetry.colorCount());
+    colors.setRadius(sqrt(pow(canvas.width()/2, 2) + pow(canvas.height()/2, 2)));
+    const ColorEngine * rainbow = variation.rainbow ? &colors : nullptr;
+
+    QVector<MandalaSegment> & segments = buffers.segments;
+    segments.resize(0);
+    for(auto stroke = variation.strokes.begin(); stroke != variation.strokes.end(); ++stroke) {
+        colors.nextStroke();
+        for(int i=1; i<stroke->size(); ++i)
+            symmetry.apply(QLineF(stroke->at(i-1), stroke->at(i)), variation.color.rgba(), rainbow, segments);
+    }
+    for(auto generator = variation.generators.begin(); generator != variation.generators.end(); ++generator) {
+        colors.nextStroke();
+        QVector<QLineF> lines = MandalaGenerator::generate(*generator, center, variation.slices);
+        for(auto iter = lines.begin(); iter != lines.end(); ++iter)
+            symmetry.apply(*iter, variation.color.rgba(), rainbow, segments);
+    }
+
+    // The copies are mapped to the pixels of the image with their pen width, instead of scaling the image of the canvas
+    qreal sx = qreal(size.width()) / canvas.width();
+    qreal sy = qreal(size.height()) / canvas.height();
+    if(size != canvas) {
+        QTransform transform = QTransform::fromScale(sx, sy);
+        for(int i=0; i<segments.size(); ++i)
+            segments[i].line = transform.map(segments[i].line);
+    }
+
+    // The variations already keep all the cores busy: each one is rasterized on its own thread
+    buffers.raster.eraseTiles();
+    MandalaRasterizer rasterizer;
+    rasterizer.setAntialiasing(variation.antialiasing);
+    rasterizer.setParallelThreshold(INT_MAX);
+    rasterizer.rasterize(buffers.raster, segments, variation.penSize * (sx + sy) / 2);
+
+    if(buffers.image.size() != size)
+        buffers.image = QImage(size, QImage::Format_RGB32);
+    buffers.image.fill(Qt::white);
+    QPainter painter(&buffers.image);
+    buffers.raster.paint(&painter, QRectF(buffers.image.rect()));
+    return buffers.image;
+}
+
+QString ScriptReport::toString() const {
+    if(!error.isEmpty())
+        return QString("variation %1: %2").arg(index).arg(error);
+    return QString("variation %1: %2").arg(index).arg(output);
+}
+
+ScriptReport MandalaScript::renderAndExport(const ScriptVariation & variation) {
+    ScriptReport report;
+    report.index = variation.index;
+    report.output = variation.output;
+    QImage image = render(variation);
+    QDir().mkpath(QFileInfo(variation.output).path());
+    if(!image.save(variation.output))
+        report.error = QString("can't write %1").arg(variation.output);
+    return report;
+}
+
+QStringList MandalaScript::run() const {
+    QVector<ScriptReport> reports = QtConcurrent::blockingMapped<QVector<ScriptReport>>(variations(), &MandalaScript::renderAndExport);
+    QStringList lines;
+    for(auto iter = reports.begin(); iter != reports.end(); ++iter)
+        lines << iter->toString();
+    return lines;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file   memoryBudget.cpp
+ * @date   October 2026
+ *
+ * @brief  memoryBudget is the central memory manager of the application: the scene items, the undo/redo history, the layer rasters and the caches
+ * report the bytes they use, and when the user ceiling is reached the manager asks them to release memory in priority order
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "memoryBudget.h"
+
+const qint64 MemoryBudget::DefaultCeiling = qint64(1024) * 1024 * 1024;
+
+MemoryBudget * MemoryBudget::instance() {
+    static MemoryBudget * budget = new MemoryBudget();
+    return budget;
+}
+
+MemoryBudget::MemoryBudget(QObject *parent) : QObject(parent), _ceiling(DefaultCeiling) {
+    _enforceTimer.setSingleShot(true);
+    connect(&_enforceTimer, SIGNAL(timeout()), this, SLOT(enforce()));
+}
+
+int MemoryBudget::addConsumer(const QString & name, Category category, const std::function<qint64()> & usage, const std::function<qint64(qint64)> & release) {
+    _consumers.push_back({_nextId, name, category, usage, release});
+    return _nextId++;
+}
+
+void MemoryBudget::removeConsumer(int id) {
+    for(int i=0; i<_consumers.size(); ++i) {
+        if(_consumers[i].id == id) {
+            _consumers.remove(i);
+            return;
+        }
+    }
+}
+
+void MemoryBudget::setCeiling(qint64 ceiling) {
+    _ceiling = qMax(qint64(0), ceiling);
+    enforce();
+}
+
+qint64 MemoryBudget::ceiling() const {
+    return _ceiling;
+}
+
+QVector<MemoryUsage> MemoryBudget::usages() const {
+    QVector<MemoryUsage> result;
+    for(auto iter = _consumers.begin(); iter != _consumers.end(); ++iter)
+        result.push_back({iter->name, iter->category, iter->usage()});
+    return result;
+}
+
+qint64 MemoryBudget::usedBytes() const {
+    qint64 bytes = 0;
+    for(auto iter = _consumers.begin(); iter != _consumers.end(); ++iter)
+        bytes += iter->usage();
+    return bytes;
+}
+
+qint64 MemoryBudget::usedBytes(Category category) const {
+    qint64 bytes = 0;
+    for(auto iter = _consumers.begin(); iter != _consumers.end(); ++iter)
+        if(iter->category == category)
+            bytes += iter->usage();
+    return bytes;
+}
+
+void MemoryBudget::requestEnforce() {
+    if(!_enforceTimer.isActive())
+        _enforceTimer.start(0);
+}
+
+qint64 MemoryBudget::enforce() {
+    _enforceTimer.stop();
+    qint64 used = usedBytes();
+    qint64 released = 0;
+
+    // The consumers release memory category after category: we stop as soon as we are under the ceiling
+    for(int category=Caches; category<=Rasters && _ceiling > 0 && used > _ceiling; ++category) {
+        for(auto iter = _consumers.begin(); iter != _consumers.end() && used > _ceiling; ++iter) {
+            if(iter->category != category || !iter->release)
+                continue;
+            qint64 bytes = iter->release(used - _ceiling);
+            released += bytes;
+            used -= bytes;
+        }
+    }
+
+    emit usageChanged(used, _ceiling);
+    return released;
+}
@@ -11,26 +11,95 @@
  */
 
 #include "myQGraphicsView.h"
+#include "memoryBudget.h"
 #include <QDebug>
+#include <QGraphicsLineItem>
+#include <QHash>
+#include <QPainter>
+#include <QScrollBar>
+#include <QStyleOptionGraphicsItem>
+#include <QWheelEvent>
 #include <math.h>
-#include <tuple>
 #include <functional>
 
+const double MyQGraphicsView::MinimumZoom = 0.1;
+const double MyQGraphicsView::MaximumZoom = 64.0;
+const int MyQGraphicsView::SceneExtent = 1 << 20;
+const qint64 MyQGraphicsView::ItemBytes = 256;
+const int MyQGraphicsView::ReprojectionSettle = 250;
+const int MyQGraphicsView::DetailSettle = 150;
+
 MyQGraphicsView::MyQGraphicsView(QWidget *parent) : QGraphicsView(parent) {
     _scene = new QGraphicsScene();
-    _scene->setSceneRect(0,0,width(),height());
+    // The canvas is unbounded: we can pan and draw anywhere, only the canvas rectangle is composited and saved
+    _scene->setSceneRect(-SceneExtent, -SceneExtent, 2*SceneExtent, 2*SceneExtent);
     setScene(_scene);
+
+    _layers.addStrokeLayer(tr("Layer 1"));
+    _layers.setScale(devicePixelRatio());
+    setCanvasSize(size());
+    _inputClock.start();
+    _draftTimer.setSingleShot(true);
+    _draftTimer.setInterval(0);
+    _reprojectionTimer.setSingleShot(true);
+    _reprojectionTimer.setInterval(ReprojectionSettle);
+    connect(&_draftTimer, SIGNAL(timeout()), this, SLOT(reprojectDraft()));
+    connect(&_reprojectionTimer, SIGNAL(timeout()), this, SLOT(reprojectFinal()));
+    _detailTimer.setSingleShot(true);
+    _detailTimer.setInterval(DetailSettle);
+    connect(&_detailTimer, SIGNAL(timeout()), this, SLOT(renderDetail()));
+    connect(&_journal, SIGNAL(failed(QString)), this, SIGNAL(journalFailed(QString)));
+    // With the ItemBackend, the drawn lines are QGraphicsScene items: they are composited by rendering the scene
+    _layers.setItemsRenderer([this](QPainter * painter, const QRectF & rect) {
+        _scene->render(painter, rect, rect);
+    });
+
+    MemoryBudget * budget = MemoryBudget::instance();
+    _memoryConsumers << budget->addConsumer(tr("Scene items"), MemoryBudget::SceneItems,
+                                            [this]() { return _scene->items().size() * ItemBytes; },
+                                            [this](qint64) { return flattenItems(); });
+    _memoryConsumers << budget->addConsumer(tr("Undo history"), MemoryBudget::History,
+                                            [this]() { return historyBytes(); },
+                                            [this](qint64 bytes) { return releaseHistory(bytes); });
+    _memoryConsumers << budget->addConsumer(tr("Stroke document"), MemoryBudget::History,
+                                            [this]() { return _document.byteCount(); }, nullptr);
+    _memoryConsumers << budget->addConsumer(tr("Export buffer"), MemoryBudget::Caches,
+                                            [this]() { return qint64(_exportBuffer.byteCount()); },
+                                            [this](qint64) {
+                                                qint64 bytes = _exportBuffer.byteCount();
+                                                _exportBuffer = QImage();
+                                                return bytes;
+                                            });
+    _memoryConsumers << budget->addConsumer(tr("Layers"), MemoryBudget::Rasters,
+                                            [this]() { return _layers.byteCount(); }, nullptr);
+    _memoryConsumers << budget->addConsumer(tr("Zoom detail"), MemoryBudget::Caches,
+                                            [this]() { return _detailRaster.byteCount(); },
+                                            [this](qint64) {
+                                                qint64 bytes = _detailRaster.byteCount();
+                                                _detailRaster.clear();
+                                                _detailRevision = 0;
+                                                return bytes;
+                                            });
 }
 
 MyQGraphicsView::~MyQGraphicsView() {
+    for(auto iter = _memoryConsumers.begin(); iter != _memoryConsumers.end(); ++iter)
+        MemoryBudget::instance()->removeConsumer(*iter);
     delete _scene;
-    _slicesAddedHistory.clear();
-    _mirrorLinesHistory.clear();
     _undoHistoryStack.clear();
     _redoHistoryStack.clear();
     qDebug() << "Deleted View's Objects!";
 }
 
+qint64 HibernatedDocument::byteCount() const {
+    qint64 bytes = content.byteCount() + content.document().byteCount();
+    for(auto iter = undoHistory.begin(); iter != undoHistory.end(); ++iter)
+        bytes += iter->byteCount();
+    for(auto iter = redoHistory.begin(); iter != redoHistory.end(); ++iter)
+        bytes += iter->byteCount();
+    return bytes;
+}
+
 // Setters:
 void MyQGraphicsView::setPenSize(int penSize) {
     _penSize = penSize;
@@ -38,6 +107,7 @@ void MyQGraphicsView::setPenSize(int penSize) {
 
 void MyQGraphicsView::setPenColor(QColor penColor) {
     _penColor = penColor;
+    _colorEngine.setBaseColor(penColor);
 }
 
 void MyQGraphicsView::setBrightness(int brightness) {
@@ -46,210 +116,575 @@ void MyQGraphicsView::setBrightness(int brightness) {
 }
 
 void MyQGraphicsView::setRainbowMode(bool hsvColorToggled) {
-    _hsvColorToggled = hsvColorToggled;
+    if(hsvColorToggled != _hsvColorToggled) {
+        _hsvColorToggled = hsvColorToggled;
+        requestReprojection();
+    }
 }
 
 void MyQGraphicsView::setGridButtonEnabled(bool gridButtonEnabled) {
     _gridButtonEnabled = gridButtonEnabled;
-    // Delete all the slices, and after if the grid button is enabled we redraw them
-    removeAllDrawnSlices();
-    if(_gridButtonEnabled) {
-        setAndDrawSlices(_slices);
-    }
+    updateGuides();
 }
 
 void MyQGraphicsView::setMirrorButtonEnabled(bool mirrorButtonEnabled) {
+    bool changed = mirrorButtonEnabled != _mirrorButtonEnabled;
     _mirrorButtonEnabled = mirrorButtonEnabled;
-    // Delete all the mirror lines, and after if the mirror button is enabled we redraw them
-    removeAllDrawnMirrorLines();
-    if(_mirrorButtonEnabled) {
-        setMirrorLines();
-    }
+    _symmetry.setMirror(mirrorButtonEnabled);
+    updateGuides();
+    if(changed)
+        requestReprojection();
 }
 
-void MyQGraphicsView::setMirrorLines() {
-    if(_slices != 0) {
-        _mirrorLinesHistory.clear();  // free the vector
+void MyQGraphicsView::setAndDrawSlices(int slices) {
+    // Going to single mode (0 slices) and back keeps the drawing as it is: only a new slice count projects it again.
+    // The edited stroke is committed while its copies can still be projected
+    if(slices == 0)
+        commitSelection();
+    bool changed = slices != _slices && slices > 0 && _slices > 0;
+    _slices = slices;
+    _symmetry.setSlices(slices);
+    _colorEngine.setCopyCount(_symmetry.colorCount());
+    updateGuides();
+    if(changed)
+        requestReprojection();
+}
 
-        QPen pen(QColor(0, 0, 0, 80), 1, Qt::SolidLine);
+void MyQGraphicsView::updateDeviceScale() {
+    // A window moved to a screen of another resolution is painted again: the layers follow it before they are painted
+    qreal scale = devicePixelRatio();
+    if(scale == _layers.scale())
+        return;
+    _layers.setScale(scale);
+    _layers.markItemsDirty(_layers.canvasRect());
+    updateGuides();
+    emit deviceScaleChanged();
+}
 
+void MyQGraphicsView::updateGuides() {
+    // The guides overlay is only redrawn when it is painted (see drawForeground())
+    _layers.guides().markDirty(_layers.canvasRect());
+    _scene->invalidate(QRectF(), QGraphicsScene::ForegroundLayer);
+}
+
+void MyQGraphicsView::paintGuides(QPainter * painter) {
+    if(_slices == 0)
+        return;
+
+    // The guides go from the symmetry center to the canvas corners
+    QSize canvas = _layers.canvasRect().size();
+    double length = sqrt(pow(canvas.width()/2, 2) + pow(canvas.height()/2, 2));
+
+    if(_gridButtonEnabled) {
+        painter->setPen(QPen(QColor(0, 0, 0, _brightness), 3, Qt::DashLine));
         for(int i=1; i<_slices+1; ++i) {
             QLineF angleline;
             /* Set the origin: */
-            angleline.setP1(QPointF(width()/2, height()/2));
-            angleline.setLength(sqrt(pow(width()/2, 2) + pow(height()/2, 2)));
-            angleline.setAngle(i*360/_slices + 180/_slices);
+            angleline.setP1(_symmetryCenter);
 
-            QGraphicsLineItem * angleLineItem = _scene->addLine(angleline, pen);
-            _mirrorLinesHistory.push_back(angleLineItem);
+            angleline.setLength(length);
+            angleline.setAngle(i*360.0/_slices);
+            painter->drawLine(angleline);
+        }
+    }
 
-            _scene->update();
+    if(_mirrorButtonEnabled) {
+        painter->setPen(QPen(QColor(0, 0, 0, 80), 1, Qt::SolidLine));
+        for(int i=1; i<_slices+1; ++i) {
+            QLineF angleline;
+            /* Set the origin: */
+            angleline.setP1(_symmetryCenter);
+            angleline.setLength(length);
+            angleline.setAngle(i*360/_slices + 180/_slices);
+            painter->drawLine(angleline);
         }
     }
 }
 
-void MyQGraphicsView::setAndDrawSlices(int slices) {
-    _slices = slices;
-    if(_gridButtonEnabled) {
-        if(_slices != 0) {
-            removeAllDrawnSlices();
-            _slicesAddedHistory.clear(); // free the vector
+void MyQGraphicsView::setCanvasSize(QSize canvasSize) {
+    _layers.setCanvasRect(QRect(QPoint(0, 0), canvasSize));
+    // The symmetry center is fixed in scene coordinates: zooming and panning the view never move it
+    _symmetryCenter = QPointF(canvasSize.width()/2, canvasSize.height()/2);
+    _symmetry.setCenter(_symmetryCenter);
+    _colorEngine.setRadius(sqrt(pow(canvasSize.width()/2, 2) + pow(canvasSize.height()/2, 2)));
+    resetZoom();
+    updateGuides();
+}
 
-            QPen pen(QColor(0, 0, 0, _brightness), 3, Qt::DashLine);
-            for(int i=1; i<_slices+1; ++i) {
-                QLineF angleline;
-                /* Set the origin: */
-                angleline.setP1(QPointF(width()/2, height()/2));
+QSize MyQGraphicsView::canvasSize() {
+    return _layers.canvasRect().size();
+}
 
-                angleline.setLength(sqrt(pow(width()/2, 2) + pow(height()/2, 2)));
-                angleline.setAngle(i*360.0/_slices);
+void MyQGraphicsView::resetZoom() {
+    resetTransform();
+    centerOn(_layers.canvasRect().center());
+}
 
-                QGraphicsLineItem * angleLineItem = _scene->addLine(angleline, pen);
-                _slicesAddedHistory.push_back(angleLineItem);
-            }
+void MyQGraphicsView::setPaintEnabled(bool paintEnabled) {
+    _paintEnabled = paintEnabled;
+}
+
+void MyQGraphicsView::setSymmetrySettings(const SymmetrySettings & settings) {
+    _symmetry.setSettings(settings);
+    _colorEngine.setCopyCount(_symmetry.colorCount());
+    requestReprojection();
+}
+
+DocumentSettings MyQGraphicsView::documentSettings() const {
+    DocumentSettings settings;
+    settings.slices = _slices;
+    settings.mirror = _mirrorButtonEnabled;
+    settings.symmetry = _symmetry.settings();
+    settings.palette = _colorEngine.palette();
+    settings.rainbow = _hsvColorToggled;
+    return settings;
+}
+
+QRectF MyQGraphicsView::visibleArea() {
+    // The wallpaper tiles are drawn in what we see, and in the whole canvas so that the saved image is complete
+    return mapToScene(viewport()->rect()).boundingRect() | QRectF(_layers.canvasRect());
+}
+
+qreal MyQGraphicsView::strokeReach() const {
+    int penWidth = _penSize;
+    const QVector<StrokeDocument::DocumentBatch> & batches = _document.batches();
+    for(auto iter = batches.begin(); iter != batches.end(); ++iter)
+        penWidth = qMax(penWidth, iter->penWidth);
+    for(auto iter = _remoteStrokes.begin(); iter != _remoteStrokes.end(); ++iter)
+        penWidth = qMax(penWidth, iter->style.penWidth);
+    return penWidth / 2.0;
+}
+
+void MyQGraphicsView::setColorPalette(ColorEngine::Palette palette) {
+    _colorEngine.setPalette(palette);
+}
+
+void MyQGraphicsView::setGradientStops(const QGradientStops & gradientStops) {
+    _colorEngine.setGradientStops(gradientStops);
+}
+
+QGradientStops MyQGraphicsView::gradientStops() const {
+    return _colorEngine.gradientStops();
+}
+
+void MyQGraphicsView::setRenderBackend(RenderBackend renderBackend) {
+    _renderBackend = renderBackend;
+}
+
+MyQGraphicsView::RenderBackend MyQGraphicsView::renderBackend() const {
+    return _renderBackend;
+}
+
+void MyQGraphicsView::setSymmetryKernelsEnabled(bool kernelsEnabled) {
+    _symmetry.setKernelsEnabled(kernelsEnabled);
+}
+
+void MyQGraphicsView::setLegacySymmetryEnabled(bool legacySymmetry) {
+    _legacySymmetry = legacySymmetry;
+}
+
+int MyQGraphicsView::addStrokeLayer(QString name) {
+    int index = _layers.addStrokeLayer(name);
+    _layers.setCurrentStrokeLayer(index);
+    return index;
+}
+
+void MyQGraphicsView::setCurrentStrokeLayer(int index) {
+    _layers.setCurrentStrokeLayer(index);
+}
+
+int MyQGraphicsView::strokeLayerCount() {
+    return _layers.strokeLayerCount();
+}
+
+QString MyQGraphicsView::strokeLayerName(int index) {
+    return _layers.strokeLayer(index).name();
+}
+
+void MyQGraphicsView::setStrokeLayerVisible(int index, bool visible) {
+    MandalaLayer & layer = _layers.strokeLayer(index);
+    layer.setVisible(visible);
+    layer.markDirty(_layers.canvasRect());
+    // With the ItemBackend, the lines of a layer are the QGraphicsScene items having the layer index as Z value
+    QList<QGraphicsItem *> items = _scene->items();
+    for(auto iter = items.begin(); iter != items.end(); ++iter)
+        if((*iter)->zValue() == index)
+            (*iter)->setVisible(visible);
+    _layers.markItemsDirty(_layers.canvasRect());
+    _scene->invalidate(QRectF(), QGraphicsScene::BackgroundLayer);
+}
+
+const QImage & MyQGraphicsView::contentImage() {
+    return _layers.composite();
+}
+
+const QImage & MyQGraphicsView::exportImage(qreal scale) {
+    QSize size = canvasSize() * scale;
+    if(scale != _layers.scale()) {
+        // The document is rasterized again at the export scale: the layers of the screen are never resampled
+        _exportBuffer = renderArea(QRectF(_layers.canvasRect()), size).convertToFormat(QImage::Format_RGB32);
+        return _exportBuffer;
+    }
+
+    const QImage & composite = _layers.composite();
+    if(_exportBuffer.size() != size)
+        _exportBuffer = QImage(size, QImage::Format_RGB32);
+
+    // The drawing paper of the QGraphicsView is white (see its style sheet), and BMP/JPG can't keep the transparency.
+    // The composite has the same pixels as the buffer: it is copied pixel for pixel
+    QPainter painter(&_exportBuffer);
+    painter.fillRect(_exportBuffer.rect(), Qt::white);
+    painter.drawImage(QRectF(_exportBuffer.rect()), composite);
+    return _exportBuffer;
+}
+
+bool MyQGraphicsView::seamlessTileRect(QRectF & tile) {
+    return _symmetry.seamlessTile(tile);
+}
+
+QImage MyQGraphicsView::renderArea(const QRectF & rect, QSize size) {
+    // The scene rectangle is scaled to the whole image: a tile keeps its period even if its size isn't a whole number of pixels.
+    // The raster has the pixels of the image, so that it is copied pixel for pixel
+    QTransform transform = QTransform::fromScale(size.width() / rect.width(), size.height() / rect.height()).translate(-rect.left(), -rect.top());
+    TiledRaster raster;
+    rasterizeDocument(raster, rect, transform);
+    paintSelection(raster, rect, transform);
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter painter(&image);
+    raster.paint(&painter, QRectF(image.rect()));
+    return image;
+}
+
+QVector<ColorEngine> MyQGraphicsView::strokeColorEngines() const {
+    // The color engines of the strokes are copies of ours (palette and copy count) with their pen color: the strokes of a color share its lookup table
+    QVector<ColorEngine> colors;
+    if(!_hsvColorToggled)
+        return colors;
+    QHash<QRgb, ColorEngine> engines;
+    const QVector<DocumentStroke> & strokes = _document.strokes();
+    colors.reserve(strokes.size());
+    for(auto iter = strokes.begin(); iter != strokes.end(); ++iter) {
+        if(!engines.contains(iter->color)) {
+            ColorEngine engine = _colorEngine;
+            engine.setBaseColor(QColor::fromRgba(iter->color));
+            engines.insert(iter->color, engine);
         }
+        colors.push_back(engines.value(iter->color));
+        colors.last().setStroke(iter->colorStroke);
     }
+    return colors;
+}
 
-    _scene->update();
+void MyQGraphicsView::rasterizeDocument(TiledRaster & raster, const QRectF & area, const QTransform & transform) {
+    QRectF target = transform.mapRect(area);
+    const QImage & base = _document.base();
+    if(!base.isNull() && _layers.background().isVisible()) {
+        QRectF canvas(_layers.canvasRect());
+        raster.render(target & transform.mapRect(canvas), [&transform, &canvas, &base](QPainter * painter) {
+            painter->setRenderHint(QPainter::SmoothPixmapTransform);
+            painter->setTransform(transform, true);
+            painter->drawImage(canvas, base);
+        });
+    }
+
+    // The copies only cover the area and their lines are mapped to the raster with their pen widths: the lines off the target are dropped before
+    // they allocate tiles. The layers are rasterized in their order over each other, which gives the same pixels as their composite
+    const QVector<StrokeDocument::DocumentBatch> & batches = _document.batches();
+    SymmetryEngine symmetry = _symmetry;
+    symmetry.setVisibleArea(area, strokeReach());
+    QVector<ColorEngine> colors = strokeColorEngines();
+    MandalaRasterizer rasterizer;
+    rasterizer.setAntialiasing(renderHints().testFlag(QPainter::Antialiasing));
+    qreal scale = (transform.m11() + transform.m22()) / 2;
+    auto rasterizeSegments = [&](QVector<MandalaSegment> segments, qreal penWidth) {
+        int kept = 0;
+        for(int i=0; i<segments.size(); ++i) {
+            QLineF line = transform.map(segments[i].line);
+            if(MandalaRasterizer::segmentBounds(line, penWidth).intersects(target))
+                segments[kept++] = {line, segments[i].color};
+        }
+        segments.resize(kept);
+        rasterizer.rasterize(raster, segments, penWidth);
+    };
+
+    for(int layer=0; layer<_layers.strokeLayerCount(); ++layer) {
+        if(!_layers.strokeLayer(layer).isVisible())
+            continue;
+        for(int i=0; i<batches.size(); ++i)
+            if(batches[i].layer == layer)
+                rasterizeSegments(_document.project(i, symmetry, colors, _selectedStroke), batches[i].penWidth * scale);
+        // The strokes other clients are drawing aren't in the document yet: their copies are the ones on screen
+        for(auto iter = _remoteStrokes.begin(); iter != _remoteStrokes.end(); ++iter)
+            if(iter->layer == layer)
+                rasterizeSegments(iter->segments, iter->style.penWidth * scale);
+    }
 }
 
-void MyQGraphicsView::setPaintEnabled(bool paintEnabled) {
-    _paintEnabled = paintEnabled;
+void MyQGraphicsView::paintSelection(TiledRaster & raster, const QRectF & area, const QTransform & transform) {
+    // The stroke being edited is left out of the document projection: it is painted over it, with its copies, where it is on screen
+    if(!_selectionItem || !_selectionItem->isVisible() || !_selectionItem->sceneBoundingRect().intersects(area))
+        return;
+    QRectF target = transform.mapRect(_selectionItem->sceneBoundingRect() & area);
+    raster.render(target, [this, &transform](QPainter * painter) {
+        QStyleOptionGraphicsItem option;
+        option.exposedRect = _selectionItem->boundingRect();
+        painter->setRenderHint(QPainter::Antialiasing, renderHints().testFlag(QPainter::Antialiasing));
+        painter->setTransform(transform, true);
+        painter->setTransform(_selectionItem->sceneTransform(), true);
+        _selectionItem->paint(painter, &option, nullptr);
+    });
 }
 
 // Listeners:
-void MyQGraphicsView::mouseMoveEvent(QMouseEvent * e) {
-    if(_paintEnabled) {
-        setMouseTracking(true);
-        _screenshotActivator = _scene->items().size();
+void MyQGraphicsView::drawBackground(QPainter * painter, const QRectF & rect) {
+    QGraphicsView::drawBackground(painter, rect);
+    if(detailIsCurrent()) {
+        // The detail raster is in viewport pixels: it is painted without the view transform, pixel for pixel
+        painter->save();
+        painter->setWorldTransform(QTransform());
+        _detailRaster.paint(painter, viewportTransform().mapRect(rect));
+        painter->restore();
+        return;
+    }
 
-        if(e->buttons() == Qt::LeftButton) {
-            if(_gridButtonEnabled)
-                removeAllDrawnSlices();
-            if(_mirrorButtonEnabled)
-                removeAllDrawnMirrorLines();
-            QPointF pt = mapToScene(e->pos());
+    // The content layers rasters are under all the QGraphicsScene items. Zoomed in, they are magnified until the view settles and the detail is
+    // rasterized again; zoomed out, the detail isn't needed anymore
+    _layers.paintContent(painter, rect);
+    if(transform().m11() > 1)
+        _detailTimer.start();
+    else if(!_detailRaster.isEmpty())
+        _detailRaster.clear();
+}
 
-            if(_drawLineIndicator > 0) {
-                QGraphicsLineItem * item = _scene->addLine(_previousPoint.rx(), _previousPoint.ry(), pt.rx(), pt.ry(), QPen(QBrush(_penColor), _penSize, Qt::SolidLine, Qt::RoundCap));
+bool MyQGraphicsView::detailIsCurrent() const {
+    return transform().m11() > 1 && !_detailRaster.isEmpty() && _detailRevision == _layers.revision()
+           && _detailTransform == viewportTransform() && _detailRaster.scale() == devicePixelRatio();
+}
 
-                if(_slices != 0) {
-                    if(_mirrorButtonEnabled)
-                        mirrorSymetricDrawing(item, _penColor);
-                    QPointF p1(width()/2, height()/2);
+void MyQGraphicsView::renderDetail() {
+    if(transform().m11() <= 1 || detailIsCurrent())
+        return;
+    // The strokes being drawn aren't in the document yet: the detail waits until they are finished
+    if(_drawLineIndicator > 0 || !_remoteStrokes.isEmpty()) {
+        _detailTimer.start();
+        return;
+    }
+
+    // Only what is on screen is rasterized, at the resolution of the screen: the cost follows the viewport, not the zoom
+    _detailRaster.clear();
+    _detailRaster.setScale(devicePixelRatio());
+    _detailTransform = viewportTransform();
+    rasterizeDocument(_detailRaster, mapToScene(viewport()->rect()).boundingRect(), _detailTransform);
+    _detailRevision = _layers.revision();
+    _scene->invalidate(QRectF(), QGraphicsScene::BackgroundLayer);
+}
 
-                    // drawLinesSymmetricallyToSlices(QPointF, QPointF) is a method that helps to draw symetrics lines to slices :
-                    // drawLinesSymmetricallyToSlices(QPointF, QPointF) is a first classic method that use pure complex number transdormations
+void MyQGraphicsView::paintEvent(QPaintEvent * e) {
+    updateDeviceScale();
+    QGraphicsView::paintEvent(e);
+    // The frame showing the last mouse moves is painted
+    if(_pendingInputTime >= 0) {
+        _inputLatency.addSample((_inputClock.nsecsElapsed() - _pendingInputTime) / 1e6);
+        _pendingInputTime = -1;
+    }
+}
 
-                    // drawLinesSymmetricallyToSlices(_previousPoint, pt);
+void MyQGraphicsView::drawForeground(QPainter * painter, const QRectF & rect) {
+    QGraphicsView::drawForeground(painter, rect);
+
+    MandalaLayer & guides = _layers.guides();
+    if(guides.isDirty()) {
+        guides.raster().clear();
+        if(_slices != 0 && (_gridButtonEnabled || _mirrorButtonEnabled))
+            guides.raster().render(_layers.canvasRect(), [this](QPainter * guidesPainter) { paintGuides(guidesPainter); });
+        guides.clearDirty();
+    }
+    guides.raster().paint(painter, rect);
+
+    // The copies of the selected stroke are framed over the content
+    if(_selectionItem) {
+        painter->setPen(QPen(QColor(0, 85, 255, 160), 0, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        QPolygonF source(_selectionItem->sourceBounds());
+        const QVector<StrokeInstance> & instances = _selectionItem->instances();
+        for(auto iter = instances.begin(); iter != instances.end(); ++iter)
+            painter->drawPolygon(iter->transform.map(source));
+    }
+
+    // The predicted stroke tip is drawn over the content, it is never part of a layer
+    for(auto iter = _predictionSegments.begin(); iter != _predictionSegments.end(); ++iter) {
+        painter->setPen(QPen(QBrush(QColor::fromRgba(iter->color)), _penSize, Qt::SolidLine, Qt::RoundCap));
+        painter->drawLine(iter->line);
+    }
+
+    // When the view is zoomed or panned, we show the borders of the canvas (what will be saved)
+    if(!transform().isIdentity() || mapToScene(0, 0) != QPointF(_layers.canvasRect().topLeft())) {
+        painter->setPen(QPen(QColor(0, 85, 255, 120), 0, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(_layers.canvasRect());
+    }
+}
 
-                    //  drawLinesSymmetricallyToSlices(QGraphicsLineItem *) is the second method to do the same thing: it's an overloaded method that uses QTransform
-                    drawLinesSymmetricallyToSlices(item);
+void MyQGraphicsView::wheelEvent(QWheelEvent * e) {
+    // Zoom around the point under the mouse
+    double factor = pow(1.0015, e->angleDelta().y());
+    double zoom = transform().m11() * factor;
+    if(zoom < MinimumZoom)
+        factor = MinimumZoom / transform().m11();
+    else if(zoom > MaximumZoom)
+        factor = MaximumZoom / transform().m11();
+
+    setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    scale(factor, factor);
+    e->accept();
+}
+
+void MyQGraphicsView::mousePressEvent(QMouseEvent * e) {
+    if(e->button() == Qt::MiddleButton) {
+        // The middle button drags the view (pan)
+        _panOrigin = e->pos();
+        e->accept();
+        return;
+    }
+    if(_selectionEnabled) {
+        if(e->button() == Qt::LeftButton && _paintEnabled) {
+            QPointF point = mapToScene(e->pos());
+            QTransform copy;
+            bool grabbed = false;
+            if(_selectionItem) {
+                // Any copy of the selected stroke grabs it: the point is brought back to the moved lines through the copy
+                qreal tolerance = 4 / transform().m11();
+                QRectF source = _selectionItem->sourceBounds().adjusted(-tolerance, -tolerance, tolerance, tolerance);
+                const QVector<StrokeInstance> & instances = _selectionItem->instances();
+                for(auto iter = instances.begin(); iter != instances.end() && !grabbed; ++iter) {
+                    if(source.contains(iter->transform.inverted().map(point))) {
+                        copy = iter->transform;
+                        grabbed = true;
+                    }
                 }
             }
-            _previousPoint = pt;
-            _drawLineIndicator++;
-
-            if(_gridButtonEnabled)
-                setAndDrawSlices(_slices);
-            if(_mirrorButtonEnabled)
-                setMirrorLines();
+            if(!grabbed) {
+                commitSelection();
+                int stroke = pickStroke(point, copy);
+                if(stroke >= 0)
+                    selectStroke(stroke);
+            }
+            if(_selectionItem) {
+                _editCopy = copy;
+                _editOrigin = point;
+                _editStart = _selectionItem->editTransform();
+                _editCenter = _selectionItem->sourceBounds().center();
+                _editModifiers = e->modifiers();
+            }
         }
-        _screenshotActivator = _scene->items().size() - _screenshotActivator;
+        e->accept();
+        return;
+    }
+    if(e->button() == Qt::LeftButton)
+        _colorEngine.nextStroke();
+    QGraphicsView::mousePressEvent(e);
+}
 
-        _scene->update();
+void MyQGraphicsView::mouseMoveEvent(QMouseEvent * e) {
+    if(e->buttons() & Qt::MiddleButton) {
+        QPoint delta = e->pos() - _panOrigin;
+        _panOrigin = e->pos();
+        horizontalScrollBar()->setValue(horizontalScrollBar()->value() - delta.x());
+        verticalScrollBar()->setValue(verticalScrollBar()->value() - delta.y());
+        return;
+    }
+    if(_selectionEnabled) {
+        if(_selectionItem && e->buttons() == Qt::LeftButton)
+            editSelection(mapToScene(e->pos()));
+        return;
+    }
+
+    // Without mouse tracking, a hover only moves the cursor: we get the moves while a button is pressed.
+    // The drawn segments and the predicted tip invalidate their own bounds, the rest of the scene isn't painted again
+    if(_paintEnabled) {
+        if(e->buttons() == Qt::LeftButton) {
+            QPointF pt = mapToScene(e->pos());
+            qint64 now = _inputClock.nsecsElapsed();
+            if(_pendingInputTime < 0)
+                _pendingInputTime = now;
+
+            // The mouse positions go through the stabilizer before the symmetry fan-out: the jitter isn't copied around the mandala
+            if(_drawLineIndicator > 0) {
+                drawStrokePoints(_stabilizer.addPoint(pt, now / 1e6));
+                updatePrediction();
+            } else {
+                _stabilizer.begin(pt, now / 1e6);
+                _previousPoint = pt;
+                emit strokeStarted({_layers.currentStrokeLayerIndex(), _penSize, _penColor.rgba(), _colorEngine.stroke(), _slices > 0}, pt);
+            }
+            _drawLineIndicator++;
+        }
     }
 }
 
 void MyQGraphicsView::mouseReleaseEvent(QMouseEvent *) {
+    // The selected stroke stays selected after a drag: it is committed when another stroke is picked or the tool is left
+    if(_selectionEnabled)
+        return;
+
+    // The filtered stroke is finished up to the mouse position, and the predicted tip is replaced by it
+    if(_drawLineIndicator > 0) {
+        drawStrokePoints(_stabilizer.end());
+        emit strokeFinished();
+    }
+    clearPrediction();
     _drawLineIndicator = 0;
     if(_screenshotActivator > 0) {
-        removeAllDrawnSlices();
-        removeAllDrawnMirrorLines();
-        // We only screenshot the drawn items without grid slices and mirrors lines!
-        _undoHistoryStack.push(grab(QRect(QPoint(0,0), QSize(width(), height()))));
-        // We redraw grid slices and mirrors lines if their options are activated!
-        if(_gridButtonEnabled)
-            setAndDrawSlices(_slices);
-        if(_mirrorButtonEnabled)
-            setMirrorLines();
+        documentStroke(_strokeLines, _strokeSegments);
+        // The composite only holds the content layers: grid slices and mirror lines are never in the screenshot
+        _undoHistoryStack.push(HistorySnapshot(_layers.composite(), _document));
+        journalStroke(_strokeSegments);
+        MemoryBudget::instance()->requestEnforce();
     }
+    _strokeLines.clear();
+    _strokeSegments.clear();
+    _screenshotActivator = 0;
 }
 
 // Other Useful Methods:
 void MyQGraphicsView::undoLastAction() {
-    if(!_undoHistoryStack.empty()) {
+    // Once the oldest entries are released, the oldest entry left is where the undo stops
+    if(!_undoHistoryStack.empty() && !(_historyTruncated && _undoHistoryStack.size() == 1)) {
         _redoHistoryStack.push(_undoHistoryStack.pop());
-        _scene->clear();
+        clearContent();
         if(!_undoHistoryStack.empty()) {
-            _scene->addPixmap(_undoHistoryStack.top().scaled(size()));
+            restoreScreenShot(_undoHistoryStack.top().image());
         }
+        setDocument(_undoHistoryStack.empty() ? StrokeDocument() : _undoHistoryStack.top().document());
+        journalContent();
     }
 
-    if(_gridButtonEnabled)
-        setAndDrawSlices(_slices);
-    if(_mirrorButtonEnabled)
-        setMirrorLines();
-
     _scene->update();
-
 }
 
 void MyQGraphicsView::redoLastAction() {
     if(!_redoHistoryStack.empty()) {
-        _scene->clear();
-        QPixmap img = _redoHistoryStack.pop();
-        _undoHistoryStack.push(img);
-        _scene->addPixmap(img.scaled(size()));
+        clearContent();
+        HistorySnapshot snapshot = _redoHistoryStack.pop();
+        _undoHistoryStack.push(snapshot);
+        restoreScreenShot(snapshot.image());
+        setDocument(snapshot.document());
+        journalContent();
     }
 
-    if(_gridButtonEnabled)
-        setAndDrawSlices(_slices);
-    if(_mirrorButtonEnabled)
-        setMirrorLines();
-
     _scene->update();
 }
 
 void MyQGraphicsView::clearScene(bool clearScene) {
-    if(clearScene)
-        _scene->clear();
-
-    removeAllDrawnSlices();
-    removeAllDrawnMirrorLines();
-    if(_gridButtonEnabled)
-        setAndDrawSlices(_slices);
-    if(_mirrorButtonEnabled)
-        setMirrorLines();
-}
-
-void MyQGraphicsView::removeAllDrawnSlices() {
-    for (auto iter = _slicesAddedHistory.begin(); iter != _slicesAddedHistory.end(); ++iter) {
-        //  if we don't insert this condition we'll get the warning message:
-        //  QGraphicsScene::removeItem: item 0x20e5cbd0's scene (0x0) is different from this scene (0x20e73000)
-        if(exists(*iter))
-            _scene->removeItem(*iter);
+    if(clearScene) {
+        clearContent();
+        setDocument(StrokeDocument());
+        journalContent();
     }
 }
 
-void MyQGraphicsView::removeAllDrawnMirrorLines() {
-    for (auto iter = _mirrorLinesHistory.begin(); iter != _mirrorLinesHistory.end(); ++iter)
-        if(exists(*iter))
-            _scene->removeItem(*iter);
-}
-
-bool MyQGraphicsView::exists(QGraphicsItem * item) {
-    QList<QGraphicsItem *> items = _scene->items();
-    return (std::find(items.begin(), items.end(), item) != items.end());
-}
-
-std::tuple<int, int, int> MyQGraphicsView::updateHSVColor(QColor hsvColor) {
-    int hue = (hsvColor.hue() + 360/_slices)%360;
-    int satura = hsvColor.saturation();
-    int value = hsvColor.value();
-    return std::make_tuple (hue, satura, value);
-}
-
 QPointF MyQGraphicsView::changeReference(QPointF center, QPointF point, double angleInRadian) {
     double cosOfRotation = cos(angleInRadian);
     double sinOfRotation = sin(angleInRadian);
@@ -257,66 +692,544 @@ QPointF MyQGraphicsView::changeReference(QPointF center, QPointF point, double a
     double xr = point.rx()-center.rx(); // Changement de repére: x relatif
     double yr = point.ry()-center.ry(); // Changement de repére: y relatif
 
-    double x = xr * cosOfRotation - yr * sinOfRotation; // Rotation sur l'axe (Point(width()/2, height()/2), Qt::ZAxes)
-    double y = yr * cosOfRotation + xr * sinOfRotation; // Rotation sur l'axe (Point(width()/2, height()/2), Qt::ZAxes)
+    double x = xr * cosOfRotation - yr * sinOfRotation; // Rotation sur l'axe (_symmetryCenter, Qt::ZAxes)
+    double y = yr * cosOfRotation + xr * sinOfRotation; // Rotation sur l'axe (_symmetryCenter, Qt::ZAxes)
     x += center.rx(); // Retour au repére d'origine du centre Point(0, 0)
     y += center.ry(); // Retour au repére d'origine
     return QPointF(x,y);
 }
 
-void MyQGraphicsView::drawLinesSymmetricallyToSlices(QPointF previousPoint, QPointF currentMousePressPoint) {
-    QColor hsvColor = _penColor.convertTo(QColor::Hsv);
-    QPointF relatifRefCenter(width()/2, height()/2);
+void MyQGraphicsView::drawLinesSymmetricallyToSlices(QPointF previousPoint, QPointF currentMousePressPoint, QVector<MandalaSegment> & segments) {
+    QPointF relatifRefCenter(_symmetryCenter);
+    double distance = QLineF(relatifRefCenter, (previousPoint + currentMousePressPoint) / 2).length();
 
     for(int i=1; i<_slices; ++i) {
         QPointF firstPoint = changeReference(relatifRefCenter, previousPoint, i*2*M_PI/_slices);
         QPointF secondPoint = changeReference(relatifRefCenter, currentMousePressPoint, i*2*M_PI/_slices);
-        QGraphicsLineItem * item;
-        if(_hsvColorToggled) {
-            std::tuple<int, int, int> newHSVColor = updateHSVColor(hsvColor);
-            hsvColor = QColor::fromHsv(std::get<0>(newHSVColor), std::get<1>(newHSVColor), std::get<2>(newHSVColor));
-            item = _scene->addLine(firstPoint.rx(), firstPoint.ry(), secondPoint.rx(), secondPoint.ry(), QPen(QBrush(hsvColor), _penSize, Qt::SolidLine, Qt::RoundCap));
-
-            if(_mirrorButtonEnabled)
-                mirrorSymetricDrawing(item, hsvColor);
-        } else {
-            item = _scene->addLine(firstPoint.rx(), firstPoint.ry(), secondPoint.rx(), secondPoint.ry(), QPen(QBrush(_penColor), _penSize, Qt::SolidLine, Qt::RoundCap));
-
-            if(_mirrorButtonEnabled)
-                mirrorSymetricDrawing(item, _penColor);
+        QRgb color = _hsvColorToggled ? _colorEngine.color(i, distance) : _penColor.rgba();
+        segments.push_back({QLineF(firstPoint, secondPoint), color});
+
+        if(_mirrorButtonEnabled) {
+            // The mirror about the horizontal axis going through the symmetry center
+            QPointF firstMirror(firstPoint.x(), 2*relatifRefCenter.y() - firstPoint.y());
+            QPointF secondMirror(secondPoint.x(), 2*relatifRefCenter.y() - secondPoint.y());
+            segments.push_back({QLineF(firstMirror, secondMirror), color});
         }
     }
 }
 
-void MyQGraphicsView::drawLinesSymmetricallyToSlices(QGraphicsLineItem * item) {
-    QColor hsvColor = _penColor.convertTo(QColor::Hsv);
-    for(int i=1; i<_slices; ++i) {
-        QTransform transform = QTransform().translate(width()/2, height()/2).rotate(i*360/_slices).translate(-width()/2, -height()/2);
-        QLineF item2 = transform.map(item->line());
-        QGraphicsLineItem * item;
-        if(_hsvColorToggled) {
-            std::tuple<int, int, int> newHSVColor = updateHSVColor(hsvColor);
-            hsvColor = QColor::fromHsv(std::get<0>(newHSVColor), std::get<1>(newHSVColor), std::get<2>(newHSVColor));
-            item = _scene->addLine(item2, QPen(QBrush(hsvColor), _penSize, Qt::SolidLine, Qt::RoundCap));
-
-            if(_mirrorButtonEnabled)
-                mirrorSymetricDrawing(item, hsvColor);
-        } else {
-            item = _scene->addLine(item2, QPen(QBrush(_penColor), _penSize, Qt::SolidLine, Qt::RoundCap));
-
-            if(_mirrorButtonEnabled)
-                mirrorSymetricDrawing(item, _penColor);
+void MyQGraphicsView::appendSymmetricalSegments(const QLineF & line, QVector<MandalaSegment> & segments) {
+    // drawLinesSymmetricallyToSlices(QPointF, QPointF, QVector<MandalaSegment> &) is a first classic method that use pure complex number transdormations
+    // (it only knows the rotations of the mandala mode and the horizontal mirror, and leaves the drawn line and its mirror to us)
+    if(_legacySymmetry && _symmetry.settings().mode == SymmetrySettings::Dihedral) {
+        double distance = QLineF(_symmetryCenter, (line.p1() + line.p2()) / 2).length();
+        QRgb color = _hsvColorToggled ? _colorEngine.color(0, distance) : _penColor.rgba();
+        segments.push_back({line, color});
+        if(_mirrorButtonEnabled)
+            segments.push_back({QLineF(line.x1(), 2*_symmetryCenter.y() - line.y1(), line.x2(), 2*_symmetryCenter.y() - line.y2()), color});
+        drawLinesSymmetricallyToSlices(line.p1(), line.p2(), segments);
+        return;
+    }
+
+    // The symmetry engine does the same thing for all the symmetry groups: the line goes through its precomputed list of QTransform
+    _symmetry.apply(line, _penColor.rgba(), _hsvColorToggled ? &_colorEngine : nullptr, segments);
+}
+
+void MyQGraphicsView::drawLines(const QVector<QLineF> & lines) {
+    if(lines.isEmpty())
+        return;
+
+    // The edited stroke is committed first: the new lines go on top of it
+    commitSelection();
+
+    // One batch for all the lines: the rasterizer fans it out once to the tiles instead of drawing line by line
+    _colorEngine.nextStroke();
+    QVector<MandalaSegment> segments;
+    _symmetry.setVisibleArea(visibleArea(), _penSize / 2.0);
+    segments.reserve(lines.size() * _symmetry.copyCount());
+    for(auto iter = lines.begin(); iter != lines.end(); ++iter)
+        appendSymmetricalSegments(*iter, segments);
+
+    drawSegments(segments, _penSize);
+    documentStroke(lines, segments);
+    pushScreenShot();
+    journalStroke(segments);
+    _scene->update();
+}
+
+QVector<QLineF> MyQGraphicsView::generate(const GeneratorSettings & settings) {
+    QVector<QLineF> lines = MandalaGenerator::generate(settings, _symmetryCenter, _slices);
+    drawLines(lines);
+    return lines;
+}
+
+void MyQGraphicsView::drawSegments(const QVector<MandalaSegment> & segments, int penSize, int layerIndex) {
+    if(layerIndex < 0)
+        layerIndex = _layers.currentStrokeLayerIndex();
+    MandalaLayer & layer = _layers.strokeLayer(layerIndex);
+    if(_renderBackend == RasterBackend) {
+        _rasterizer.setAntialiasing(renderHints().testFlag(QPainter::Antialiasing));
+        QRectF dirty = _rasterizer.rasterize(layer.raster(), segments, penSize);
+        layer.markDirty(dirty);
+        _scene->invalidate(dirty, QGraphicsScene::BackgroundLayer);
+    } else {
+        for(auto iter = segments.begin(); iter != segments.end(); ++iter) {
+            QGraphicsLineItem * item = _scene->addLine(iter->line, QPen(QBrush(QColor::fromRgba(iter->color)), penSize, Qt::SolidLine, Qt::RoundCap));
+            item->setZValue(layerIndex);
+            item->setVisible(layer.isVisible());
         }
+        _layers.markItemsDirty(MandalaRasterizer::segmentsBounds(segments, penSize));
     }
 }
 
-void MyQGraphicsView::resizePaintedItems() {
-    _scene->addPixmap(_undoHistoryStack.top().scaled(size()));
+void MyQGraphicsView::drawStrokePoints(const QVector<QPointF> & points) {
+    if(points.isEmpty())
+        return;
+
+    // All the lines of this mouse move (the drawn lines and their symmetrical lines) are drawn in one batch
+    QVector<MandalaSegment> segments;
+    _symmetry.setVisibleArea(visibleArea(), _penSize / 2.0);
+    for(auto iter = points.begin(); iter != points.end(); ++iter) {
+        appendSymmetricalSegments(QLineF(_previousPoint, *iter), segments);
+        _strokeLines.push_back(QLineF(_previousPoint, *iter));
+        _previousPoint = *iter;
+    }
+
+    drawSegments(segments, _penSize);
+    _screenshotActivator += segments.size();
+    _strokeSegments += segments;
+    emit strokeExtended(points);
+}
+
+void MyQGraphicsView::updatePrediction() {
+    clearPrediction();
+
+    // Without prediction, the drawn stroke ends at the last filtered point (the mouse position when the stabilizer is off)
+    const StabilizerSettings & settings = _stabilizer.settings();
+    QPointF mouse = _stabilizer.lastPosition();
+    QPointF tip = _previousPoint;
+    if(settings.mode != StabilizerSettings::Off && settings.predictionTime > 0) {
+        // The tip goes from the last filtered point to the mouse (the smoothing lag), then on to the predicted position
+        tip = _stabilizer.predictedTip();
+        if(_previousPoint != mouse)
+            appendSymmetricalSegments(QLineF(_previousPoint, mouse), _predictionSegments);
+        appendSymmetricalSegments(QLineF(mouse, tip), _predictionSegments);
+        _scene->invalidate(MandalaRasterizer::segmentsBounds(_predictionSegments, _penSize), QGraphicsScene::ForegroundLayer);
+    }
+
+    // The tip latency is the distance between the drawn tip and the mouse, at the mouse speed
+    QPointF velocity = _stabilizer.velocity();
+    double speed = sqrt(velocity.x() * velocity.x() + velocity.y() * velocity.y());
+    if(speed > 0.05)
+        _tipLatency.addSample(QLineF(tip, mouse).length() / speed);
+}
+
+void MyQGraphicsView::clearPrediction() {
+    if(_predictionSegments.isEmpty())
+        return;
+    _scene->invalidate(MandalaRasterizer::segmentsBounds(_predictionSegments, _penSize), QGraphicsScene::ForegroundLayer);
+    _predictionSegments.clear();
+}
+
+void MyQGraphicsView::setStabilizerSettings(const StabilizerSettings & settings) {
+    _stabilizer.setSettings(settings);
+    resetLatency();
+}
+
+const LatencyMeter & MyQGraphicsView::inputLatency() const {
+    return _inputLatency;
+}
+
+const LatencyMeter & MyQGraphicsView::tipLatency() const {
+    return _tipLatency;
+}
+
+void MyQGraphicsView::resetLatency() {
+    _inputLatency.reset();
+    _tipLatency.reset();
+}
+
+void MyQGraphicsView::journalStroke(const QVector<MandalaSegment> & segments) {
+    if(!_journal.isOpen())
+        return;
+
+    _journal.appendStroke(_layers.currentStrokeLayerIndex(), _penSize, segments);
+    // The composite is up to date (it was just pushed on the undo stack): only its PNG encoding is left to the compaction thread
+    if(_journal.needsCompaction())
+        _journal.rebase(_layers.composite());
+}
+
+void MyQGraphicsView::documentStroke(const QVector<QLineF> & lines, const QVector<MandalaSegment> & segments) {
+    int layer = _layers.currentStrokeLayerIndex();
+    if(_slices > 0)
+        _document.addStroke(layer, _penSize, {_penColor.rgba(), _colorEngine.stroke()}, lines);
+    else
+        _document.addFixedStroke(layer, _penSize, segments);
+}
+
+void MyQGraphicsView::setDocument(const StrokeDocument & document) {
+    // The stroke being edited belonged to the previous document: its edit is dropped
+    if(_selectionItem) {
+        _layers.markItemsDirty(_selectionItem->sceneBoundingRect());
+        delete _selectionItem;
+        _selectionItem = nullptr;
+    }
+    _selectedStroke = -1;
+    _document = document;
+    _draftTimer.stop();
+    _reprojectionTimer.stop();
+}
+
+void MyQGraphicsView::requestReprojection() {
+    // The edited stroke is put back in the document: it is projected with the others
+    releaseSelection();
+    if(_slices == 0 || !_document.hasSymmetricStrokes())
+        return;
+
+    // While a slider is dragged, the draft follows the last value and the final pass waits until it stops
+    if(!_draftTimer.isActive())
+        _draftTimer.start();
+    _reprojectionTimer.start();
+}
+
+void MyQGraphicsView::reprojectDraft() {
+    // The stroke being drawn isn't in the document yet: the final pass waits for it
+    if(_drawLineIndicator == 0)
+        reproject(false);
+}
+
+void MyQGraphicsView::reprojectFinal() {
+    if(_drawLineIndicator > 0) {
+        _reprojectionTimer.start();
+        return;
+    }
+
+    // Without antialiasing, the draft is already the final drawing
+    if(renderHints().testFlag(QPainter::Antialiasing))
+        reproject(true);
+    pushScreenShot();
+    journalContent();
+}
+
+void MyQGraphicsView::reproject(bool antialiasing) {
+    clearContent();
+    if(!_document.base().isNull())
+        restoreScreenShot(_document.base());
+    QVector<ColorEngine> colors = strokeColorEngines();
+
+    // Only the transforms are new: the lines of the batches are reused as they are, and projected on all the CPU cores
+    _symmetry.setVisibleArea(visibleArea(), strokeReach());
+    _rasterizer.setAntialiasing(antialiasing);
+    const QVector<StrokeDocument::DocumentBatch> & batches = _document.batches();
+    for(int i=0; i<batches.size(); ++i) {
+        if(batches[i].layer >= _layers.strokeLayerCount())
+            continue;
+        MandalaLayer & layer = _layers.strokeLayer(batches[i].layer);
+        layer.markDirty(_rasterizer.rasterize(layer.raster(), _document.project(i, _symmetry, colors, _selectedStroke), batches[i].penWidth));
+    }
+
+    // The strokes other clients are drawing aren't in the document yet: they are projected again from their lines
+    for(auto iter = _remoteStrokes.begin(); iter != _remoteStrokes.end(); ++iter) {
+        iter->segments.clear();
+        projectRemoteLines(*iter, iter->lines, iter->segments);
+        iter->layer = qMin(iter->layer, _layers.strokeLayerCount() - 1);
+        MandalaLayer & layer = _layers.strokeLayer(iter->layer);
+        layer.markDirty(_rasterizer.rasterize(layer.raster(), iter->segments, iter->style.penWidth));
+    }
+    _scene->invalidate(QRectF(), QGraphicsScene::BackgroundLayer);
+}
+
+void MyQGraphicsView::setSelectionEnabled(bool selectionEnabled) {
+    _selectionEnabled = selectionEnabled;
+    if(!selectionEnabled)
+        commitSelection();
+}
+
+void MyQGraphicsView::setSelectedStrokeColor(QColor color) {
+    if(!_selectionItem)
+        return;
+    _selectionColor = color.rgba();
+    _selectionColors.setBaseColor(color);
+    updateSelectionInstances();
+}
+
+int MyQGraphicsView::pickStroke(QPointF point, QTransform & copy) {
+    if(_slices == 0)
+        return -1;
+
+    // The spatial index only knows the drawn geometry: each copy of the group brings the point back to it, the last drawn stroke found is on top
+    qreal tolerance = 4 / transform().m11();
+    QRectF area = visibleArea();
+    _symmetry.setVisibleArea(area, strokeReach());
+    QVector<SymmetryEngine::SymmetryCopy> copies = _symmetry.instances(area);
+    int found = -1;
+    for(auto iter = copies.begin(); iter != copies.end(); ++iter) {
+        int stroke = _document.strokeAt(iter->transform.inverted().map(point), tolerance);
+        if(stroke > found) {
+            found = stroke;
+            copy = iter->transform;
+        }
+    }
+
+    if(found >= 0) {
+        int layer = _document.batches()[_document.strokes()[found].batch].layer;
+        if(layer >= _layers.strokeLayerCount() || !_layers.strokeLayer(layer).isVisible())
+            return -1;
+    }
+    return found;
+}
+
+void MyQGraphicsView::selectStroke(int index) {
+    const DocumentStroke & stroke = _document.strokes()[index];
+    const StrokeDocument::DocumentBatch & batch = _document.batches()[stroke.batch];
+    _selectedStroke = index;
+    _selectionColor = stroke.color;
+    _selectionColors = _colorEngine;
+    _selectionColors.setBaseColor(QColor::fromRgba(stroke.color));
+    _selectionColors.setStroke(stroke.colorStroke);
+
+    // The layers are projected once without the stroke (a pending projection is superseded): while it is edited, only its lines and the transforms
+    // of its copies change
+    _draftTimer.stop();
+    _reprojectionTimer.stop();
+    reproject(renderHints().testFlag(QPainter::Antialiasing));
+    _selectionItem = new StrokeInstanceItem(_document.strokeLines(index), batch.penWidth);
+    _selectionItem->setEditTransform(stroke.transform);
+    _selectionItem->setZValue(batch.layer);
+    _scene->addItem(_selectionItem);
+    updateSelectionInstances();
+}
+
+void MyQGraphicsView::updateSelectionInstances() {
+    QRectF before = _selectionItem->sceneBoundingRect();
+    QRectF source = _selectionItem->sourceBounds();
+    _symmetry.setVisibleArea(visibleArea(), strokeReach());
+    QVector<SymmetryEngine::SymmetryCopy> copies = _symmetry.instances(source);
+
+    // The copies take the color of the stroke center (the projection colors each line at its own distance for the Radial palette)
+    double distance = QLineF(_symmetryCenter, source.center()).length();
+    QVector<StrokeInstance> instances;
+    instances.reserve(copies.size());
+    for(auto iter = copies.begin(); iter != copies.end(); ++iter)
+        instances.push_back({iter->transform, _hsvColorToggled ? _selectionColors.color(iter->colorIndex, distance) : _selectionColor});
+    _selectionItem->setInstances(instances);
 
-    if(_gridButtonEnabled)
-        setAndDrawSlices(_slices);
-    if(_mirrorButtonEnabled)
-        setMirrorLines();
+    QRectF changed = before | _selectionItem->sceneBoundingRect();
+    _layers.markItemsDirty(changed);
+    _scene->invalidate(changed, QGraphicsScene::ForegroundLayer);
+}
+
+void MyQGraphicsView::editSelection(QPointF point) {
+    // The drag is brought back through the grabbed copy: dragging a mirrored copy moves the drawn stroke the mirrored way
+    QTransform inverse = _editCopy.inverted();
+    QPointF from = inverse.map(_editOrigin), to = inverse.map(point);
+    QTransform step;
+    if(_editModifiers & Qt::ControlModifier) {
+        qreal angle = QLineF(_editCenter, from).angleTo(QLineF(_editCenter, to));
+        step.translate(_editCenter.x(), _editCenter.y());
+        step.rotate(-angle);
+        step.translate(-_editCenter.x(), -_editCenter.y());
+    } else if(_editModifiers & Qt::ShiftModifier) {
+        // Dragging up 100 pixels doubles the stroke, dragging down halves it
+        qreal factor = pow(2.0, (_editOrigin.y() - point.y()) * transform().m11() / 100.0);
+        step.translate(_editCenter.x(), _editCenter.y());
+        step.scale(factor, factor);
+        step.translate(-_editCenter.x(), -_editCenter.y());
+    } else {
+        step = QTransform::fromTranslate(to.x() - from.x(), to.y() - from.y());
+    }
+
+    _selectionItem->setEditTransform(_editStart * step);
+    updateSelectionInstances();
+}
+
+bool MyQGraphicsView::releaseSelection() {
+    if(!_selectionItem)
+        return false;
+
+    _document.setStrokeTransform(_selectedStroke, _selectionItem->editTransform());
+    _document.setStrokeColor(_selectedStroke, _selectionColor);
+    _layers.markItemsDirty(_selectionItem->sceneBoundingRect());
+    _scene->invalidate(_selectionItem->sceneBoundingRect(), QGraphicsScene::ForegroundLayer);
+    delete _selectionItem;
+    _selectionItem = nullptr;
+    _selectedStroke = -1;
+    return true;
+}
+
+void MyQGraphicsView::commitSelection() {
+    if(!releaseSelection())
+        return;
+
+    _draftTimer.stop();
+    _reprojectionTimer.stop();
+    reproject(renderHints().testFlag(QPainter::Antialiasing));
+    pushScreenShot();
+    journalContent();
+}
+
+void MyQGraphicsView::beginRemoteStroke(quint64 key, CollabStroke style, QPointF point) {
+    // The layers of the clients may differ: a stroke of a layer we don't have goes to our top layer
+    RemoteStroke & stroke = _remoteStrokes[key];
+    stroke.style = style;
+    stroke.layer = qBound(0, style.layer, _layers.strokeLayerCount() - 1);
+    stroke.symmetric = style.symmetric && _slices > 0;
+    stroke.previous = point;
+    stroke.lines.clear();
+    stroke.segments.clear();
+    stroke.colors = _colorEngine;
+    stroke.colors.setBaseColor(QColor::fromRgba(style.color));
+    stroke.colors.setStroke(style.colorStroke);
+}
+
+void MyQGraphicsView::extendRemoteStroke(quint64 key, QVector<QPointF> points) {
+    auto iter = _remoteStrokes.find(key);
+    if(iter == _remoteStrokes.end() || points.isEmpty())
+        return;
+
+    QVector<QLineF> lines;
+    lines.reserve(points.size());
+    for(auto point = points.begin(); point != points.end(); ++point) {
+        lines.push_back(QLineF(iter->previous, *point));
+        iter->previous = *point;
+    }
+    QVector<MandalaSegment> segments;
+    projectRemoteLines(*iter, lines, segments);
+    iter->layer = qMin(iter->layer, _layers.strokeLayerCount() - 1);
+    drawSegments(segments, iter->style.penWidth, iter->layer);
+    iter->lines += lines;
+    iter->segments += segments;
+}
+
+void MyQGraphicsView::endRemoteStroke(quint64 key) {
+    auto iter = _remoteStrokes.find(key);
+    if(iter == _remoteStrokes.end())
+        return;
+
+    RemoteStroke stroke = iter.value();
+    _remoteStrokes.erase(iter);
+    if(stroke.lines.isEmpty())
+        return;
+
+    if(stroke.symmetric)
+        _document.addStroke(stroke.layer, stroke.style.penWidth, {stroke.style.color, stroke.style.colorStroke}, stroke.lines);
+    else
+        _document.addFixedStroke(stroke.layer, stroke.style.penWidth, stroke.segments);
+    if(_journal.isOpen())
+        _journal.appendStroke(stroke.layer, stroke.style.penWidth, stroke.segments);
+
+    // While we draw, our own stroke pushes the content (with this stroke) on the undo stack when it is finished
+    if(_drawLineIndicator == 0)
+        pushScreenShot();
+}
+
+void MyQGraphicsView::projectRemoteLines(const RemoteStroke & stroke, const QVector<QLineF> & lines, QVector<MandalaSegment> & segments) {
+    _symmetry.setVisibleArea(visibleArea(), stroke.style.penWidth / 2.0);
+    for(auto iter = lines.begin(); iter != lines.end(); ++iter) {
+        if(stroke.symmetric)
+            _symmetry.apply(*iter, stroke.style.color, _hsvColorToggled ? &stroke.colors : nullptr, segments);
+        else
+            segments.push_back({*iter, stroke.style.color});
+    }
+}
+
+void MyQGraphicsView::journalContent() {
+    if(_journal.isOpen())
+        _journal.rebase(sceneIsEmpty() ? QImage() : _layers.composite());
+}
+
+void MyQGraphicsView::startJournal() {
+    if(_journalEnabled)
+        _journal.start(canvasSize(), sceneIsEmpty() ? QImage() : _layers.composite());
+}
+
+void MyQGraphicsView::setJournalEnabled(bool journalEnabled) {
+    _journalEnabled = journalEnabled;
+    if(journalEnabled)
+        startJournal();
+    else
+        _journal.discard();
+}
+
+void MyQGraphicsView::replayJournal(const JournalRecovery & recovery) {
+    // The document takes over the recovered journal: its files are replaced once the new journal has its snapshot
+    _journal.discard();
+    _journal.setDirectory(recovery.directory);
+    clearContent();
+    if(!recovery.base.isNull())
+        restoreScreenShot(recovery.base);
+
+    // Consecutive strokes of the same layer and pen width are drawn in one batch
+    int currentLayer = _layers.currentStrokeLayerIndex();
+    QVector<MandalaSegment> batch;
+    int batchLayer = 0;
+    int batchPenSize = 0;
+    auto drawBatch = [&]() {
+        while(_layers.strokeLayerCount() <= batchLayer)
+            _layers.addStrokeLayer(tr("Layer %1").arg(_layers.strokeLayerCount() + 1));
+        _layers.setCurrentStrokeLayer(batchLayer);
+        drawSegments(batch, batchPenSize);
+        batch.clear();
+    };
+
+    for(auto iter = recovery.strokes.begin(); iter != recovery.strokes.end(); ++iter) {
+        if(!batch.isEmpty() && (iter->layer != batchLayer || iter->penWidth != batchPenSize))
+            drawBatch();
+        batchLayer = qMax(0, iter->layer);
+        batchPenSize = iter->penWidth;
+        batch += iter->segments;
+    }
+    if(!batch.isEmpty())
+        drawBatch();
+
+    _layers.setCurrentStrokeLayer(currentLayer);
+    // The journal only keeps the symmetrical copies: the recovered drawing can't be projected again
+    setDocument(StrokeDocument(_layers.composite()));
+    pushScreenShot();
+    startJournal();
+    _scene->update();
+}
+
+void MyQGraphicsView::restoreScreenShot(const QImage & screenShot) {
+    // The screenshot is a composite of all the content layers: it goes to the background layer. A screenshot at the resolution of the layers
+    // is copied pixel for pixel, another image (an opened file, a screenshot of another screen) is resampled once to the canvas
+    MandalaLayer & background = _layers.background();
+    QRect canvas = _layers.canvasRect();
+    background.raster().render(QRectF(canvas), [&canvas, &screenShot](QPainter * painter) {
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+        painter->drawImage(QRectF(canvas), screenShot);
+    });
+    background.markDirty(_layers.canvasRect());
+    _scene->invalidate(QRectF(), QGraphicsScene::BackgroundLayer);
+}
+
+void MyQGraphicsView::clearContent() {
+    // The stroke being edited isn't part of the content: it stays in the scene
+    if(_selectionItem)
+        _scene->removeItem(_selectionItem);
+    _scene->clear();
+    if(_selectionItem)
+        _scene->addItem(_selectionItem);
+    _layers.clearContent();
+    _layers.markItemsDirty(_layers.canvasRect());
+    _scene->invalidate(QRectF(), QGraphicsScene::BackgroundLayer);
+}
+
+void MyQGraphicsView::resizePaintedItems() {
+    // clearScene() left an empty document. On a canvas of the same size the strokes are still where they were drawn: the document comes back
+    // as it was. On another size they were drawn around another symmetry center, so the drawing is resampled and becomes the base of the document
+    HistorySnapshot snapshot = _undoHistoryStack.top();
+    QImage image = snapshot.image();
+    if(QSizeF(image.size()) / image.devicePixelRatio() == QSizeF(canvasSize())) {
+        setDocument(snapshot.document());
+        reproject(renderHints().testFlag(QPainter::Antialiasing));
+    } else {
+        restoreScreenShot(image);
+        setDocument(StrokeDocument(_layers.composite()));
+        // Undoing goes back to the resampled drawing, not to strokes around the previous center
+        pushScreenShot();
+    }
+    journalContent();
 }
 
 bool MyQGraphicsView::undoStackIsEmpty() {
@@ -324,42 +1237,156 @@ bool MyQGraphicsView::undoStackIsEmpty() {
 }
 
 void MyQGraphicsView::openImage(QString f) {
-    _scene->clear();
-    QPixmap img = QPixmap(f);
-    _undoHistoryStack.push(img);
-    _scene->addPixmap(img.scaled(size()));
-
-    if(_gridButtonEnabled)
-        setAndDrawSlices(_slices);
-    if(_mirrorButtonEnabled)
-        setMirrorLines();
+    clearContent();
+    QImage img = QImage(f);
+    setDocument(StrokeDocument(img));
+    _undoHistoryStack.push(HistorySnapshot(img, _document));
+    restoreScreenShot(img);
+    journalContent();
+    MemoryBudget::instance()->requestEnforce();
 }
 
 void MyQGraphicsView::clearAllHistories() {
-    _scene->clear();
+    clearContent();
+    _layers.removeStrokeLayers();
+    _layers.addStrokeLayer(tr("Layer 1"));
     _undoHistoryStack.clear();
     _redoHistoryStack.clear();
+    _historyTruncated = false;
+    setDocument(StrokeDocument());
 }
 
-void MyQGraphicsView::pushScreenShot() {
-    removeAllDrawnSlices();
-    removeAllDrawnMirrorLines();
-    // We only screenshot the drawn items without grid slices and mirrors lines!
-    _undoHistoryStack.push(grab(QRect(QPoint(0,0), QSize(width(), height()))));
-    // We redraw grid slices and mirrors lines if their options are activated!
-    if(_gridButtonEnabled)
-        setAndDrawSlices(_slices);
-    if(_mirrorButtonEnabled)
-        setMirrorLines();
+HibernatedDocument MyQGraphicsView::hibernateDocument() {
+    // The edited stroke goes back in the document before it is flattened
+    commitSelection();
+
+    HibernatedDocument hibernated;
+    hibernated.canvasSize = canvasSize();
+    hibernated.settings = documentSettings();
+    if(!sceneIsEmpty())
+        hibernated.content = HistorySnapshot(_layers.composite(), _document);
+    hibernated.undoHistory = _undoHistoryStack;
+    hibernated.redoHistory = _redoHistoryStack;
+    hibernated.historyTruncated = _historyTruncated;
+    for(int i=0; i<_layers.strokeLayerCount(); ++i)
+        hibernated.layerNames << _layers.strokeLayer(i).name();
+
+    // The journal stays on the disk with the document: the empty view journals in a directory of its own until a document comes back
+    _journal.close();
+    hibernated.journalDirectory = _journal.directory();
+    _journal.setDirectory(StrokeJournal::newDirectory());
+
+    clearAllHistories();
+    return hibernated;
 }
 
-void MyQGraphicsView::mirrorSymetricDrawing(QGraphicsLineItem * item, QColor color) {
-    QTransform transform = QTransform().translate(width()/2, height()/2).rotate(180, Qt::XAxis).translate(-width()/2, -height()/2);
-    QLineF item2 = transform.map(item->line());
+void MyQGraphicsView::restoreDocument(const HibernatedDocument & hibernated) {
+    // Whatever was journaled since the view was emptied (or the document closed to make room for this one) belongs to no document
+    _journal.discard();
+    _journal.setDirectory(hibernated.journalDirectory.isEmpty() ? StrokeJournal::newDirectory() : hibernated.journalDirectory);
+    clearAllHistories();
+    if(hibernated.canvasSize.isValid())
+        setCanvasSize(hibernated.canvasSize);
 
-    _scene->addLine(item2, QPen(QBrush(color), _penSize, Qt::SolidLine, Qt::RoundCap));
+    // The view is empty: the settings of the document are taken as they are, nothing is projected again with them
+    const DocumentSettings & settings = hibernated.settings;
+    _slices = settings.slices;
+    _mirrorButtonEnabled = settings.mirror;
+    _hsvColorToggled = settings.rainbow;
+    _symmetry.setSettings(settings.symmetry);
+    _symmetry.setSlices(settings.slices);
+    _symmetry.setMirror(settings.mirror);
+    _colorEngine.setPalette(settings.palette);
+    _colorEngine.setCopyCount(_symmetry.colorCount());
+    updateGuides();
+
+    // The content comes back flattened in the background layer, like after an undo: its layers only hold what is drawn from now on
+    if(!hibernated.layerNames.isEmpty()) {
+        _layers.removeStrokeLayers();
+        for(auto iter = hibernated.layerNames.begin(); iter != hibernated.layerNames.end(); ++iter)
+            _layers.addStrokeLayer(*iter);
+        _layers.setCurrentStrokeLayer(0);
+    }
+    if(!hibernated.content.isNull()) {
+        restoreScreenShot(hibernated.content.image());
+        setDocument(hibernated.content.document());
+    }
+    _undoHistoryStack = hibernated.undoHistory;
+    _redoHistoryStack = hibernated.redoHistory;
+    _historyTruncated = hibernated.historyTruncated;
+    startJournal();
+    MemoryBudget::instance()->requestEnforce();
+}
+
+void MyQGraphicsView::pushScreenShot() {
+    // The composite only holds the content layers: grid slices and mirror lines are never in the screenshot
+    _undoHistoryStack.push(HistorySnapshot(_layers.composite(), _document));
+    MemoryBudget::instance()->requestEnforce();
 }
 
 bool MyQGraphicsView::sceneIsEmpty() {
-    return _scene->items().empty();
+    return _scene->items().empty() && _layers.contentIsEmpty();
+}
+
+qint64 MyQGraphicsView::historyBytes() const {
+    qint64 bytes = 0;
+    for(auto iter = _undoHistoryStack.begin(); iter != _undoHistoryStack.end(); ++iter)
+        bytes += iter->byteCount();
+    for(auto iter = _redoHistoryStack.begin(); iter != _redoHistoryStack.end(); ++iter)
+        bytes += iter->byteCount();
+    return bytes;
+}
+
+qint64 MyQGraphicsView::releaseHistory(qint64 bytes) {
+    qint64 before = historyBytes();
+    while(!_redoHistoryStack.isEmpty() && before - historyBytes() < bytes)
+        _redoHistoryStack.remove(0);
+    while(_undoHistoryStack.size() > 1 && before - historyBytes() < bytes) {
+        _undoHistoryStack.remove(0);
+        _historyTruncated = true;
+    }
+    return before - historyBytes();
+}
+
+qint64 MyQGraphicsView::flattenItems() {
+    QList<QGraphicsItem *> items = _scene->items(Qt::AscendingOrder);
+    if(items.isEmpty())
+        return 0;
+
+    qint64 before = items.size() * ItemBytes + _layers.byteCount();
+
+    // The items of a stroke layer have the layer index as Z value: each layer gets its items, painted in their stacking order
+    for(int layer=0; layer<_layers.strokeLayerCount(); ++layer) {
+        QVector<QGraphicsLineItem *> lines;
+        QRectF bounds;
+        for(auto iter = items.begin(); iter != items.end(); ++iter) {
+            QGraphicsLineItem * line = qgraphicsitem_cast<QGraphicsLineItem *>(*iter);
+            if(line && line->zValue() == layer) {
+                lines.push_back(line);
+                bounds |= line->sceneBoundingRect();
+            }
+        }
+        if(lines.isEmpty())
+            continue;
+
+        MandalaLayer & strokeLayer = _layers.strokeLayer(layer);
+        bool antialiasing = renderHints().testFlag(QPainter::Antialiasing);
+        strokeLayer.raster().render(bounds, [&lines, antialiasing](QPainter * painter) {
+            painter->setRenderHint(QPainter::Antialiasing, antialiasing);
+            for(auto iter = lines.begin(); iter != lines.end(); ++iter) {
+                painter->setPen((*iter)->pen());
+                painter->drawLine((*iter)->line());
+            }
+        });
+        strokeLayer.markDirty(bounds);
+    }
+
+    if(_selectionItem)
+        _scene->removeItem(_selectionItem);
+    _scene->clear();
+    if(_selectionItem)
+        _scene->addItem(_selectionItem);
+    _layers.markItemsDirty(_layers.canvasRect());
+    _scene->invalidate(QRectF(), QGraphicsScene::BackgroundLayer);
+    return before - (_scene->items().size() * ItemBytes + _layers.byteCount());
 }
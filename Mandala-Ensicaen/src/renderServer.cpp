@@ -0,0 +1,450 @@
+/**
+ * @file   renderServer.cpp
+ * @date   October 2026
+ *
+ * @brief  renderServer is the headless render service: it accepts command files (see mandalaScript) over a local socket, renders their variations
+ * on a warm thread pool with reused buffers, and streams the encoded images back as they are done. The jobs have a timeout, the server refuses
+ * jobs when it is full, and it keeps throughput counters
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "renderServer.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSaveFile>
+#include <QThreadStorage>
+#include <QtConcurrent/QtConcurrentRun>
+#include <limits>
+
+const QString RenderServer::DefaultName = "mandala-render";
+const int RenderServer::DefaultTimeout = 30000;
+const int RenderServer::MaxRequestBytes = 16 * 1024 * 1024;
+const qint64 RenderServer::OutputHighWater = 64 * 1024 * 1024;
+
+namespace {
+    const quint32 MessageMagic = 0x4D524E44;
+    const quint16 MessageVersion = 1;
+
+    void writeHeader(QDataStream & stream, int type, quint32 id) {
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << MessageMagic << MessageVersion << quint8(type) << id;
+    }
+
+    bool readHeader(QDataStream & stream, int & type, quint32 & id) {
+        stream.setVersion(QDataStream::Qt_5_0);
+        quint32 magic;
+        quint16 version;
+        quint8 messageType;
+        stream >> magic >> version >> messageType >> id;
+        type = messageType;
+        return stream.status() == QDataStream::Ok && magic == MessageMagic && version == MessageVersion;
+    }
+
+    qint64 writeFrame(QLocalSocket * socket, const QByteArray & payload) {
+        QDataStream stream(socket);
+        stream << quint32(payload.size());
+        socket->write(payload);
+        return payload.size() + 4;
+    }
+
+    // Let us get the next frame of a socket: false while it isn't complete, or if it is larger than we accept
+    bool readFrame(QLocalSocket * socket, QByteArray & payload, quint32 maxSize, bool & tooLarge) {
+        tooLarge = false;
+        if(socket->bytesAvailable() < 4)
+            return false;
+        QByteArray prefix = socket->peek(4);
+        QDataStream stream(prefix);
+        quint32 size;
+        stream >> size;
+        if(size > maxSize) {
+            tooLarge = true;
+            return false;
+        }
+        if(socket->bytesAvailable() < 4 + qint64(size))
+            return false;
+        socket->read(4);
+        payload = socket->read(size);
+        return true;
+    }
+
+    // Let us wait for the next frame of a blocking client
+    bool waitForFrame(QLocalSocket & socket, QByteArray & payload, int timeout) {
+        bool tooLarge;
+        while(!readFrame(&socket, payload, std::numeric_limits<quint32>::max(), tooLarge))
+            if(!socket.waitForReadyRead(timeout))
+                return false;
+        return true;
+    }
+}
+
+RenderServer::RenderServer(QObject *parent) : QObject(parent), _server(new QLocalServer(this)) {
+    // The threads never expire: their rendering buffers are kept from a job to the next one
+    _pool.setExpiryTimeout(-1);
+    _maxPendingJobs = 2 * _pool.maxThreadCount();
+    _deadlineTimer.setInterval(100);
+    _uptime.start();
+
+    connect(_server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+    connect(&_deadlineTimer, SIGNAL(timeout()), this, SLOT(checkDeadlines()));
+}
+
+RenderServer::~RenderServer() {
+    for(auto iter = _jobs.begin(); iter != _jobs.end(); ++iter)
+        iter->cancelled->store(1);
+    _pool.waitForDone();
+}
+
+bool RenderServer::listen(const QString & name) {
+    if(_server->listen(name))
+        return true;
+
+    // The socket file of a server that crashed is still there: it is removed, unless a server answers on it
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if(probe.waitForConnected(500)) {
+        _error = tr("A render server already listens on %1").arg(name);
+        return false;
+    }
+    QLocalServer::removeServer(name);
+    if(!_server->listen(name)) {
+        _error = _server->errorString();
+        return false;
+    }
+    return true;
+}
+
+QString RenderServer::errorString() const {
+    return _error;
+}
+
+void RenderServer::setMaxPendingJobs(int maxPendingJobs) {
+    _maxPendingJobs = qMax(1, maxPendingJobs);
+}
+
+QJsonObject RenderServer::stats() const {
+    double seconds = qMax(qint64(1), _uptime.elapsed()) / 1000.0;
+    QJsonObject stats;
+    stats["accepted"] = double(_accepted);
+    stats["completed"] = double(_completed);
+    stats["failed"] = double(_failed);
+    stats["timedOut"] = double(_timedOut);
+    stats["refused"] = double(_refused);
+    stats["pending"] = _jobs.size();
+    stats["workers"] = _workers;
+    stats["images"] = double(_images);
+    stats["bytesSent"] = double(_bytesSent);
+    stats["uptime"] = seconds;
+    stats["meanRenderMs"] = _images > 0 ? double(_renderTime) / _images : 0.0;
+    stats["imagesPerSecond"] = _images / seconds;
+    return stats;
+}
+
+void RenderServer::newConnection() {
+    while(_server->hasPendingConnections()) {
+        QLocalSocket * client = _server->nextPendingConnection();
+        connect(client, SIGNAL(readyRead()), this, SLOT(readClient()));
+        connect(client, SIGNAL(disconnected()), this, SLOT(clientDisconnected()));
+        connect(client, SIGNAL(disconnected()), client, SLOT(deleteLater()));
+    }
+}
+
+void RenderServer::readClient() {
+    QLocalSocket * client = qobject_cast<QLocalSocket *>(sender());
+    if(!client)
+        return;
+
+    QByteArray payload;
+    bool tooLarge;
+    while(readFrame(client, payload, MaxRequestBytes, tooLarge)) {
+        QDataStream stream(payload);
+        int type;
+        quint32 id;
+        if(!readHeader(stream, type, id)) {
+            client->abort();
+            return;
+        }
+
+        if(type == StatsRequest) {
+            QByteArray reply;
+            QDataStream replyStream(&reply, QIODevice::WriteOnly);
+            writeHeader(replyStream, StatsReply, id);
+            replyStream << QJsonDocument(stats()).toJson(QJsonDocument::Compact);
+            _bytesSent += writeFrame(client, reply);
+        } else if(type == RenderRequest) {
+            startJob(client, id, stream);
+        } else {
+            client->abort();
+            return;
+        }
+    }
+    // A client sending more than a request can hold isn't one of ours
+    if(tooLarge)
+        client->abort();
+}
+
+void RenderServer::startJob(QLocalSocket * client, quint32 id, QDataStream & stream) {
+    QString script, directory;
+    qint32 width, height, timeout;
+    stream >> script >> directory >> width >> height >> timeout;
+
+    QString error;
+    MandalaScript parsed;
+    // No size (both sides below 1) keeps the canvas size of the script, any other size is checked like the canvas command of a script
+    bool sized = width >= 1 || height >= 1;
+    if(stream.status() != QDataStream::Ok) {
+        error = tr("Malformed render request");
+        ++_failed;
+    } else if(sized && (width < 1 || height < 1 || width > MandalaScript::MaxCanvasSide || height > MandalaScript::MaxCanvasSide)) {
+        error = tr("The image size must be between 1 and %1 pixels").arg(MandalaScript::MaxCanvasSide);
+        ++_failed;
+    } else if(_workers >= _maxPendingJobs || client->bytesToWrite() > OutputHighWater) {
+        // Backpressure: the client tries again later instead of piling up jobs (or images it doesn't read). A job that was dropped still
+        // holds its pool thread until it reaches its next variation, so it counts until its worker stops
+        error = tr("The render server is busy");
+        ++_refused;
+    } else if(!parsed.parse(script, directory)) {
+        error = parsed.errorString();
+        ++_failed;
+    }
+    if(!error.isEmpty()) {
+        QByteArray reply;
+        QDataStream replyStream(&reply, QIODevice::WriteOnly);
+        writeHeader(replyStream, ErrorReply, id);
+        replyStream << error;
+        _bytesSent += writeFrame(client, reply);
+        return;
+    }
+
+    ++_accepted;
+    quint64 job = _nextJob++;
+    Job & entry = _jobs[job];
+    entry.client = client;
+    entry.id = id;
+    entry.clock.start();
+    entry.timeout = timeout > 0 ? timeout : DefaultTimeout;
+    entry.images = 0;
+    entry.cancelled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    ++_workers;
+    QtConcurrent::run(&_pool, &RenderServer::runJob, this, job, parsed.variations(), sized ? QSize(width, height) : QSize(), entry.cancelled);
+
+    if(!_deadlineTimer.isActive())
+        _deadlineTimer.start();
+}
+
+void RenderServer::runJob(RenderServer * server, quint64 job, const QVector<ScriptVariation> & variations, QSize size, QSharedPointer<QAtomicInt> cancelled) {
+    // The buffers belong to the pool thread: the next job it runs renders in them again
+    static QThreadStorage<ScriptBuffers *> threadBuffers;
+    if(!threadBuffers.hasLocalData())
+        threadBuffers.setLocalData(new ScriptBuffers);
+    ScriptBuffers & buffers = *threadBuffers.localData();
+
+    QString error;
+    for(auto iter = variations.begin(); iter != variations.end(); ++iter) {
+        // A job that timed out (or whose client left) stops at the next variation
+        if(cancelled->load())
+            break;
+
+        // The image is rasterized at the requested size, not scaled from the canvas one
+        QElapsedTimer clock;
+        clock.start();
+        QImage image = MandalaScript::render(*iter, buffers, size.isValid() ? size : iter->canvasSize);
+
+        // The image is encoded in the format of its output file name
+        QByteArray format = QFileInfo(iter->output).suffix().toUpper().toLatin1();
+        if(format.isEmpty())
+            format = "PNG";
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        bool encoded = image.save(&buffer, format.constData());
+        // The image buffer is released before the next variation is rendered in it
+        image = QImage();
+
+        if(!encoded) {
+            error = QString("variation %1: can't encode %2").arg(iter->index).arg(QString(format));
+            break;
+        }
+        QMetaObject::invokeMethod(server, "imageRendered", Qt::QueuedConnection, Q_ARG(quint64, job), Q_ARG(int, iter->index),
+                                  Q_ARG(QString, iter->output), Q_ARG(QByteArray, data), Q_ARG(qint64, clock.elapsed()));
+    }
+    // A cancelled job was already forgotten by the server: its end is dropped, but its thread is free again
+    QMetaObject::invokeMethod(server, "jobFinished", Qt::QueuedConnection, Q_ARG(quint64, job), Q_ARG(QString, error));
+    QMetaObject::invokeMethod(server, "workerFinished", Qt::QueuedConnection);
+}
+
+void RenderServer::imageRendered(quint64 job, int index, QString output, QByteArray data, qint64 renderTime) {
+    auto iter = _jobs.find(job);
+    if(iter == _jobs.end() || !iter->client)
+        return;
+
+    QByteArray reply;
+    QDataStream stream(&reply, QIODevice::WriteOnly);
+    writeHeader(stream, ImageReply, iter->id);
+    stream << qint32(index) << output << data;
+    _bytesSent += writeFrame(iter->client, reply);
+
+    ++iter->images;
+    ++_images;
+    _renderTime += renderTime;
+}
+
+void RenderServer::jobFinished(quint64 job, QString error) {
+    if(!_jobs.contains(job))
+        return;
+    if(error.isEmpty())
+        ++_completed;
+    else
+        ++_failed;
+    finishJob(job, error.isEmpty() ? DoneReply : ErrorReply, error);
+}
+
+void RenderServer::workerFinished() {
+    --_workers;
+}
+
+void RenderServer::finishJob(quint64 job, MessageType type, const QString & error) {
+    auto iter = _jobs.find(job);
+    if(iter == _jobs.end())
+        return;
+
+    if(iter->client) {
+        QByteArray reply;
+        QDataStream stream(&reply, QIODevice::WriteOnly);
+        writeHeader(stream, type, iter->id);
+        if(type == DoneReply)
+            stream << qint32(iter->images) << qint64(iter->clock.elapsed());
+        else
+            stream << error;
+        _bytesSent += writeFrame(iter->client, reply);
+    }
+
+    iter->cancelled->store(1);
+    _jobs.erase(iter);
+    if(_jobs.isEmpty())
+        _deadlineTimer.stop();
+}
+
+void RenderServer::checkDeadlines() {
+    QList<quint64> late;
+    for(auto iter = _jobs.begin(); iter != _jobs.end(); ++iter)
+        if(iter->clock.elapsed() > iter->timeout)
+            late.push_back(iter.key());
+
+    for(auto iter = late.begin(); iter != late.end(); ++iter) {
+        ++_timedOut;
+        finishJob(*iter, ErrorReply, tr("The job timed out after %1 ms").arg(_jobs[*iter].timeout));
+    }
+}
+
+void RenderServer::clientDisconnected() {
+    // The jobs of a client that left are cancelled: nobody would read their images
+    QLocalSocket * client = qobject_cast<QLocalSocket *>(sender());
+    for(auto iter = _jobs.begin(); iter != _jobs.end();) {
+        if(iter->client == client || !iter->client) {
+            iter->cancelled->store(1);
+            iter = _jobs.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    if(_jobs.isEmpty())
+        _deadlineTimer.stop();
+}
+
+QStringList RenderServer::submit(const QString & name, const QString & fileName, QSize size, int timeout) {
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return QStringList() << QString("Can't read %1").arg(fileName);
+
+    QLocalSocket socket;
+    socket.connectToServer(name);
+    if(!socket.waitForConnected(1000))
+        return QStringList() << QString("Can't connect to %1: %2").arg(name).arg(socket.errorString());
+
+    QByteArray request;
+    QDataStream stream(&request, QIODevice::WriteOnly);
+    writeHeader(stream, RenderRequest, 1);
+    stream << QString::fromUtf8(file.readAll()) << QFileInfo(fileName).absolutePath() << qint32(size.width()) << qint32(size.height()) << qint32(timeout);
+    writeFrame(&socket, request);
+    socket.flush();
+
+    // The images come as they are rendered: each one is saved at once
+    QStringList reports;
+    int wait = (timeout > 0 ? timeout : DefaultTimeout) + 5000;
+    forever {
+        QByteArray reply;
+        if(!waitForFrame(socket, reply, wait)) {
+            reports << QString("The render server didn't answer");
+            return reports;
+        }
+
+        QDataStream replyStream(reply);
+        int type;
+        quint32 id;
+        if(!readHeader(replyStream, type, id)) {
+            reports << QString("Malformed reply");
+            return reports;
+        }
+
+        if(type == ImageReply) {
+            qint32 index;
+            QString output;
+            QByteArray data;
+            replyStream >> index >> output >> data;
+            QDir().mkpath(QFileInfo(output).path());
+            QSaveFile image(output);
+            if(image.open(QIODevice::WriteOnly) && image.write(data) == data.size() && image.commit())
+                reports << QString("variation %1: %2").arg(index).arg(output);
+            else
+                reports << QString("variation %1: can't write %2").arg(index).arg(output);
+        } else if(type == DoneReply) {
+            qint32 images;
+            qint64 elapsed;
+            replyStream >> images >> elapsed;
+            reports << QString("%1 images in %2 ms").arg(images).arg(elapsed);
+            return reports;
+        } else if(type == ErrorReply) {
+            QString error;
+            replyStream >> error;
+            reports << error;
+            return reports;
+        } else {
+            reports << QString("Unexpected reply");
+            return reports;
+        }
+    }
+}
+
+QString RenderServer::requestStats(const QString & name) {
+    QLocalSocket socket;
+    socket.connectToServer(name);
+    if(!socket.waitForConnected(1000))
+        return QString("Can't connect to %1: %2").arg(name).arg(socket.errorString());
+
+    QByteArray request;
+    QDataStream stream(&request, QIODevice::WriteOnly);
+    writeHeader(stream, StatsRequest, 1);
+    writeFrame(&socket, request);
+    socket.flush();
+
+    QByteArray reply;
+    if(!waitForFrame(socket, reply, 5000))
+        return QString("The render server didn't answer");
+    QDataStream replyStream(reply);
+    int type;
+    quint32 id;
+    QByteArray json;
+    if(!readHeader(replyStream, type, id) || type != StatsReply)
+        return QString("Malformed reply");
+    replyStream >> json;
+    return QString::fromUtf8(json);
+}
@@ -0,0 +1,281 @@
+/**
+ * @file   renderVerifier.cpp
+ * @date   October 2026
+ *
+ * @brief  renderVerifier checks the optimised rendering paths against the first symmetry method drawn with QGraphicsLineItem objects (--verify-render): it replays a corpus of drawings
+ * offscreen through each backend of MyQGraphicsView, compares the images with a per-pixel tolerance and an SSIM score, writes the diff images,
+ * and reports the speedup of each backend next to its result
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "renderVerifier.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <math.h>
+
+const int RenderVerifier::DefaultTolerance = 8;
+const double RenderVerifier::DefaultMinimumSsim = 0.98;
+const double RenderVerifier::MaxMismatchedRatio = 0.005;
+const int RenderVerifier::Runs = 3;
+
+namespace {
+    // A spiral stroke as the mouse would draw it: points polyline points from the radius first to the radius last
+    QPolygonF spiral(QPointF center, double first, double last, double turns, int points, double phase) {
+        QPolygonF stroke;
+        for(int i=0; i<points; ++i) {
+            double t = double(i) / qMax(1, points - 1);
+            double angle = phase + t * turns * 2 * M_PI;
+            double radius = first + t * (last - first);
+            stroke << center + QPointF(radius * cos(angle), radius * sin(angle));
+        }
+        return stroke;
+    }
+
+    inline double luma(QRgb color) {
+        return 0.299 * qRed(color) + 0.587 * qGreen(color) + 0.114 * qBlue(color);
+    }
+
+    QString drawingName(const ScriptVariation & variation) {
+        return variation.output.isEmpty() ? QString("variation%1").arg(variation.index) : QFileInfo(variation.output).completeBaseName();
+    }
+}
+
+QVector<RenderConfiguration> RenderVerifier::configurations(const ScriptVariation & variation) {
+    // The reference doesn't go through the symmetry engine it verifies, when the first symmetry method can draw the drawing
+    QVector<RenderConfiguration> configurations;
+    if(variation.symmetry.mode == SymmetrySettings::Dihedral && variation.symmetry.mirrorAngle == 0)
+        configurations.push_back({ "legacy", MyQGraphicsView::ItemBackend, false, true });
+    configurations.push_back({ "items", MyQGraphicsView::ItemBackend, false, false });
+    configurations.push_back({ "raster", MyQGraphicsView::RasterBackend, false, false });
+    configurations.push_back({ "raster+kernels", MyQGraphicsView::RasterBackend, true, false });
+    return configurations;
+}
+
+QVector<ScriptVariation> RenderVerifier::builtinCorpus() {
+    QVector<ScriptVariation> corpus;
+    QPointF center(300, 300);
+
+    ScriptVariation dihedral;
+    dihedral.output = "dihedral-12";
+    dihedral.slices = 12;
+    dihedral.penSize = 3;
+    dihedral.strokes << spiral(center, 20, 260, 1.5, 120, 0) << spiral(center, 60, 200, -0.75, 80, 0.3) << spiral(center, 240, 40, 0.4, 60, 1.1);
+    corpus << dihedral;
+
+    ScriptVariation dense;
+    dense.output = "dihedral-360-mirror";
+    dense.slices = 360;
+    dense.mirror = true;
+    dense.penSize = 1;
+    dense.strokes << spiral(center, 30, 280, 0.2, 60, 0);
+    corpus << dense;
+
+    ScriptVariation rainbow;
+    rainbow.output = "rainbow-8";
+    rainbow.slices = 8;
+    rainbow.rainbow = true;
+    rainbow.penSize = 2;
+    GeneratorSettings rosette;
+    rosette.segments = 800;
+    rainbow.generators << rosette;
+    rainbow.strokes << spiral(center, 50, 250, 1, 90, 0.5);
+    corpus << rainbow;
+
+    ScriptVariation wallpaper;
+    wallpaper.output = "wallpaper-p4m";
+    wallpaper.slices = 4;
+    wallpaper.symmetry.mode = SymmetrySettings::Wallpaper;
+    wallpaper.symmetry.wallpaperGroup = SymmetrySettings::P4M;
+    wallpaper.symmetry.cellSize = 80;
+    wallpaper.penSize = 2;
+    wallpaper.strokes << spiral(QPointF(320, 320), 5, 35, 1.25, 50, 0);
+    corpus << wallpaper;
+
+    ScriptVariation aliased;
+    aliased.output = "odd-7-aliased";
+    aliased.slices = 7;
+    aliased.antialiasing = false;
+    aliased.penSize = 5;
+    aliased.color = QColor(200, 30, 90);
+    aliased.strokes << spiral(center, 40, 270, 0.9, 70, 0.2);
+    corpus << aliased;
+
+    for(int i=0; i<corpus.size(); ++i)
+        corpus[i].index = i;
+    return corpus;
+}
+
+QImage RenderVerifier::replay(const ScriptVariation & variation, const RenderConfiguration & configuration, double & milliseconds) {
+    // The view is never shown: the symmetry always covers its whole canvas, and nothing is journaled
+    MyQGraphicsView view;
+    view.setRenderBackend(configuration.backend);
+    view.setSymmetryKernelsEnabled(configuration.kernels);
+    view.setLegacySymmetryEnabled(configuration.legacy);
+    view.resize(variation.canvasSize);
+    view.setCanvasSize(variation.canvasSize);
+    view.setRenderHint(QPainter::Antialiasing, variation.antialiasing);
+    view.setSymmetrySettings(variation.symmetry);
+    view.setMirrorButtonEnabled(variation.mirror);
+    view.setAndDrawSlices(variation.slices);
+    view.setColorPalette(variation.palette);
+    view.setPenColor(variation.color);
+    view.setPenSize(variation.penSize);
+    view.setRainbowMode(variation.rainbow);
+
+    QElapsedTimer clock;
+    clock.start();
+    for(auto stroke = variation.strokes.begin(); stroke != variation.strokes.end(); ++stroke) {
+        QVector<QLineF> lines;
+        for(int i=1; i<stroke->size(); ++i)
+            lines.push_back(QLineF(stroke->at(i-1), stroke->at(i)));
+        view.drawLines(lines);
+    }
+    for(auto generator = variation.generators.begin(); generator != variation.generators.end(); ++generator)
+        view.generate(*generator);
+    QImage image = view.exportImage(1).copy();
+    milliseconds = clock.nsecsElapsed() / 1e6;
+    return image;
+}
+
+double RenderVerifier::ssim(const QImage & first, const QImage & second) {
+    const int Window = 8;
+    const int Step = 4;
+    const double C1 = pow(0.01 * 255, 2);
+    const double C2 = pow(0.03 * 255, 2);
+
+    QImage a = first.convertToFormat(QImage::Format_RGB32);
+    QImage b = second.convertToFormat(QImage::Format_RGB32);
+    QVector<double> lumaA(a.width() * a.height()), lumaB(b.width() * b.height());
+    for(int y=0; y<a.height(); ++y) {
+        const QRgb * rowA = reinterpret_cast<const QRgb *>(a.constScanLine(y));
+        const QRgb * rowB = reinterpret_cast<const QRgb *>(b.constScanLine(y));
+        for(int x=0; x<a.width(); ++x) {
+            lumaA[y * a.width() + x] = luma(rowA[x]);
+            lumaB[y * a.width() + x] = luma(rowB[x]);
+        }
+    }
+
+    double sum = 0;
+    int windows = 0;
+    const int n = Window * Window;
+    for(int y=0; y+Window<=a.height(); y+=Step) {
+        for(int x=0; x+Window<=a.width(); x+=Step) {
+            double meanA = 0, meanB = 0;
+            for(int j=0; j<Window; ++j)
+                for(int i=0; i<Window; ++i) {
+                    meanA += lumaA[(y + j) * a.width() + x + i];
+                    meanB += lumaB[(y + j) * a.width() + x + i];
+                }
+            meanA /= n;
+            meanB /= n;
+            double varianceA = 0, varianceB = 0, covariance = 0;
+            for(int j=0; j<Window; ++j)
+                for(int i=0; i<Window; ++i) {
+                    double da = lumaA[(y + j) * a.width() + x + i] - meanA;
+                    double db = lumaB[(y + j) * a.width() + x + i] - meanB;
+                    varianceA += da * da;
+                    varianceB += db * db;
+                    covariance += da * db;
+                }
+            varianceA /= n - 1;
+            varianceB /= n - 1;
+            covariance /= n - 1;
+            sum += ((2 * meanA * meanB + C1) * (2 * covariance + C2)) / ((meanA * meanA + meanB * meanB + C1) * (varianceA + varianceB + C2));
+            ++windows;
+        }
+    }
+    return windows ? sum / windows : 1;
+}
+
+RenderComparison RenderVerifier::compare(const QImage & reference, const QImage & image, int tolerance) {
+    RenderComparison comparison;
+    if(reference.size() != image.size()) {
+        comparison.pixels = qint64(reference.width()) * reference.height();
+        comparison.mismatched = comparison.pixels;
+        comparison.ssim = 0;
+        return comparison;
+    }
+
+    QImage a = reference.convertToFormat(QImage::Format_RGB32);
+    QImage b = image.convertToFormat(QImage::Format_RGB32);
+    comparison.pixels = qint64(a.width()) * a.height();
+    comparison.diff = QImage(a.size(), QImage::Format_RGB32);
+    for(int y=0; y<a.height(); ++y) {
+        const QRgb * rowA = reinterpret_cast<const QRgb *>(a.constScanLine(y));
+        const QRgb * rowB = reinterpret_cast<const QRgb *>(b.constScanLine(y));
+        QRgb * out = reinterpret_cast<QRgb *>(comparison.diff.scanLine(y));
+        for(int x=0; x<a.width(); ++x) {
+            int difference = qMax(qAbs(qRed(rowA[x]) - qRed(rowB[x])),
+                                  qMax(qAbs(qGreen(rowA[x]) - qGreen(rowB[x])), qAbs(qBlue(rowA[x]) - qBlue(rowB[x]))));
+            if(difference > tolerance) {
+                ++comparison.mismatched;
+                out[x] = qRgb(255, 0, 0);
+            } else if(difference > 0) {
+                out[x] = qRgb(255, 160, 0);
+            } else {
+                int faded = 255 - (255 - int(luma(rowA[x]))) / 4;
+                out[x] = qRgb(faded, faded, faded);
+            }
+        }
+    }
+    comparison.ssim = ssim(a, b);
+    return comparison;
+}
+
+QStringList RenderVerifier::verify(const QVector<ScriptVariation> & corpus, const QString & directory, int tolerance, double minimumSsim, bool & passed) {
+    QStringList report;
+    if(!directory.isEmpty())
+        QDir().mkpath(directory);
+
+    passed = true;
+    int comparisons = 0, matches = 0;
+    for(auto variation = corpus.begin(); variation != corpus.end(); ++variation) {
+        QString name = drawingName(*variation);
+        QVector<RenderConfiguration> configurations = RenderVerifier::configurations(*variation);
+        QImage reference;
+        double referenceTime = 0;
+        for(int c=0; c<configurations.size(); ++c) {
+            // The fastest of the runs: the first one also pays for the caches and the thread pool
+            QImage image;
+            double best = -1;
+            for(int run=0; run<Runs; ++run) {
+                double time;
+                image = replay(*variation, configurations[c], time);
+                if(best < 0 || time < best)
+                    best = time;
+            }
+
+            if(c == 0) {
+                reference = image;
+                referenceTime = best;
+                if(!directory.isEmpty())
+                    reference.save(QDir(directory).filePath(name + "_" + configurations[c].name + ".png"));
+                report << QString("%1 %2 (reference): %3 ms").arg(name, configurations[c].name).arg(best, 0, 'f', 2);
+                continue;
+            }
+
+            RenderComparison comparison = compare(reference, image, tolerance);
+            double ratio = comparison.pixels ? double(comparison.mismatched) / comparison.pixels : 0;
+            bool match = comparison.ssim >= minimumSsim && ratio <= MaxMismatchedRatio;
+            ++comparisons;
+            matches += match ? 1 : 0;
+            passed = passed && match;
+            if(!directory.isEmpty()) {
+                image.save(QDir(directory).filePath(name + "_" + configurations[c].name + ".png"));
+                if(!comparison.diff.isNull())
+                    comparison.diff.save(QDir(directory).filePath(name + "_" + configurations[c].name + "_diff.png"));
+            }
+            report << QString("%1 %2: %3 ms, x%4 vs %5, ssim %6, %7% pixels over %8, %9")
+                      .arg(name, configurations[c].name).arg(best, 0, 'f', 2).arg(referenceTime / qMax(best, 0.001), 0, 'f', 2)
+                      .arg(configurations[0].name).arg(comparison.ssim, 0, 'f', 5).arg(100 * ratio, 0, 'f', 3).arg(tolerance)
+                      .arg(match ? "match" : "MISMATCH");
+        }
+    }
+    report << QString("%1/%2 images match their reference (tolerance %3, ssim >= %4, at most %5% pixels over the tolerance)")
+              .arg(matches).arg(comparisons).arg(tolerance).arg(minimumSsim).arg(100 * MaxMismatchedRatio);
+    return report;
+}
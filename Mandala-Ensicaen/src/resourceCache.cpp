@@ -0,0 +1,51 @@
+/**
+ * @file   resourceCache.cpp
+ * @date   October 2026
+ *
+ * @brief  resourceCache decodes the images of the resources the first time they are used, and keeps them (and their scaled copies and the drawing cursors)
+ * so that they are never decoded or scaled again
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "resourceCache.h"
+#include <QHash>
+#include <QPair>
+#include <QPixmapCache>
+
+QPixmap ResourceCache::pixmap(const QString & path) {
+    QPixmap pixmap;
+    if(!QPixmapCache::find(path, &pixmap)) {
+        pixmap = QPixmap(path);
+        QPixmapCache::insert(path, pixmap);
+    }
+    return pixmap;
+}
+
+QPixmap ResourceCache::scaledPixmap(const QString & path, QSize size, qreal devicePixelRatio) {
+    QString key = QString("%1@%2x%3@%4").arg(path).arg(size.width()).arg(size.height()).arg(devicePixelRatio);
+    QPixmap scaled;
+    if(!QPixmapCache::find(key, &scaled)) {
+        // The image is scaled from the resource straight to the device pixels: it is never scaled again by the screen
+        scaled = pixmap(path).scaled(size * devicePixelRatio, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        scaled.setDevicePixelRatio(devicePixelRatio);
+        QPixmapCache::insert(key, scaled);
+    }
+    return scaled;
+}
+
+QCursor ResourceCache::cursor(CursorShape shape, qreal devicePixelRatio) {
+    // The cursors are few and small: they are kept for the whole run (one per screen resolution), unlike the QPixmapCache entries
+    static QHash<QPair<int, int>, QCursor> cursors;
+    QPair<int, int> key(shape, qRound(devicePixelRatio * 100));
+    auto iter = cursors.find(key);
+    if(iter == cursors.end()) {
+        if(shape == EraserCursor)
+            iter = cursors.insert(key, QCursor(scaledPixmap(":/img/eraser.png", QSize(20, 20), devicePixelRatio), 10, 10));
+        else
+            iter = cursors.insert(key, QCursor(scaledPixmap(":/img/brush.png", QSize(50, 70), devicePixelRatio), 0, 0));
+    }
+    return iter.value();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file   stabilizerPanel.cpp
+ * @date   October 2026
+ *
+ * @brief  stabilizerPanel is the dock panel that let the user choose how the strokes are smoothed (lazy brush, one-euro filter or Catmull-Rom curve)
+ * and how far ahead their tip is predicted, it shows the latency of the draw path
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "stabilizerPanel.h"
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+
+StabilizerPanel::StabilizerPanel(QWidget *parent) : QDockWidget(tr("Stabilizer"), parent) {
+    setObjectName("stabilizerPanel");
+
+    QWidget * content = new QWidget(this);
+    QFormLayout * layout = new QFormLayout(content);
+    StabilizerSettings defaults;
+
+    // The items order follows StabilizerSettings::Mode
+    _modeComboBox = new QComboBox(content);
+    _modeComboBox->addItem(tr("Off"));
+    _modeComboBox->addItem(tr("Lazy brush"));
+    _modeComboBox->addItem(tr("One-euro filter"));
+    _modeComboBox->addItem(tr("Catmull-Rom curve"));
+    layout->addRow(tr("Smoothing"), _modeComboBox);
+
+    _lazyRadiusSpinBox = new QDoubleSpinBox(content);
+    _lazyRadiusSpinBox->setRange(1, 200);
+    _lazyRadiusSpinBox->setSuffix(tr(" px"));
+    _lazyRadiusSpinBox->setValue(defaults.lazyRadius);
+    layout->addRow(tr("Lazy radius"), _lazyRadiusSpinBox);
+
+    _minCutoffSpinBox = new QDoubleSpinBox(content);
+    _minCutoffSpinBox->setRange(0.05, 30);
+    _minCutoffSpinBox->setSingleStep(0.1);
+    _minCutoffSpinBox->setSuffix(tr(" Hz"));
+    _minCutoffSpinBox->setValue(defaults.minCutoff);
+    layout->addRow(tr("Minimum cutoff"), _minCutoffSpinBox);
+
+    _betaSpinBox = new QDoubleSpinBox(content);
+    _betaSpinBox->setRange(0, 1);
+    _betaSpinBox->setDecimals(3);
+    _betaSpinBox->setSingleStep(0.005);
+    _betaSpinBox->setValue(defaults.beta);
+    layout->addRow(tr("Speed coefficient"), _betaSpinBox);
+
+    _predictionSpinBox = new QSpinBox(content);
+    _predictionSpinBox->setRange(0, 60);
+    _predictionSpinBox->setSuffix(tr(" ms"));
+    _predictionSpinBox->setValue(defaults.predictionTime);
+    layout->addRow(tr("Tip prediction"), _predictionSpinBox);
+
+    _inputLatencyLabel = new QLabel(content);
+    _inputLatencyLabel->setWordWrap(true);
+    layout->addRow(tr("Input to frame"), _inputLatencyLabel);
+
+    _tipLatencyLabel = new QLabel(content);
+    _tipLatencyLabel->setWordWrap(true);
+    layout->addRow(tr("Tip behind mouse"), _tipLatencyLabel);
+
+    QPushButton * resetButton = new QPushButton(tr("Reset Measures"), content);
+    layout->addRow(resetButton);
+
+    setWidget(content);
+
+    connect(_modeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(emitStabilizerChanged()));
+    connect(_lazyRadiusSpinBox, SIGNAL(valueChanged(double)), this, SLOT(emitStabilizerChanged()));
+    connect(_minCutoffSpinBox, SIGNAL(valueChanged(double)), this, SLOT(emitStabilizerChanged()));
+    connect(_betaSpinBox, SIGNAL(valueChanged(double)), this, SLOT(emitStabilizerChanged()));
+    connect(_predictionSpinBox, SIGNAL(valueChanged(int)), this, SLOT(emitStabilizerChanged()));
+    connect(resetButton, SIGNAL(clicked()), this, SIGNAL(latencyResetRequested()));
+}
+
+StabilizerSettings StabilizerPanel::settings() const {
+    StabilizerSettings settings;
+    settings.mode = StabilizerSettings::Mode(_modeComboBox->currentIndex());
+    settings.lazyRadius = _lazyRadiusSpinBox->value();
+    settings.minCutoff = _minCutoffSpinBox->value();
+    settings.beta = _betaSpinBox->value();
+    settings.predictionTime = _predictionSpinBox->value();
+    return settings;
+}
+
+void StabilizerPanel::showLatency(const QString & inputLatency, const QString & tipLatency) {
+    _inputLatencyLabel->setText(inputLatency);
+    _tipLatencyLabel->setText(tipLatency);
+}
+
+void StabilizerPanel::emitStabilizerChanged() {
+    emit stabilizerChanged(settings());
+}
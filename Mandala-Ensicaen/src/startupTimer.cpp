@@ -0,0 +1,52 @@
+/**
+ * @file   startupTimer.cpp
+ * @date   October 2026
+ *
+ * @brief  startupTimer measures the startup of the application (--startup-timing): it prints the time of each startup phase until the first frame, then quits
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "startupTimer.h"
+#include <QCoreApplication>
+#include <QEvent>
+#include <QTextStream>
+#include <QTimer>
+#include <QWidget>
+
+StartupTimer::StartupTimer(const QElapsedTimer & clock, QObject *parent) : QObject(parent), _clock(clock) {
+}
+
+void StartupTimer::mark(const QString & phase) {
+    _phases.push_back(qMakePair(phase, _clock.nsecsElapsed()));
+}
+
+void StartupTimer::watchFirstFrame(QWidget * window) {
+    window->installEventFilter(this);
+}
+
+bool StartupTimer::eventFilter(QObject * watched, QEvent * event) {
+    if(event->type() == QEvent::Paint && !_firstFramePainted) {
+        _firstFramePainted = true;
+        watched->removeEventFilter(this);
+        // The children of the window are painted in the same frame: the frame is done when we are back in the event loop
+        QTimer::singleShot(0, this, SLOT(firstFrameDone()));
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void StartupTimer::firstFrameDone() {
+    mark("first frame");
+
+    QTextStream out(stdout);
+    qint64 previous = 0;
+    for(auto iter = _phases.begin(); iter != _phases.end(); ++iter) {
+        out << QString("%1 %2 ms (at %3 ms)\n").arg(iter->first, -16).arg((iter->second - previous) / 1e6, 8, 'f', 2).arg(iter->second / 1e6, 8, 'f', 2);
+        previous = iter->second;
+    }
+    out.flush();
+
+    QCoreApplication::quit();
+}
@@ -0,0 +1,189 @@
+/**
+ * @file   strokeDocument.cpp
+ * @date   October 2026
+ *
+ * @brief  strokeDocument keeps the strokes of a mandala as the user drew them (before the symmetry): the whole drawing can be projected again
+ * with other slices, mirror or colors. It is a value (the containers are implicitly shared), so the history keeps a copy of it at each step
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "strokeDocument.h"
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <math.h>
+
+const int StrokeDocument::ProjectionChunk = 4096;
+const int StrokeDocument::IndexCell = 64;
+
+StrokeDocument::StrokeDocument() {
+}
+
+StrokeDocument::StrokeDocument(const QImage & base) : _base(base) {
+}
+
+void StrokeDocument::addStroke(int layer, int penWidth, const DocumentStroke & stroke, const QVector<QLineF> & lines) {
+    if(lines.isEmpty())
+        return;
+
+    int index = _strokes.size();
+    DocumentBatch & batch = batchFor(layer, penWidth, true);
+    DocumentStroke added = stroke;
+    added.batch = _batches.size() - 1;
+    added.first = batch.lines.size();
+    added.count = lines.size();
+    added.transform = QTransform();
+    added.bounds = MandalaRasterizer::segmentBounds(lines.first(), penWidth);
+    for(auto iter = lines.begin() + 1; iter != lines.end(); ++iter)
+        added.bounds |= MandalaRasterizer::segmentBounds(*iter, penWidth);
+    _strokes.push_back(added);
+    batch.lines += lines;
+    batch.strokes.insert(batch.strokes.end(), lines.size(), index);
+    indexStroke(index, true);
+}
+
+void StrokeDocument::addFixedStroke(int layer, int penWidth, const QVector<MandalaSegment> & segments) {
+    if(!segments.isEmpty())
+        batchFor(layer, penWidth, false).segments += segments;
+}
+
+const QImage & StrokeDocument::base() const {
+    return _base;
+}
+
+const QVector<DocumentStroke> & StrokeDocument::strokes() const {
+    return _strokes;
+}
+
+const QVector<StrokeDocument::DocumentBatch> & StrokeDocument::batches() const {
+    return _batches;
+}
+
+bool StrokeDocument::hasSymmetricStrokes() const {
+    return !_strokes.isEmpty();
+}
+
+QVector<QLineF> StrokeDocument::strokeLines(int index) const {
+    const DocumentStroke & stroke = _strokes[index];
+    return _batches[stroke.batch].lines.mid(stroke.first, stroke.count);
+}
+
+int StrokeDocument::strokeAt(QPointF point, qreal distance) const {
+    auto iter = _index.constFind(qMakePair(int(floor(point.x() / IndexCell)), int(floor(point.y() / IndexCell))));
+    if(iter == _index.constEnd())
+        return -1;
+
+    // The cells hold the strokes in the order they were drawn: the last one drawn is on top
+    const QVector<int> & candidates = iter.value();
+    for(int i=candidates.size()-1; i>=0; --i) {
+        const DocumentStroke & stroke = _strokes[candidates[i]];
+        if(!stroke.bounds.adjusted(-distance, -distance, distance, distance).contains(point))
+            continue;
+
+        // The point is brought back before the transform of the stroke, the distance to its lines is measured in the drawn geometry
+        const DocumentBatch & batch = _batches[stroke.batch];
+        QTransform inverse = stroke.transform.inverted();
+        QPointF local = inverse.map(point);
+        qreal scale = sqrt(qAbs(inverse.determinant()));
+        qreal reach = (batch.penWidth / 2.0 + distance) * scale;
+        for(int j=stroke.first; j<stroke.first+stroke.count; ++j) {
+            const QLineF & line = batch.lines[j];
+            QPointF d = line.p2() - line.p1();
+            qreal length = d.x() * d.x() + d.y() * d.y();
+            qreal t = length > 0 ? qBound(0.0, QPointF::dotProduct(local - line.p1(), d) / length, 1.0) : 0;
+            if(QLineF(local, line.p1() + t * d).length() <= reach)
+                return candidates[i];
+        }
+    }
+    return -1;
+}
+
+void StrokeDocument::setStrokeTransform(int index, const QTransform & transform) {
+    indexStroke(index, false);
+    DocumentStroke & stroke = _strokes[index];
+    const DocumentBatch & batch = _batches[stroke.batch];
+    stroke.transform = transform;
+    stroke.bounds = QRectF();
+    for(int i=stroke.first; i<stroke.first+stroke.count; ++i)
+        stroke.bounds |= MandalaRasterizer::segmentBounds(transform.map(batch.lines[i]), batch.penWidth);
+    indexStroke(index, true);
+}
+
+void StrokeDocument::setStrokeColor(int index, QRgb color) {
+    _strokes[index].color = color;
+}
+
+qint64 StrokeDocument::byteCount() const {
+    qint64 bytes = _strokes.size() * sizeof(DocumentStroke);
+    for(auto iter = _batches.begin(); iter != _batches.end(); ++iter)
+        bytes += iter->lines.size() * (sizeof(QLineF) + sizeof(int)) + iter->segments.size() * sizeof(MandalaSegment);
+    for(auto iter = _index.begin(); iter != _index.end(); ++iter)
+        bytes += iter->size() * sizeof(int);
+    return bytes;
+}
+
+QVector<MandalaSegment> StrokeDocument::project(int index, const SymmetryEngine & symmetry, const QVector<ColorEngine> & colors, int hiddenStroke) const {
+    const DocumentBatch & batch = _batches[index];
+    if(!batch.symmetric)
+        return batch.segments;
+
+    // Each chunk is projected in its own vector: the chunks are joined in order, so the segments keep the order in which the lines were drawn
+    int chunkCount = (batch.lines.size() + ProjectionChunk - 1) / ProjectionChunk;
+    QVector<int> chunks;
+    for(int i=0; i<chunkCount; ++i)
+        chunks.push_back(i);
+    QVector<QVector<MandalaSegment>> projected(chunkCount);
+    QtConcurrent::blockingMap(chunks, [&](int chunk) {
+        int first = chunk * ProjectionChunk, last = qMin(batch.lines.size(), first + ProjectionChunk);
+        QVector<MandalaSegment> & segments = projected[chunk];
+        segments.reserve((last - first) * symmetry.copyCount());
+        for(int i=first; i<last; ++i) {
+            if(batch.strokes[i] == hiddenStroke)
+                continue;
+            const DocumentStroke & stroke = _strokes[batch.strokes[i]];
+            const QLineF & line = batch.lines[i];
+            symmetry.apply(stroke.transform.isIdentity() ? line : stroke.transform.map(line), stroke.color,
+                           colors.isEmpty() ? nullptr : &colors[batch.strokes[i]], segments);
+        }
+    });
+
+    int size = 0;
+    for(auto iter = projected.begin(); iter != projected.end(); ++iter)
+        size += iter->size();
+    QVector<MandalaSegment> segments;
+    segments.reserve(size);
+    for(auto iter = projected.begin(); iter != projected.end(); ++iter)
+        segments += *iter;
+    return segments;
+}
+
+void StrokeDocument::indexStroke(int index, bool added) {
+    const QRectF & bounds = _strokes[index].bounds;
+    int left = int(floor(bounds.left() / IndexCell)), right = int(floor(bounds.right() / IndexCell));
+    int top = int(floor(bounds.top() / IndexCell)), bottom = int(floor(bounds.bottom() / IndexCell));
+    for(int x=left; x<=right; ++x) {
+        for(int y=top; y<=bottom; ++y) {
+            QPair<int, int> cell = qMakePair(x, y);
+            if(added) {
+                // A stroke that was edited goes back in its place: the cells stay sorted in the order the strokes were drawn
+                QVector<int> & candidates = _index[cell];
+                candidates.insert(std::lower_bound(candidates.begin(), candidates.end(), index), index);
+            } else {
+                auto iter = _index.find(cell);
+                if(iter == _index.end())
+                    continue;
+                iter->removeOne(index);
+                if(iter->isEmpty())
+                    _index.erase(iter);
+            }
+        }
+    }
+}
+
+StrokeDocument::DocumentBatch & StrokeDocument::batchFor(int layer, int penWidth, bool symmetric) {
+    if(_batches.isEmpty() || _batches.last().layer != layer || _batches.last().penWidth != penWidth || _batches.last().symmetric != symmetric)
+        _batches.push_back({layer, penWidth, symmetric, QVector<QLineF>(), QVector<int>(), QVector<MandalaSegment>()});
+    return _batches.last();
+}
@@ -0,0 +1,74 @@
+/**
+ * @file   strokeInstanceItem.cpp
+ * @date   October 2026
+ *
+ * @brief  strokeInstanceItem is the QGraphicsItem of a stroke being edited: its symmetrical copies are instances of one geometry (the drawn lines)
+ * drawn through the transforms of the symmetry group, so moving, scaling or recoloring the stroke never touches its copies one by one
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "strokeInstanceItem.h"
+#include "mandalaRasterizer.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+StrokeInstanceItem::StrokeInstanceItem(const QVector<QLineF> & lines, int penWidth) : _lines(lines), _penWidth(penWidth) {
+    // The exposed rectangle lets paint() skip the copies outside of it
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setEditTransform(QTransform());
+}
+
+void StrokeInstanceItem::setEditTransform(const QTransform & editTransform) {
+    _editTransform = editTransform;
+    _editedLines.resize(_lines.size());
+    _editedBounds = QRectF();
+    for(int i=0; i<_lines.size(); ++i) {
+        _editedLines[i] = editTransform.map(_lines[i]);
+        _editedBounds |= MandalaRasterizer::segmentBounds(_editedLines[i], _penWidth);
+    }
+    updateBounds();
+}
+
+const QTransform & StrokeInstanceItem::editTransform() const {
+    return _editTransform;
+}
+
+void StrokeInstanceItem::setInstances(const QVector<StrokeInstance> & instances) {
+    _instances = instances;
+    updateBounds();
+}
+
+const QVector<StrokeInstance> & StrokeInstanceItem::instances() const {
+    return _instances;
+}
+
+QRectF StrokeInstanceItem::sourceBounds() const {
+    return _editedBounds;
+}
+
+QRectF StrokeInstanceItem::boundingRect() const {
+    return _bounds;
+}
+
+void StrokeInstanceItem::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget *) {
+    // The symmetry group is made of isometries: the pen width is the same in every copy, it is not changed by the transform of the painter
+    QTransform world = painter->transform();
+    for(auto iter = _instances.begin(); iter != _instances.end(); ++iter) {
+        if(!iter->transform.mapRect(_editedBounds).intersects(option->exposedRect))
+            continue;
+        painter->setTransform(iter->transform * world);
+        painter->setPen(QPen(QBrush(QColor::fromRgba(iter->color)), _penWidth, Qt::SolidLine, Qt::RoundCap));
+        painter->drawLines(_editedLines);
+    }
+    painter->setTransform(world);
+}
+
+void StrokeInstanceItem::updateBounds() {
+    prepareGeometryChange();
+    _bounds = QRectF();
+    for(auto iter = _instances.begin(); iter != _instances.end(); ++iter)
+        _bounds |= iter->transform.mapRect(_editedBounds);
+}
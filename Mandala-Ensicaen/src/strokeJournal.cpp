@@ -0,0 +1,313 @@
+/**
+ * @file   strokeJournal.cpp
+ * @date   October 2026
+ *
+ * @brief  strokeJournal is the crash-safe autosave of a mandala: each finished stroke is appended to a journal file (buffered writes, synced to the disk
+ * on a time or size budget), and the journal is compacted in the background into a snapshot image followed by a new journal.
+ * Every open document has its own journal directory, so all of them are recovered after a crash
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "strokeJournal.h"
+#include <QDataStream>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUuid>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+const qint64 StrokeJournal::SyncBytes = 256 * 1024;
+const int StrokeJournal::SyncInterval = 1000;
+const qint64 StrokeJournal::CompactionBytes = 8 * 1024 * 1024;
+
+namespace {
+    // A journal file is a header followed by records: the size and the checksum of the record, then the stroke
+    const quint32 JournalMagic = 0x4D4A524E;
+    const quint16 JournalVersion = 1;
+    // A stroke record is its layer, its pen width and its segment count, then each segment: its points and its color
+    const int StrokeHeaderBytes = 12;
+    const int SegmentBytes = 36;
+
+    struct JournalHeader {
+        int generation;
+        QSize canvasSize;
+        bool hasBase;
+    };
+
+    bool readHeader(QDataStream & stream, JournalHeader & header) {
+        quint32 magic;
+        quint16 version;
+        qint32 generation, width, height;
+        bool hasBase;
+        stream >> magic >> version >> generation >> width >> height >> hasBase;
+        if(stream.status() != QDataStream::Ok || magic != JournalMagic || version != JournalVersion)
+            return false;
+        header = {generation, QSize(width, height), hasBase};
+        return true;
+    }
+
+    bool readHeader(const QString & path, JournalHeader & header) {
+        QFile file(path);
+        if(!file.open(QIODevice::ReadOnly))
+            return false;
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_0);
+        return readHeader(stream, header);
+    }
+}
+
+StrokeJournal::StrokeJournal(QObject *parent) : QObject(parent), _directory(newDirectory()) {
+    _compactionPool.setMaxThreadCount(1);
+    _syncTimer.setSingleShot(true);
+    connect(&_syncTimer, SIGNAL(timeout()), this, SLOT(sync()));
+}
+
+StrokeJournal::~StrokeJournal() {
+    // The journal files are kept: if we didn't discard them, they will be recovered at the next start
+    sync();
+    _compactionPool.waitForDone();
+}
+
+QString StrokeJournal::defaultDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/journal";
+}
+
+QString StrokeJournal::newDirectory() {
+    // A document opened in another instance of the application never gets the same directory
+    return defaultDirectory() + "/" + QUuid::createUuid().toString().mid(1, 36);
+}
+
+void StrokeJournal::setDirectory(const QString & directory) {
+    _directory = directory;
+}
+
+QString StrokeJournal::directory() const {
+    return _directory;
+}
+
+bool StrokeJournal::isOpen() const {
+    return _file.isOpen();
+}
+
+void StrokeJournal::start(QSize canvasSize, const QImage & base) {
+    // The generations already on the disk (a recovered journal, or the one of a document coming back to the view) are kept until the new one
+    // has its snapshot: a crash meanwhile recovers them
+    close();
+    QList<int> previous = generations(_directory);
+    _canvasSize = canvasSize;
+    _generation = previous.isEmpty() ? 0 : previous.last();
+    openGeneration(base);
+}
+
+void StrokeJournal::appendStroke(int layer, int penWidth, const QVector<MandalaSegment> & segments) {
+    if(!_file.isOpen() || segments.isEmpty())
+        return;
+
+    QByteArray record;
+    record.reserve(StrokeHeaderBytes + segments.size() * SegmentBytes);
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << qint32(layer) << qint32(penWidth) << quint32(segments.size());
+    for(auto iter = segments.begin(); iter != segments.end(); ++iter)
+        stream << iter->line.x1() << iter->line.y1() << iter->line.x2() << iter->line.y2() << quint32(iter->color);
+
+    // The checksum let us drop a record that was half written when the application crashed
+    QDataStream file(&_file);
+    file.setVersion(QDataStream::Qt_5_0);
+    file << quint32(record.size()) << qChecksum(record.constData(), record.size());
+    file.writeRawData(record.constData(), record.size());
+
+    qint64 written = record.size() + 6;
+    _unsyncedBytes += written;
+    _journalBytes += written;
+    if(_unsyncedBytes >= SyncBytes)
+        sync();
+    else if(!_syncTimer.isActive())
+        _syncTimer.start(SyncInterval);
+}
+
+void StrokeJournal::rebase(const QImage & base) {
+    if(_file.isOpen())
+        openGeneration(base);
+}
+
+bool StrokeJournal::needsCompaction() const {
+    return _journalBytes >= CompactionBytes;
+}
+
+void StrokeJournal::discard() {
+    _syncTimer.stop();
+    if(_file.isOpen())
+        _file.close();
+    _unsyncedBytes = 0;
+    _journalBytes = 0;
+    _compactionPool.waitForDone();
+    QDir(_directory).removeRecursively();
+}
+
+void StrokeJournal::close() {
+    sync();
+    if(_file.isOpen())
+        _file.close();
+    _unsyncedBytes = 0;
+    _journalBytes = 0;
+    _compactionPool.waitForDone();
+}
+
+void StrokeJournal::sync() {
+    _syncTimer.stop();
+    if(!_file.isOpen() || _unsyncedBytes == 0)
+        return;
+
+    _file.flush();
+#ifdef Q_OS_WIN
+    _commit(_file.handle());
+#else
+    fsync(_file.handle());
+#endif
+    _unsyncedBytes = 0;
+}
+
+void StrokeJournal::openGeneration(const QImage & base) {
+    if(_file.isOpen()) {
+        sync();
+        _file.close();
+    }
+
+    ++_generation;
+    QDir().mkpath(_directory);
+    _file.setFileName(journalPath(_directory, _generation));
+    if(!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        emit failed(tr("Can't open the journal %1: %2").arg(_file.fileName(), _file.errorString()));
+        return;
+    }
+
+    QDataStream stream(&_file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << JournalMagic << JournalVersion << qint32(_generation) << qint32(_canvasSize.width()) << qint32(_canvasSize.height()) << !base.isNull();
+    _journalBytes = 0;
+    _unsyncedBytes = 1;
+    sync();
+
+    // Until the snapshot is written, the previous generation is still there: a crash meanwhile recovers it followed by the new journal
+    QString directory = _directory;
+    int generation = _generation;
+    // The journal waits for its compaction pool before it is destroyed: the worker may report a failure through it
+    QtConcurrent::run(&_compactionPool, [this, directory, generation, base]() {
+        if(!base.isNull()) {
+            QSaveFile file(snapshotPath(directory, generation));
+            if(!file.open(QIODevice::WriteOnly) || !base.save(&file, "PNG") || !file.commit()) {
+                emit failed(tr("Can't write the journal snapshot %1: %2").arg(file.fileName(), file.errorString()));
+                return;
+            }
+        }
+        QList<int> previous = generations(directory);
+        for(auto iter = previous.begin(); iter != previous.end() && *iter < generation; ++iter) {
+            QFile::remove(journalPath(directory, *iter));
+            QFile::remove(snapshotPath(directory, *iter));
+        }
+    });
+}
+
+JournalRecovery StrokeJournal::recover(const QString & directory) {
+    JournalRecovery recovery;
+    recovery.directory = directory;
+    QList<int> journals = generations(directory);
+
+    // We start from the newest generation whose snapshot was written (or that doesn't need one)
+    int first = -1;
+    JournalHeader header;
+    for(int i=journals.size()-1; i>=0 && first < 0; --i)
+        if(readHeader(journalPath(directory, journals[i]), header) && (!header.hasBase || QFile::exists(snapshotPath(directory, journals[i]))))
+            first = i;
+    if(first < 0)
+        return recovery;
+
+    for(int i=first; i<journals.size(); ++i) {
+        QFile file(journalPath(directory, journals[i]));
+        if(!file.open(QIODevice::ReadOnly))
+            break;
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_0);
+        if(!readHeader(stream, header))
+            break;
+
+        if(i == first) {
+            recovery.canvasSize = header.canvasSize;
+            if(header.hasBase)
+                recovery.base = QImage(snapshotPath(directory, journals[i]));
+        }
+
+        forever {
+            quint32 size;
+            quint16 checksum;
+            stream >> size >> checksum;
+            if(stream.status() != QDataStream::Ok || file.bytesAvailable() < size)
+                break;
+            QByteArray record = file.read(size);
+            if(qChecksum(record.constData(), record.size()) != checksum)
+                break;
+
+            QDataStream recordStream(record);
+            recordStream.setVersion(QDataStream::Qt_5_0);
+            qint32 layer, penWidth;
+            quint32 count;
+            recordStream >> layer >> penWidth >> count;
+            // The checksum is short: a count that doesn't fill the record exactly is a torn record, not an allocation to make
+            if(record.size() < StrokeHeaderBytes || count != quint32(record.size() - StrokeHeaderBytes) / SegmentBytes
+                    || (record.size() - StrokeHeaderBytes) % SegmentBytes != 0)
+                break;
+
+            JournalStroke stroke = {layer, penWidth, QVector<MandalaSegment>()};
+            stroke.segments.reserve(int(count));
+            for(quint32 j=0; j<count; ++j) {
+                double x1, y1, x2, y2;
+                quint32 color;
+                recordStream >> x1 >> y1 >> x2 >> y2 >> color;
+                stroke.segments.push_back({QLineF(x1, y1, x2, y2), QRgb(color)});
+            }
+            if(recordStream.status() != QDataStream::Ok)
+                break;
+            recovery.strokes.push_back(stroke);
+        }
+    }
+    return recovery;
+}
+
+QVector<JournalRecovery> StrokeJournal::recoverAll(const QString & directory) {
+    QVector<JournalRecovery> recoveries;
+    QStringList documents = QDir(directory).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    for(auto iter = documents.begin(); iter != documents.end(); ++iter)
+        recoveries.push_back(recover(QDir(directory).filePath(*iter)));
+    return recoveries;
+}
+
+QString StrokeJournal::journalPath(const QString & directory, int generation) {
+    return directory + QString("/journal-%1.log").arg(generation);
+}
+
+QString StrokeJournal::snapshotPath(const QString & directory, int generation) {
+    return directory + QString("/snapshot-%1.png").arg(generation);
+}
+
+QList<int> StrokeJournal::generations(const QString & directory) {
+    QList<int> result;
+    QStringList files = QDir(directory).entryList(QStringList() << "journal-*.log", QDir::Files);
+    for(auto iter = files.begin(); iter != files.end(); ++iter) {
+        bool ok;
+        int generation = iter->mid(8, iter->size() - 12).toInt(&ok);
+        if(ok)
+            result.push_back(generation);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
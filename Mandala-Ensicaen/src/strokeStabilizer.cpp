@@ -0,0 +1,150 @@
+/**
+ * @file   strokeStabilizer.cpp
+ * @date   October 2026
+ *
+ * @brief  strokeStabilizer filters the mouse positions of a stroke before the symmetry copies them (lazy brush, one-euro filter or Catmull-Rom curve),
+ * and predicts where the stroke tip will be a few milliseconds ahead, so that the smoothing doesn't feel late
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "strokeStabilizer.h"
+#include <QLineF>
+#include <math.h>
+
+namespace {
+    // The speed is smoothed with this factor, so that a single jittery position doesn't throw the prediction away
+    const double VelocitySmoothing = 0.35;
+
+    // The one-euro filter smooths its speed estimate with a fixed 1 Hz cutoff
+    const double DerivativeCutoff = 1.0;
+
+    // A Catmull-Rom segment gets a point every CurveSpacing pixels, at most MaximumCurvePoints points
+    const double CurveSpacing = 3.0;
+    const int MaximumCurvePoints = 16;
+}
+
+StrokeStabilizer::StrokeStabilizer() {
+}
+
+void StrokeStabilizer::setSettings(const StabilizerSettings & settings) {
+    _settings = settings;
+}
+
+const StabilizerSettings & StrokeStabilizer::settings() const {
+    return _settings;
+}
+
+void StrokeStabilizer::begin(QPointF position, double time) {
+    _lastPosition = position;
+    _lastTime = time;
+    _velocity = QPointF();
+    _brush = position;
+    _derivative = QPointF();
+    _controlPoints.clear();
+    // The curve starts at the first position: it is its own previous control point
+    _controlPoints << position << position;
+}
+
+QVector<QPointF> StrokeStabilizer::addPoint(QPointF position, double time) {
+    double elapsed = qMax(1.0, time - _lastTime);
+    QPointF velocity = (position - _lastPosition) / elapsed;
+    _velocity += VelocitySmoothing * (velocity - _velocity);
+    _lastPosition = position;
+    _lastTime = time;
+
+    QVector<QPointF> points;
+    switch(_settings.mode) {
+    case StabilizerSettings::Off:
+        points << position;
+        break;
+    case StabilizerSettings::LazyBrush: {
+        // The brush only moves when the mouse pulls the string tight, the jitter within the string length is dropped
+        QLineF string(_brush, position);
+        if(string.length() > _settings.lazyRadius) {
+            string.setLength(string.length() - _settings.lazyRadius);
+            _brush = string.p2();
+            points << _brush;
+        }
+        break;
+    }
+    case StabilizerSettings::OneEuro: {
+        // The cutoff frequency goes up with the speed: slow strokes are smoothed, fast strokes follow the mouse
+        double derivativeFactor = smoothingFactor(DerivativeCutoff, elapsed);
+        _derivative += derivativeFactor * (velocity * 1000 - _derivative);
+        double speed = sqrt(_derivative.x() * _derivative.x() + _derivative.y() * _derivative.y());
+        double factor = smoothingFactor(_settings.minCutoff + _settings.beta * speed, elapsed);
+        _brush += factor * (position - _brush);
+        points << _brush;
+        break;
+    }
+    case StabilizerSettings::CatmullRom:
+        // A segment of the curve is known once we have the position after its end
+        _controlPoints << position;
+        if(_controlPoints.size() > 4)
+            _controlPoints.remove(0);
+        if(_controlPoints.size() == 4)
+            appendCurve(points);
+        break;
+    }
+    return points;
+}
+
+QVector<QPointF> StrokeStabilizer::end() {
+    QVector<QPointF> points;
+    switch(_settings.mode) {
+    case StabilizerSettings::Off:
+        break;
+    case StabilizerSettings::LazyBrush:
+    case StabilizerSettings::OneEuro:
+        if(_brush != _lastPosition)
+            points << _lastPosition;
+        _brush = _lastPosition;
+        break;
+    case StabilizerSettings::CatmullRom:
+        // The last segment ends at the last position, which is its own next control point
+        _controlPoints << _lastPosition;
+        while(_controlPoints.size() > 4)
+            _controlPoints.remove(0);
+        if(_controlPoints.size() == 4)
+            appendCurve(points);
+        _controlPoints.clear();
+        break;
+    }
+    return points;
+}
+
+QPointF StrokeStabilizer::lastPosition() const {
+    return _lastPosition;
+}
+
+QPointF StrokeStabilizer::velocity() const {
+    return _velocity;
+}
+
+QPointF StrokeStabilizer::predictedTip() const {
+    return _lastPosition + _velocity * _settings.predictionTime;
+}
+
+double StrokeStabilizer::smoothingFactor(double cutoff, double elapsed) {
+    double tau = 1000.0 / (2 * M_PI * cutoff);
+    return 1.0 / (1.0 + tau / elapsed);
+}
+
+void StrokeStabilizer::appendCurve(QVector<QPointF> & points) const {
+    const QPointF & p0 = _controlPoints[0];
+    const QPointF & p1 = _controlPoints[1];
+    const QPointF & p2 = _controlPoints[2];
+    const QPointF & p3 = _controlPoints[3];
+    if(p1 == p2)
+        return;
+
+    int count = qBound(1, int(QLineF(p1, p2).length() / CurveSpacing), MaximumCurvePoints);
+    for(int i=1; i<=count; ++i) {
+        double t = double(i) / count;
+        double t2 = t * t, t3 = t2 * t;
+        points << 0.5 * ((2 * p1) + (p2 - p0) * t + (2*p0 - 5*p1 + 4*p2 - p3) * t2 + (3*p1 - p0 - 3*p2 + p3) * t3);
+    }
+}
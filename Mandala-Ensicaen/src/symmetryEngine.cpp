@@ -0,0 +1,454 @@
+/**
+ * @file   symmetryEngine.cpp
+ * @date   October 2026
+ *
+ * @brief  symmetryEngine gives the symmetrical copies of a drawn line: the dihedral group D_N (N rotations and a mirror of any axis), the 17 wallpaper groups
+ * (seamless tiles) and multi-center kaleidoscopes. Each group is a precomputed list of affine transforms applied to the lines in one batch
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "symmetryEngine.h"
+#include "colorEngine.h"
+#include "mandalaGenerator.h"
+#include <QElapsedTimer>
+#include <math.h>
+
+namespace {
+    // LatticeOperation maps the lattice coordinates (x, y) to (a*x + b*y + tx, c*x + d*y + ty)
+    struct LatticeOperation {
+        int a, b, c, d;
+        double tx, ty;
+    };
+
+    const LatticeOperation Identity = {1, 0, 0, 1, 0, 0};
+    const LatticeOperation HalfTurn = {-1, 0, 0, -1, 0, 0};
+    const LatticeOperation MirrorX = {-1, 0, 0, 1, 0, 0};
+    const LatticeOperation MirrorY = {1, 0, 0, -1, 0, 0};
+    const LatticeOperation QuarterTurn = {0, -1, 1, 0, 0, 0};
+    const LatticeOperation ThreeQuarterTurn = {0, 1, -1, 0, 0, 0};
+    const LatticeOperation Diagonal = {0, 1, 1, 0, 0, 0};
+    const LatticeOperation AntiDiagonal = {0, -1, -1, 0, 0, 0};
+    const LatticeOperation ThirdTurn = {0, -1, 1, -1, 0, 0};
+    const LatticeOperation TwoThirdsTurn = {-1, 1, -1, 0, 0, 0};
+    const LatticeOperation SixthTurn = {1, -1, 1, 0, 0, 0};
+    const LatticeOperation FiveSixthsTurn = {0, 1, -1, 1, 0, 0};
+
+    LatticeOperation shifted(LatticeOperation operation, double tx, double ty) {
+        operation.tx += tx;
+        operation.ty += ty;
+        return operation;
+    }
+
+    // The general positions of the wallpaper groups (International Tables for Crystallography), and the basis of their lattice (in cells)
+    QVector<LatticeOperation> wallpaperOperations(SymmetrySettings::WallpaperGroup group, QPointF & a, QPointF & b) {
+        QVector<LatticeOperation> operations;
+        a = QPointF(1, 0);
+        b = QPointF(0, 0.75);
+        switch(group) {
+        case SymmetrySettings::P1:
+            b = QPointF(0.25, 0.9);
+            operations << Identity;
+            break;
+        case SymmetrySettings::P2:
+            b = QPointF(0.25, 0.9);
+            operations << Identity << HalfTurn;
+            break;
+        case SymmetrySettings::PM:
+            operations << Identity << MirrorX;
+            break;
+        case SymmetrySettings::PG:
+            operations << Identity << shifted(MirrorX, 0, 0.5);
+            break;
+        case SymmetrySettings::CM:
+            operations << Identity << MirrorX << shifted(Identity, 0.5, 0.5) << shifted(MirrorX, 0.5, 0.5);
+            break;
+        case SymmetrySettings::PMM:
+            operations << Identity << HalfTurn << MirrorX << MirrorY;
+            break;
+        case SymmetrySettings::PMG:
+            operations << Identity << HalfTurn << shifted(MirrorX, 0.5, 0) << shifted(MirrorY, 0.5, 0);
+            break;
+        case SymmetrySettings::PGG:
+            operations << Identity << HalfTurn << shifted(MirrorX, 0.5, 0.5) << shifted(MirrorY, 0.5, 0.5);
+            break;
+        case SymmetrySettings::CMM:
+            operations << Identity << HalfTurn << MirrorX << MirrorY
+                       << shifted(Identity, 0.5, 0.5) << shifted(HalfTurn, 0.5, 0.5) << shifted(MirrorX, 0.5, 0.5) << shifted(MirrorY, 0.5, 0.5);
+            break;
+        case SymmetrySettings::P4:
+            b = QPointF(0, 1);
+            operations << Identity << HalfTurn << QuarterTurn << ThreeQuarterTurn;
+            break;
+        case SymmetrySettings::P4M:
+            b = QPointF(0, 1);
+            operations << Identity << HalfTurn << QuarterTurn << ThreeQuarterTurn << MirrorX << MirrorY << Diagonal << AntiDiagonal;
+            break;
+        case SymmetrySettings::P4G:
+            b = QPointF(0, 1);
+            operations << Identity << HalfTurn << QuarterTurn << ThreeQuarterTurn
+                       << shifted(MirrorX, 0.5, 0.5) << shifted(MirrorY, 0.5, 0.5) << shifted(Diagonal, 0.5, 0.5) << shifted(AntiDiagonal, 0.5, 0.5);
+            break;
+        case SymmetrySettings::P3:
+        case SymmetrySettings::P3M1:
+        case SymmetrySettings::P31M:
+        case SymmetrySettings::P6:
+        case SymmetrySettings::P6M: {
+            b = QPointF(-0.5, sqrt(3.0)/2);
+            operations << Identity << ThirdTurn << TwoThirdsTurn;
+            // The mirrors of p3m1 and p31m, in hexagonal lattice coordinates
+            LatticeOperation m1[] = { {0, -1, -1, 0, 0, 0}, {-1, 1, 0, 1, 0, 0}, {1, 0, 1, -1, 0, 0} };
+            LatticeOperation m2[] = { {0, 1, 1, 0, 0, 0}, {1, -1, 0, -1, 0, 0}, {-1, 0, -1, 1, 0, 0} };
+            if(group == SymmetrySettings::P6 || group == SymmetrySettings::P6M)
+                operations << HalfTurn << FiveSixthsTurn << SixthTurn;
+            if(group == SymmetrySettings::P3M1 || group == SymmetrySettings::P6M)
+                operations << m1[0] << m1[1] << m1[2];
+            if(group == SymmetrySettings::P31M || group == SymmetrySettings::P6M)
+                operations << m2[0] << m2[1] << m2[2];
+            break;
+        }
+        }
+        return operations;
+    }
+}
+
+namespace {
+    // The rotations of the specialised slice counts are all multiples of 7.5 degrees (a 48th of a turn):
+    // FirstQuadrant holds their exact cosines from 0 to 90 degrees, the other quadrants are folded on it
+    constexpr double FirstQuadrant[13] = {
+        1.0, 0.99144486137381041, 0.96592582628906829, 0.92387953251128674, 0.86602540378443865, 0.79335334029123517, 0.70710678118654752,
+        0.60876142900872064, 0.5, 0.38268343236508977, 0.25881904510252076, 0.13052619222005159, 0.0
+    };
+
+    constexpr double cos48(int step) {
+        return (step % 48 <= 12) ? FirstQuadrant[step % 48]
+             : (step % 48 <= 24) ? -FirstQuadrant[24 - step % 48]
+             : (step % 48 <= 36) ? -FirstQuadrant[step % 48 - 24]
+             : FirstQuadrant[48 - step % 48];
+    }
+
+    constexpr double sin48(int step) {
+        return cos48(step + 36);
+    }
+
+    // Rotate a vector by Step 48ths of a turn (the rotation of QTransform::rotate(), y going down): the quarter turns are coordinate swaps
+    template<int Step>
+    inline QPointF rotate48(const QPointF & d) {
+        return (Step % 48 == 0) ? d
+             : (Step % 48 == 12) ? QPointF(-d.y(), d.x())
+             : (Step % 48 == 24) ? QPointF(-d.x(), -d.y())
+             : (Step % 48 == 36) ? QPointF(d.y(), -d.x())
+             : QPointF(d.x() * cos48(Step) - d.y() * sin48(Step), d.x() * sin48(Step) + d.y() * cos48(Step));
+    }
+
+    // Reflect a vector with the linear part of the mirror (m11, m12, m21, m22 as in QTransform)
+    inline QPointF reflect(const QPointF & d, const qreal * mirror) {
+        return QPointF(mirror[0] * d.x() + mirror[2] * d.y(), mirror[1] * d.x() + mirror[3] * d.y());
+    }
+
+    // DihedralUnroll writes the copies of the rotation I, then the next rotations: the loop over the slices is unrolled at compile time,
+    // in the order of SymmetryEngine::appendDihedral() (each rotation followed by its mirror)
+    template<int N, int I>
+    struct DihedralUnroll {
+        static inline void apply(QPointF d1, QPointF d2, QPointF center, const qreal * mirror, QRgb color, const ColorEngine * colors, double distance, MandalaSegment *& out) {
+            QPointF r1 = rotate48<I * 48 / N>(d1), r2 = rotate48<I * 48 / N>(d2);
+            QRgb copyColor = colors ? colors->color(I, distance) : color;
+            *out++ = {QLineF(center + r1, center + r2), copyColor};
+            if(mirror)
+                *out++ = {QLineF(center + reflect(r1, mirror), center + reflect(r2, mirror)), copyColor};
+            DihedralUnroll<N, I + 1>::apply(d1, d2, center, mirror, color, colors, distance, out);
+        }
+    };
+
+    template<int N>
+    struct DihedralUnroll<N, N> {
+        static inline void apply(QPointF, QPointF, QPointF, const qreal *, QRgb, const ColorEngine *, double, MandalaSegment *&) {
+        }
+    };
+
+    template<int N>
+    void dihedralCopies(const QLineF & line, QPointF center, const qreal * mirror, QRgb color, const ColorEngine * colors, double distance, QVector<MandalaSegment> & segments) {
+        static_assert(48 % N == 0, "the rotations must be multiples of 7.5 degrees");
+        int first = segments.size();
+        segments.resize(first + (mirror ? 2*N : N));
+        MandalaSegment * out = segments.data() + first;
+        DihedralUnroll<N, 0>::apply(line.p1() - center, line.p2() - center, center, mirror, color, colors, distance, out);
+    }
+
+    // The dispatch table of the specialised kernels, the other slice counts go through the generic transforms
+    struct KernelEntry {
+        int slices;
+        SymmetryEngine::DihedralKernel kernel;
+    };
+
+    const KernelEntry Kernels[] = {
+        {4, &dihedralCopies<4>}, {6, &dihedralCopies<6>}, {8, &dihedralCopies<8>},
+        {12, &dihedralCopies<12>}, {16, &dihedralCopies<16>}, {24, &dihedralCopies<24>}
+    };
+
+    SymmetryEngine::DihedralKernel kernelFor(int slices) {
+        for(const KernelEntry & entry : Kernels)
+            if(entry.slices == slices)
+                return entry.kernel;
+        return nullptr;
+    }
+}
+
+SymmetryEngine::SymmetryEngine() {
+    rebuild();
+}
+
+void SymmetryEngine::setSettings(const SymmetrySettings & settings) {
+    _settings = settings;
+    rebuild();
+}
+
+const SymmetrySettings & SymmetryEngine::settings() const {
+    return _settings;
+}
+
+void SymmetryEngine::setCenter(QPointF center) {
+    _center = center;
+    rebuild();
+}
+
+void SymmetryEngine::setSlices(int slices) {
+    _slices = slices;
+    rebuild();
+}
+
+void SymmetryEngine::setMirror(bool mirror) {
+    _mirror = mirror;
+    rebuild();
+}
+
+void SymmetryEngine::setVisibleArea(const QRectF & visibleArea, qreal reach) {
+    // The culling only knows the center lines of the copies: the area grows by the pen reach so that the caps of a thick copy outside of it are kept
+    _visibleArea = visibleArea.isEmpty() ? visibleArea : visibleArea.adjusted(-reach, -reach, reach, reach);
+    _visibleLattice = _toLattice.mapRect(_visibleArea);
+}
+
+int SymmetryEngine::colorCount() const {
+    return _colorCount;
+}
+
+int SymmetryEngine::copyCount() const {
+    return _copies.size();
+}
+
+void SymmetryEngine::apply(const QLineF & line, QRgb color, const ColorEngine * colors, QVector<MandalaSegment> & segments) const {
+    // The copies are around the symmetry center: they all have the distance of the line to the center
+    double distance = QLineF(_center, (line.p1() + line.p2()) / 2).length();
+
+    if(_kernel) {
+        _kernel(line, _center, _mirror ? _mirrorMatrix : nullptr, color, colors, distance, segments);
+        return;
+    }
+
+    if(_settings.mode != SymmetrySettings::Wallpaper || _slices == 0) {
+        for(auto iter = _copies.begin(); iter != _copies.end(); ++iter)
+            segments.push_back({iter->transform.map(line), colors ? colors->color(iter->colorIndex, distance) : color});
+        return;
+    }
+
+    for(auto iter = _copies.begin(); iter != _copies.end(); ++iter) {
+        QLineF copy = iter->transform.map(line);
+        QRgb copyColor = colors ? colors->color(iter->colorIndex, distance) : color;
+        if(_visibleArea.isEmpty()) {
+            segments.push_back({copy, copyColor});
+            continue;
+        }
+
+        // We only go through the lattice translations that bring the copy into the visible area
+        QPointF cell = _toLattice.map((copy.p1() + copy.p2()) / 2);
+        int firstM = int(floor(_visibleLattice.left() - cell.x())), lastM = int(ceil(_visibleLattice.right() - cell.x()));
+        int firstN = int(floor(_visibleLattice.top() - cell.y())), lastN = int(ceil(_visibleLattice.bottom() - cell.y()));
+        for(int m=firstM; m<=lastM; ++m) {
+            for(int n=firstN; n<=lastN; ++n) {
+                QLineF tile = copy.translated(m * _latticeA + n * _latticeB);
+                if(_visibleArea.intersects(QRectF(tile.p1(), tile.p2()).normalized().adjusted(-1, -1, 1, 1)))
+                    segments.push_back({tile, copyColor});
+            }
+        }
+    }
+}
+
+QVector<SymmetryEngine::SymmetryCopy> SymmetryEngine::instances(const QRectF & bounds) const {
+    // The specialised kernels write the copies in the order of the transforms: a shape and its lines get the same copies
+    if(_settings.mode != SymmetrySettings::Wallpaper || _slices == 0 || _visibleArea.isEmpty())
+        return _copies;
+
+    QVector<SymmetryCopy> instances;
+    for(auto iter = _copies.begin(); iter != _copies.end(); ++iter) {
+        QRectF copy = iter->transform.mapRect(bounds);
+        QPointF cell = _toLattice.map(copy.center());
+        int firstM = int(floor(_visibleLattice.left() - cell.x())), lastM = int(ceil(_visibleLattice.right() - cell.x()));
+        int firstN = int(floor(_visibleLattice.top() - cell.y())), lastN = int(ceil(_visibleLattice.bottom() - cell.y()));
+        for(int m=firstM; m<=lastM; ++m) {
+            for(int n=firstN; n<=lastN; ++n) {
+                QPointF offset = m * _latticeA + n * _latticeB;
+                if(_visibleArea.intersects(copy.translated(offset).adjusted(-1, -1, 1, 1)))
+                    instances.push_back({iter->transform * QTransform::fromTranslate(offset.x(), offset.y()), iter->colorIndex});
+            }
+        }
+    }
+    return instances;
+}
+
+bool SymmetryEngine::seamlessTile(QRectF & tile) const {
+    if(_settings.mode != SymmetrySettings::Wallpaper || _slices == 0)
+        return false;
+
+    // The lattice vector a is horizontal: the tile is a wide, and k*b is vertical once we remove the whole a translations it holds
+    // (k = 1 for the rectangular and square lattices, 2 for the hexagonal lattice, 4 for the oblique lattice)
+    double bx = _latticeB.x() / _latticeA.x();
+    for(int k=1; k<=64; ++k) {
+        if(fabs(k*bx - qRound(k*bx)) < 1e-9) {
+            tile = QRectF(_center, QSizeF(_latticeA.x(), k * _latticeB.y()));
+            return true;
+        }
+    }
+    return false;
+}
+
+QString SymmetryEngine::wallpaperGroupName(SymmetrySettings::WallpaperGroup group) {
+    static const char * names[] = { "p1", "p2", "pm", "pg", "cm", "pmm", "pmg", "pgg", "cmm", "p4", "p4m", "p4g", "p3", "p3m1", "p31m", "p6", "p6m" };
+    return QString::fromLatin1(names[group]);
+}
+
+void SymmetryEngine::setKernelsEnabled(bool kernelsEnabled) {
+    _kernelsEnabled = kernelsEnabled;
+    rebuild();
+}
+
+bool SymmetryEngine::usesKernel() const {
+    return _kernel != nullptr;
+}
+
+QStringList SymmetryEngine::benchmarkKernels(int lineCount) {
+    // The same random lines for every run
+    SeededRandom random(42);
+    QVector<QLineF> lines;
+    lines.reserve(lineCount);
+    for(int i=0; i<lineCount; ++i)
+        lines.push_back(QLineF(random.uniform(0, 800), random.uniform(0, 800), random.uniform(0, 800), random.uniform(0, 800)));
+
+    QStringList report;
+    for(int mirror=0; mirror<2; ++mirror) {
+        for(const KernelEntry & entry : Kernels) {
+            SymmetryEngine engine;
+            engine.setCenter(QPointF(400, 400));
+            engine.setSlices(entry.slices);
+            engine.setMirror(mirror != 0);
+
+            // The best of a few runs of each path, in a batch that keeps its capacity
+            QVector<MandalaSegment> batches[2];
+            qint64 best[2] = { -1, -1 };
+            for(int run=0; run<5; ++run) {
+                for(int path=0; path<2; ++path) {
+                    engine.setKernelsEnabled(path == 1);
+                    batches[path].clear();
+                    batches[path].reserve(lineCount * engine.copyCount());
+                    QElapsedTimer timer;
+                    timer.start();
+                    for(auto iter = lines.begin(); iter != lines.end(); ++iter)
+                        engine.apply(*iter, 0xff000000, nullptr, batches[path]);
+                    qint64 elapsed = timer.nsecsElapsed();
+                    if(best[path] < 0 || elapsed < best[path])
+                        best[path] = elapsed;
+                }
+            }
+
+            double difference = (batches[0].size() == batches[1].size()) ? 0 : INFINITY;
+            for(int i=0; i<batches[0].size() && i<batches[1].size(); ++i) {
+                difference = qMax(difference, QLineF(batches[0][i].line.p1(), batches[1][i].line.p1()).length());
+                difference = qMax(difference, QLineF(batches[0][i].line.p2(), batches[1][i].line.p2()).length());
+            }
+
+            report << QString("D%1%2  generic %3 ns/line  specialised %4 ns/line  x%5  largest difference %6 px")
+                      .arg(entry.slices, -2).arg(mirror ? "+mirror" : "       ")
+                      .arg(double(best[0]) / lineCount, 7, 'f', 1).arg(double(best[1]) / lineCount, 7, 'f', 1)
+                      .arg(double(best[0]) / qMax(qint64(1), best[1]), 0, 'f', 2).arg(difference, 0, 'g', 3);
+        }
+    }
+    return report;
+}
+
+void SymmetryEngine::rebuild() {
+    _copies.clear();
+    _kernel = nullptr;
+
+    // In single mode the line is drawn alone, whatever the symmetry group
+    if(_slices == 0) {
+        _copies.push_back({QTransform(), 0});
+        _colorCount = 1;
+        return;
+    }
+
+    switch(_settings.mode) {
+    case SymmetrySettings::Dihedral: {
+        appendDihedral(QTransform());
+        _colorCount = qMax(1, _slices);
+        // The common slice counts have a kernel with exact rotations: the transforms are still kept for copyCount() and the benchmark
+        if(_kernelsEnabled)
+            _kernel = kernelFor(_slices);
+        QTransform mirror = QTransform().rotate(-_settings.mirrorAngle).scale(1, -1).rotate(_settings.mirrorAngle);
+        _mirrorMatrix[0] = mirror.m11();
+        _mirrorMatrix[1] = mirror.m12();
+        _mirrorMatrix[2] = mirror.m21();
+        _mirrorMatrix[3] = mirror.m22();
+        break;
+    }
+    case SymmetrySettings::Kaleidoscope:
+        // The dihedral group around the symmetry center, repeated around each center of the circle
+        appendDihedral(QTransform());
+        for(int k=0; k<_settings.kaleidoscopeCenters; ++k) {
+            double angle = 2*M_PI*k/_settings.kaleidoscopeCenters;
+            appendDihedral(QTransform::fromTranslate(_settings.kaleidoscopeRadius * cos(angle), _settings.kaleidoscopeRadius * sin(angle)));
+        }
+        _colorCount = qMax(1, _slices);
+        break;
+    case SymmetrySettings::Wallpaper:
+        appendWallpaper();
+        _colorCount = qMax(1, _copies.size());
+        break;
+    }
+}
+
+void SymmetryEngine::appendDihedral(const QTransform & placement) {
+    // The order of the copies is the one of the mandala mode: the line, its mirror, then each rotation followed by its mirror
+    QTransform mirror = QTransform().translate(_center.x(), _center.y()).rotate(-_settings.mirrorAngle).scale(1, -1).rotate(_settings.mirrorAngle).translate(-_center.x(), -_center.y());
+
+    _copies.push_back({placement, 0});
+    if(_slices == 0)
+        return;
+
+    if(_mirror)
+        _copies.push_back({mirror * placement, 0});
+    for(int i=1; i<_slices; ++i) {
+        QTransform rotation = QTransform().translate(_center.x(), _center.y()).rotate(i*360.0/_slices).translate(-_center.x(), -_center.y());
+        _copies.push_back({rotation * placement, i});
+        if(_mirror)
+            _copies.push_back({rotation * mirror * placement, i});
+    }
+}
+
+void SymmetryEngine::appendWallpaper() {
+    QPointF a, b;
+    QVector<LatticeOperation> operations = wallpaperOperations(_settings.wallpaperGroup, a, b);
+    _latticeA = a * _settings.cellSize;
+    _latticeB = b * _settings.cellSize;
+
+    // The lattice origin is the symmetry center: the scene transform of an operation is scene -> lattice -> operation -> scene
+    QTransform fromLattice(_latticeA.x(), _latticeA.y(), _latticeB.x(), _latticeB.y(), _center.x(), _center.y());
+    _toLattice = fromLattice.inverted();
+    _visibleLattice = _toLattice.mapRect(_visibleArea);
+
+    for(int i=0; i<operations.size(); ++i) {
+        const LatticeOperation & o = operations[i];
+        QTransform operation(o.a, o.c, o.b, o.d, o.tx, o.ty);
+        _copies.push_back({_toLattice * operation * fromLattice, i});
+    }
+}
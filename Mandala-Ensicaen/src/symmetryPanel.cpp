@@ -0,0 +1,94 @@
+/**
+ * @file   symmetryPanel.cpp
+ * @date   October 2026
+ *
+ * @brief  symmetryPanel is the dock panel that let the user choose the symmetry group of the mandala mode (dihedral, wallpaper or kaleidoscope) and its settings
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "symmetryPanel.h"
+#include <QComboBox>
+#include <QFormLayout>
+#include <QSignalBlocker>
+#include <QSpinBox>
+
+SymmetryPanel::SymmetryPanel(QWidget *parent) : QDockWidget(tr("Symmetry"), parent) {
+    setObjectName("symmetryPanel");
+
+    QWidget * content = new QWidget(this);
+    QFormLayout * layout = new QFormLayout(content);
+    SymmetrySettings defaults;
+
+    // The items order follows SymmetrySettings::Mode
+    _modeComboBox = new QComboBox(content);
+    _modeComboBox->addItem(tr("Rotations and mirror"));
+    _modeComboBox->addItem(tr("Wallpaper tiles"));
+    _modeComboBox->addItem(tr("Kaleidoscope"));
+    layout->addRow(tr("Symmetry"), _modeComboBox);
+
+    _mirrorAngleSpinBox = new QSpinBox(content);
+    _mirrorAngleSpinBox->setRange(0, 179);
+    _mirrorAngleSpinBox->setSuffix(QString::fromUtf8("°"));
+    _mirrorAngleSpinBox->setValue(int(defaults.mirrorAngle));
+    layout->addRow(tr("Mirror axis"), _mirrorAngleSpinBox);
+
+    // The items order follows SymmetrySettings::WallpaperGroup
+    _wallpaperGroupComboBox = new QComboBox(content);
+    for(int i=SymmetrySettings::P1; i<=SymmetrySettings::P6M; ++i)
+        _wallpaperGroupComboBox->addItem(SymmetryEngine::wallpaperGroupName(SymmetrySettings::WallpaperGroup(i)));
+    _wallpaperGroupComboBox->setCurrentIndex(defaults.wallpaperGroup);
+    layout->addRow(tr("Wallpaper group"), _wallpaperGroupComboBox);
+
+    _cellSizeSpinBox = new QSpinBox(content);
+    _cellSizeSpinBox->setRange(16, 2000);
+    _cellSizeSpinBox->setValue(int(defaults.cellSize));
+    layout->addRow(tr("Tile size"), _cellSizeSpinBox);
+
+    _centersSpinBox = new QSpinBox(content);
+    _centersSpinBox->setRange(1, 24);
+    _centersSpinBox->setValue(defaults.kaleidoscopeCenters);
+    layout->addRow(tr("Kaleidoscope centers"), _centersSpinBox);
+
+    _radiusSpinBox = new QSpinBox(content);
+    _radiusSpinBox->setRange(10, 5000);
+    _radiusSpinBox->setValue(int(defaults.kaleidoscopeRadius));
+    layout->addRow(tr("Kaleidoscope radius"), _radiusSpinBox);
+
+    setWidget(content);
+
+    connect(_modeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(emitSymmetryChanged()));
+    connect(_mirrorAngleSpinBox, SIGNAL(valueChanged(int)), this, SLOT(emitSymmetryChanged()));
+    connect(_wallpaperGroupComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(emitSymmetryChanged()));
+    connect(_cellSizeSpinBox, SIGNAL(valueChanged(int)), this, SLOT(emitSymmetryChanged()));
+    connect(_centersSpinBox, SIGNAL(valueChanged(int)), this, SLOT(emitSymmetryChanged()));
+    connect(_radiusSpinBox, SIGNAL(valueChanged(int)), this, SLOT(emitSymmetryChanged()));
+}
+
+SymmetrySettings SymmetryPanel::settings() const {
+    SymmetrySettings settings;
+    settings.mode = SymmetrySettings::Mode(_modeComboBox->currentIndex());
+    settings.mirrorAngle = _mirrorAngleSpinBox->value();
+    settings.wallpaperGroup = SymmetrySettings::WallpaperGroup(_wallpaperGroupComboBox->currentIndex());
+    settings.cellSize = _cellSizeSpinBox->value();
+    settings.kaleidoscopeCenters = _centersSpinBox->value();
+    settings.kaleidoscopeRadius = _radiusSpinBox->value();
+    return settings;
+}
+
+void SymmetryPanel::setSettings(const SymmetrySettings & settings) {
+    QSignalBlocker modeBlocker(_modeComboBox), mirrorAngleBlocker(_mirrorAngleSpinBox), wallpaperGroupBlocker(_wallpaperGroupComboBox);
+    QSignalBlocker cellSizeBlocker(_cellSizeSpinBox), centersBlocker(_centersSpinBox), radiusBlocker(_radiusSpinBox);
+    _modeComboBox->setCurrentIndex(settings.mode);
+    _mirrorAngleSpinBox->setValue(int(settings.mirrorAngle));
+    _wallpaperGroupComboBox->setCurrentIndex(settings.wallpaperGroup);
+    _cellSizeSpinBox->setValue(int(settings.cellSize));
+    _centersSpinBox->setValue(settings.kaleidoscopeCenters);
+    _radiusSpinBox->setValue(int(settings.kaleidoscopeRadius));
+}
+
+void SymmetryPanel::emitSymmetryChanged() {
+    emit symmetryChanged(settings());
+}
@@ -0,0 +1,211 @@
+/**
+ * @file   thumbnailModel.cpp
+ * @date   October 2026
+ *
+ * @brief  thumbnailModel is the list model of the images of a directory: the thumbnails are decoded on a thread pool (only the rows the view asks for),
+ * cached in memory and on the disk (the disk cache is keyed by the image path and its last modification time)
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "thumbnailModel.h"
+#include "memoryBudget.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <functional>
+
+namespace {
+    // ThumbnailWorker runs a function on the thread pool
+    class ThumbnailWorker : public QRunnable
+    {
+    public:
+        explicit ThumbnailWorker(const std::function<void()> & work) : _work(work) {
+        }
+
+        void run() override {
+            _work();
+        }
+
+    private:
+        std::function<void()> _work;
+    };
+}
+
+ThumbnailModel::ThumbnailModel(QObject *parent) : QAbstractListModel(parent) {
+    // 64 MB of thumbnails in memory, the others are reloaded from the disk cache
+    _thumbnails.setMaxCost(64 * 1024);
+
+    // The thumbnails are reloaded from the disk cache when the view asks for them again
+    _memoryConsumer = MemoryBudget::instance()->addConsumer(tr("Thumbnails"), MemoryBudget::Caches,
+                                                            [this]() { return qint64(_thumbnails.totalCost()) * 1024; },
+                                                            [this](qint64) {
+                                                                qint64 bytes = qint64(_thumbnails.totalCost()) * 1024;
+                                                                _thumbnails.clear();
+                                                                return bytes;
+                                                            });
+}
+
+ThumbnailModel::~ThumbnailModel() {
+    MemoryBudget::instance()->removeConsumer(_memoryConsumer);
+    {
+        QMutexLocker locker(&_pendingMutex);
+        _pendingRequests.clear();
+    }
+    _threadPool.waitForDone();
+}
+
+void ThumbnailModel::setDirectory(const QString & directory) {
+    beginResetModel();
+
+    ++_generation;
+    _directory = directory;
+    _entries.clear();
+    _thumbnails.clear();
+    _requested.clear();
+    {
+        QMutexLocker locker(&_pendingMutex);
+        _pendingRequests.clear();
+    }
+
+    if(directory.isEmpty()) {
+        endResetModel();
+        return;
+    }
+
+    // Listing the directory only reads the file names and times, no image is opened here
+    QFileInfoList files = QDir(directory).entryInfoList(QStringList() << "*.png" << "*.jpg" << "*.jpeg" << "*.bmp",
+                                                        QDir::Files | QDir::Readable, QDir::Name | QDir::IgnoreCase);
+    _entries.reserve(files.size());
+    for(auto iter = files.begin(); iter != files.end(); ++iter)
+        _entries.push_back({iter->absoluteFilePath(), iter->fileName(), iter->lastModified()});
+
+    endResetModel();
+}
+
+QString ThumbnailModel::directory() const {
+    return _directory;
+}
+
+void ThumbnailModel::setThumbnailSize(QSize thumbnailSize) {
+    _thumbnailSize = thumbnailSize;
+    setDirectory(_directory);
+}
+
+int ThumbnailModel::rowCount(const QModelIndex & parent) const {
+    return parent.isValid() ? 0 : _entries.size();
+}
+
+QVariant ThumbnailModel::data(const QModelIndex & index, int role) const {
+    if(!index.isValid() || index.row() >= _entries.size())
+        return QVariant();
+
+    const Entry & entry = _entries[index.row()];
+    switch(role) {
+    case Qt::DisplayRole:
+        return entry.name;
+    case Qt::ToolTipRole:
+    case PathRole:
+        return entry.path;
+    case Qt::DecorationRole: {
+        // The view only asks for the rows on screen: this is where the loading of a thumbnail starts
+        QPixmap * thumbnail = _thumbnails.object(index.row());
+        if(thumbnail)
+            return *thumbnail;
+        requestThumbnail(index.row());
+        return QVariant();
+    }
+    default:
+        return QVariant();
+    }
+}
+
+void ThumbnailModel::requestThumbnail(int row) const {
+    if(_requested.contains(row))
+        return;
+    _requested.insert(row);
+
+    const Entry & entry = _entries[row];
+    QMutexLocker locker(&_pendingMutex);
+    _pendingRequests.push_back({_generation, row, entry.path, entry.lastModified, _thumbnailSize});
+    if(_activeWorkers < _threadPool.maxThreadCount()) {
+        ++_activeWorkers;
+        ThumbnailModel * model = const_cast<ThumbnailModel *>(this);
+        model->_threadPool.start(new ThumbnailWorker([model]() { model->runWorker(); }));
+    }
+}
+
+void ThumbnailModel::runWorker() {
+    forever {
+        Request request;
+        {
+            QMutexLocker locker(&_pendingMutex);
+            if(_pendingRequests.isEmpty()) {
+                --_activeWorkers;
+                return;
+            }
+            request = _pendingRequests.takeLast();
+        }
+
+        QImage thumbnail = loadThumbnail(request.path, request.lastModified, request.size);
+        QMetaObject::invokeMethod(this, "thumbnailLoaded", Qt::QueuedConnection,
+                                  Q_ARG(int, request.generation), Q_ARG(int, request.row), Q_ARG(QImage, thumbnail));
+    }
+}
+
+void ThumbnailModel::thumbnailLoaded(int generation, int row, QImage thumbnail) {
+    // The thumbnail of a directory we don't show anymore
+    if(generation != _generation)
+        return;
+
+    _requested.remove(row);
+    // An image we can't decode gets an empty thumbnail, so that we don't try again
+    QPixmap * pixmap = new QPixmap(QPixmap::fromImage(thumbnail));
+    int cost = qMax(1, thumbnail.byteCount() / 1024);
+    _thumbnails.insert(row, pixmap, cost);
+    MemoryBudget::instance()->requestEnforce();
+
+    QModelIndex changed = index(row);
+    emit dataChanged(changed, changed, QVector<int>() << Qt::DecorationRole);
+}
+
+QString ThumbnailModel::cachePath(const QString & path, const QDateTime & lastModified, QSize size) {
+    QByteArray key = QString("%1|%2|%3x%4").arg(path).arg(lastModified.toMSecsSinceEpoch()).arg(size.width()).arg(size.height()).toUtf8();
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
+    return directory + "/" + QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex()) + ".png";
+}
+
+QImage ThumbnailModel::loadThumbnail(const QString & path, const QDateTime & lastModified, QSize size) {
+    QString cacheFile = cachePath(path, lastModified, size);
+    if(QFileInfo::exists(cacheFile)) {
+        QImage thumbnail(cacheFile);
+        if(!thumbnail.isNull())
+            return thumbnail;
+    }
+
+    // The reader decodes the image directly at the thumbnail size (JPEG decoders skip most of the work), we never decode the full image
+    QImageReader reader(path);
+    QSize imageSize = reader.size();
+    if(imageSize.isValid())
+        reader.setScaledSize(imageSize.scaled(size, Qt::KeepAspectRatio));
+    QImage thumbnail = reader.read();
+    if(thumbnail.isNull())
+        return thumbnail;
+    if(thumbnail.width() > size.width() || thumbnail.height() > size.height())
+        thumbnail = thumbnail.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    // QSaveFile writes a temporary file and renames it: another run never reads a half written thumbnail
+    QDir().mkpath(QFileInfo(cacheFile).path());
+    QSaveFile file(cacheFile);
+    if(file.open(QIODevice::WriteOnly) && thumbnail.save(&file, "PNG"))
+        file.commit();
+
+    return thumbnail;
+}
@@ -0,0 +1,238 @@
+/**
+ * @file   tileExporter.cpp
+ * @date   October 2026
+ *
+ * @brief  tileExporter exports a seamless tile of a wallpaper mandala with its mip-mapped downscales (box or Lanczos filtered pyramid, computed on all the CPU cores),
+ * as separate images or packed in an atlas, with a JSON manifest. It never touches the widgets: it runs on a worker thread
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "tileExporter.h"
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPainter>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentMap>
+#include <functional>
+#include <math.h>
+
+namespace {
+    // The rows of a level are computed by bands of BandHeight rows: a band is the work of one worker
+    const int BandHeight = 16;
+
+    // A Lanczos-3 kernel halving an image has 12 taps: the destination pixel x covers the source pixels 2x-5 to 2x+6
+    const int LanczosTaps = 12;
+
+    double lanczos3(double x) {
+        if(x == 0)
+            return 1;
+        if(fabs(x) >= 3)
+            return 0;
+        double px = M_PI * x;
+        return 3 * sin(px) * sin(px / 3) / (px * px);
+    }
+
+    QVector<float> lanczosWeights() {
+        QVector<float> weights(LanczosTaps);
+        double sum = 0;
+        for(int t=0; t<LanczosTaps; ++t) {
+            // Distance between the source pixel center and the destination pixel center, in destination pixels
+            double distance = (t - 5 - 0.5) / 2;
+            weights[t] = float(lanczos3(distance));
+            sum += weights[t];
+        }
+        for(int t=0; t<LanczosTaps; ++t)
+            weights[t] = float(weights[t] / sum);
+        return weights;
+    }
+
+    inline int wrap(int i, int size) {
+        i %= size;
+        return (i < 0) ? i + size : i;
+    }
+
+    inline uchar clampChannel(float value, float maximum) {
+        return uchar(qBound(0.0f, value + 0.5f, maximum));
+    }
+
+    // Run a function on the bands of rows [0, rows)
+    void forEachBand(int rows, const std::function<void(int, int)> & work) {
+        QVector<QPair<int, int>> bands;
+        for(int y=0; y<rows; y+=BandHeight)
+            bands.push_back(qMakePair(y, qMin(rows, y + BandHeight)));
+        QtConcurrent::blockingMap(bands, [&work](const QPair<int, int> & band) { work(band.first, band.second); });
+    }
+}
+
+QImage TileExporter::halve(const QImage & source, TileExportSettings::Filter filter) {
+    int width = qMax(1, source.width() / 2);
+    int height = qMax(1, source.height() / 2);
+    QImage destination(width, height, QImage::Format_ARGB32_Premultiplied);
+
+    if(filter == TileExportSettings::Box) {
+        // The average of 2x2 source pixels (the premultiplied channels can be averaged directly)
+        forEachBand(height, [&](int first, int last) {
+            for(int y=first; y<last; ++y) {
+                const QRgb * row0 = reinterpret_cast<const QRgb *>(source.constScanLine(wrap(2*y, source.height())));
+                const QRgb * row1 = reinterpret_cast<const QRgb *>(source.constScanLine(wrap(2*y + 1, source.height())));
+                QRgb * out = reinterpret_cast<QRgb *>(destination.scanLine(y));
+                for(int x=0; x<width; ++x) {
+                    int x0 = wrap(2*x, source.width()), x1 = wrap(2*x + 1, source.width());
+                    QRgb p[4] = { row0[x0], row0[x1], row1[x0], row1[x1] };
+                    int a = 0, r = 0, g = 0, b = 0;
+                    for(int i=0; i<4; ++i) {
+                        a += qAlpha(p[i]);
+                        r += qRed(p[i]);
+                        g += qGreen(p[i]);
+                        b += qBlue(p[i]);
+                    }
+                    out[x] = qRgba((r + 2) / 4, (g + 2) / 4, (b + 2) / 4, (a + 2) / 4);
+                }
+            }
+        });
+        return destination;
+    }
+
+    // Lanczos-3 is separable: a horizontal pass halves the width of every source row, then a vertical pass halves the height.
+    // The taps wrap around the borders, so a seamless tile stays seamless
+    QVector<float> weights = lanczosWeights();
+    QVector<float> horizontal(source.height() * width * 4);
+
+    forEachBand(source.height(), [&](int first, int last) {
+        for(int y=first; y<last; ++y) {
+            const QRgb * in = reinterpret_cast<const QRgb *>(source.constScanLine(y));
+            float * out = horizontal.data() + y * width * 4;
+            for(int x=0; x<width; ++x) {
+                float a = 0, r = 0, g = 0, b = 0;
+                for(int t=0; t<LanczosTaps; ++t) {
+                    QRgb p = in[wrap(2*x - 5 + t, source.width())];
+                    a += weights[t] * qAlpha(p);
+                    r += weights[t] * qRed(p);
+                    g += weights[t] * qGreen(p);
+                    b += weights[t] * qBlue(p);
+                }
+                out[4*x] = a;
+                out[4*x + 1] = r;
+                out[4*x + 2] = g;
+                out[4*x + 3] = b;
+            }
+        }
+    });
+
+    forEachBand(height, [&](int first, int last) {
+        for(int y=first; y<last; ++y) {
+            QRgb * out = reinterpret_cast<QRgb *>(destination.scanLine(y));
+            for(int x=0; x<width; ++x) {
+                float a = 0, r = 0, g = 0, b = 0;
+                for(int t=0; t<LanczosTaps; ++t) {
+                    const float * p = horizontal.constData() + (wrap(2*y - 5 + t, source.height()) * width + x) * 4;
+                    a += weights[t] * p[0];
+                    r += weights[t] * p[1];
+                    g += weights[t] * p[2];
+                    b += weights[t] * p[3];
+                }
+                // Lanczos rings: the color channels are clamped to the alpha to stay valid premultiplied colors
+                uchar alpha = clampChannel(a, 255);
+                out[x] = qRgba(clampChannel(r, alpha), clampChannel(g, alpha), clampChannel(b, alpha), alpha);
+            }
+        }
+    });
+    return destination;
+}
+
+QVector<QImage> TileExporter::mipPyramid(const QImage & tile, TileExportSettings::Filter filter, int levels) {
+    QVector<QImage> pyramid;
+    pyramid.push_back(tile.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+    while((levels <= 0 || pyramid.size() < levels) && (pyramid.last().width() > 1 || pyramid.last().height() > 1))
+        pyramid.push_back(halve(pyramid.last(), filter));
+    return pyramid;
+}
+
+QImage TileExporter::packAtlas(const QVector<QImage> & pyramid, QVector<QRect> & placements) {
+    placements.clear();
+    if(pyramid.isEmpty())
+        return QImage();
+
+    // The level 0 on the left, the next levels stacked in a column on its right
+    QSize base = pyramid.first().size();
+    int columnWidth = (pyramid.size() > 1) ? pyramid[1].width() : 0;
+    int columnHeight = 0;
+    for(int i=1; i<pyramid.size(); ++i)
+        columnHeight += pyramid[i].height();
+
+    QImage atlas(base.width() + columnWidth, qMax(base.height(), columnHeight), QImage::Format_ARGB32_Premultiplied);
+    atlas.fill(Qt::transparent);
+    QPainter painter(&atlas);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+
+    placements.push_back(QRect(QPoint(0, 0), base));
+    int y = 0;
+    for(int i=1; i<pyramid.size(); ++i) {
+        placements.push_back(QRect(QPoint(base.width(), y), pyramid[i].size()));
+        y += pyramid[i].height();
+    }
+    for(int i=0; i<pyramid.size(); ++i)
+        painter.drawImage(placements[i].topLeft(), pyramid[i]);
+    return atlas;
+}
+
+QString TileExporter::exportTile(const QImage & tile, const TileExportSettings & settings, const QString & fileName, const QJsonObject & description) {
+    QVector<QImage> pyramid = mipPyramid(tile, settings.filter, settings.levels);
+    QFileInfo info(fileName);
+    QString baseName = info.path() + "/" + info.completeBaseName();
+
+    QJsonObject manifest = description;
+    manifest["filter"] = (settings.filter == TileExportSettings::Box) ? "box" : "lanczos3";
+    manifest["seamless"] = true;
+    QJsonArray levels;
+
+    if(settings.atlas) {
+        QVector<QRect> placements;
+        QImage atlas = packAtlas(pyramid, placements);
+        QString atlasName = baseName + ".png";
+        if(!atlas.save(atlasName, "PNG"))
+            return QString("Can't write %1").arg(atlasName);
+        manifest["image"] = QFileInfo(atlasName).fileName();
+        for(int i=0; i<placements.size(); ++i) {
+            QJsonObject level;
+            level["level"] = i;
+            level["x"] = placements[i].x();
+            level["y"] = placements[i].y();
+            level["width"] = placements[i].width();
+            level["height"] = placements[i].height();
+            levels.append(level);
+        }
+    } else {
+        // The levels are encoded on all the CPU cores
+        QVector<int> indexes;
+        for(int i=0; i<pyramid.size(); ++i)
+            indexes.push_back(i);
+        QVector<bool> saved(pyramid.size(), false);
+        QtConcurrent::blockingMap(indexes, [&](int i) {
+            saved[i] = pyramid[i].save(QString("%1_mip%2.png").arg(baseName).arg(i), "PNG");
+        });
+        for(int i=0; i<pyramid.size(); ++i) {
+            if(!saved[i])
+                return QString("Can't write %1_mip%2.png").arg(baseName).arg(i);
+            QJsonObject level;
+            level["level"] = i;
+            level["file"] = QFileInfo(QString("%1_mip%2.png").arg(baseName).arg(i)).fileName();
+            level["width"] = pyramid[i].width();
+            level["height"] = pyramid[i].height();
+            levels.append(level);
+        }
+    }
+    manifest["levels"] = levels;
+
+    QSaveFile manifestFile(baseName + ".json");
+    if(!manifestFile.open(QIODevice::WriteOnly))
+        return QString("Can't write %1.json").arg(baseName);
+    manifestFile.write(QJsonDocument(manifest).toJson());
+    if(!manifestFile.commit())
+        return QString("Can't write %1.json").arg(baseName);
+    return QString();
+}
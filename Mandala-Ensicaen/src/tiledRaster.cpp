@@ -0,0 +1,149 @@
+/**
+ * @file   tiledRaster.cpp
+ * @date   October 2026
+ *
+ * @brief  tiledRaster is a sparse raster image made of fixed size square tiles: a tile is only allocated once something is painted on it
+ *
+ * @author agent <agent@local>
+ *
+ * @copyright Copyright 2026 agent
+ */
+
+#include "tiledRaster.h"
+#include <QPainter>
+#include <math.h>
+
+const int TiledRaster::TileSize;
+
+TiledRaster::TiledRaster() {
+}
+
+quint64 TiledRaster::tileKey(const QPoint & tile) {
+    return (quint64(quint32(tile.x())) << 32) | quint64(quint32(tile.y()));
+}
+
+void TiledRaster::setScale(qreal scale) {
+    if(scale == _scale)
+        return;
+
+    QHash<quint64, QImage> previous = _tiles;
+    qreal previousScale = _scale;
+    quint64 previousGeneration = _generation;
+
+    _scale = scale;
+    if(_previousScale == scale && _previousGeneration == _generation) {
+        // Nothing was painted since we left this resolution (a window moved to another screen and back)
+        _tiles = _previousTiles;
+    } else {
+        int side = tileSide();
+        for(auto iter = _tiles.begin(); iter != _tiles.end(); ++iter) {
+            QImage image = iter.value().scaled(side, side, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            image.setDevicePixelRatio(scale);
+            iter.value() = image;
+        }
+    }
+
+    _previousTiles = previous;
+    _previousScale = previousScale;
+    _previousGeneration = previousGeneration;
+}
+
+qreal TiledRaster::scale() const {
+    return _scale;
+}
+
+int TiledRaster::tileSide() const {
+    return qRound(TileSize * _scale);
+}
+
+QImage & TiledRaster::tile(const QPoint & tile) {
+    // The tile is given to be painted on
+    ++_generation;
+    QHash<quint64, QImage>::iterator iter = _tiles.find(tileKey(tile));
+    if(iter == _tiles.end()) {
+        // The painters work in scene pixels on it: the device pixel ratio scales them to the tile resolution
+        QImage image(tileSide(), tileSide(), QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(_scale);
+        image.fill(Qt::transparent);
+        iter = _tiles.insert(tileKey(tile), image);
+    }
+    return iter.value();
+}
+
+bool TiledRaster::hasTile(const QPoint & tile) const {
+    return _tiles.contains(tileKey(tile));
+}
+
+QRect TiledRaster::tileRange(const QRectF & rect) {
+    // floor() keeps negative scene coordinates in the right tile
+    int left = int(floor(rect.left() / TileSize));
+    int top = int(floor(rect.top() / TileSize));
+    int right = int(floor(rect.right() / TileSize));
+    int bottom = int(floor(rect.bottom() / TileSize));
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+QRect TiledRaster::tileRect(const QPoint & tile) {
+    return QRect(tile.x() * TileSize, tile.y() * TileSize, TileSize, TileSize);
+}
+
+void TiledRaster::paint(QPainter * painter, const QRectF & exposed) const {
+    if(_tiles.isEmpty())
+        return;
+
+    QRect range = tileRange(exposed);
+    for(int y=range.top(); y<=range.bottom(); ++y) {
+        for(int x=range.left(); x<=range.right(); ++x) {
+            QHash<quint64, QImage>::const_iterator iter = _tiles.constFind(tileKey(QPoint(x, y)));
+            if(iter != _tiles.constEnd()) {
+                // We only paint the part of the tile that is exposed: when the view is zoomed, the cost depends on what is on screen
+                QRect rect = tileRect(QPoint(x, y));
+                QRectF target = QRectF(rect) & exposed;
+                if(!target.isEmpty()) {
+                    // The source rectangle is in device pixels of the tile
+                    QRectF source = target.translated(-rect.topLeft());
+                    painter->drawImage(target, iter.value(), QRectF(source.topLeft() * _scale, source.size() * _scale));
+                }
+            }
+        }
+    }
+}
+
+void TiledRaster::render(const QRectF & bounds, const std::function<void(QPainter *)> & draw) {
+    QRect range = tileRange(bounds);
+    for(int y=range.top(); y<=range.bottom(); ++y) {
+        for(int x=range.left(); x<=range.right(); ++x) {
+            QPainter painter(&tile(QPoint(x, y)));
+            painter.translate(-tileRect(QPoint(x, y)).topLeft());
+            draw(&painter);
+        }
+    }
+}
+
+void TiledRaster::drawImage(const QPointF & position, const QImage & image) {
+    render(QRectF(position, image.size()), [&position, &image](QPainter * painter) {
+        painter->drawImage(position, image);
+    });
+}
+
+void TiledRaster::clear() {
+    ++_generation;
+    _tiles.clear();
+    _previousTiles.clear();
+}
+
+void TiledRaster::eraseTiles() {
+    ++_generation;
+    _previousTiles.clear();
+    for(auto iter = _tiles.begin(); iter != _tiles.end(); ++iter)
+        iter.value().fill(Qt::transparent);
+}
+
+bool TiledRaster::isEmpty() const {
+    return _tiles.isEmpty();
+}
+
+qint64 TiledRaster::byteCount() const {
+    int previousSide = qRound(TileSize * _previousScale);
+    return qint64(_tiles.size()) * tileSide() * tileSide() * 4 + qint64(_previousTiles.size()) * previousSide * previousSide * 4;
+}
@@ -15,11 +15,12 @@
 
 WidgetDrawLineWidth::WidgetDrawLineWidth(QWidget *parent) : QWidget(parent)
 {
+    // The style sheet is set once: setting it while painting polishes the widget again and schedules another paint
+    this->setStyleSheet("background-color:white;");
 }
 
 void WidgetDrawLineWidth::paintEvent(QPaintEvent *){
     QPainter painter(this);
-    this->setStyleSheet("background-color:white;");
 
     QPen pen;
     pen.setStyle(Qt::SolidLine);
@@ -33,9 +34,15 @@ void WidgetDrawLineWidth::paintEvent(QPaintEvent *){
 }
 
 void WidgetDrawLineWidth::setPenSize(int penSize){
+    if(penSize == _penSize)
+        return;
     _penSize = penSize;
+    update();
 }
 
 void WidgetDrawLineWidth::setPenColor(QColor penColor){
+    if(penColor == _penColor)
+        return;
     _penColor = penColor;
+    update();
 }